@@ -14,7 +14,9 @@ struct QuickSQLiteBridge : jni::JavaClass<QuickSQLiteBridge> {
     javaClassStatic()->registerNatives(
         {// initialization for JSI
          makeNativeMethod("installNativeJsi",
-                          QuickSQLiteBridge::installNativeJsi)});
+                          QuickSQLiteBridge::installNativeJsi),
+         makeNativeMethod("handleMemoryPressureNative",
+                          QuickSQLiteBridge::handleMemoryPressureNative)});
   }
 
 private:
@@ -28,6 +30,11 @@ private:
 
     osp::install(*jsiRuntime, jsCallInvoker, docPathString.c_str());
   }
+
+  static void handleMemoryPressureNative(jni::alias_ref<jni::JObject> thiz,
+                                         jboolean isCritical) {
+    osp::handleMemoryPressure(isCritical);
+  }
 };
 
 JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *) {
@@ -8,6 +8,7 @@ import com.facebook.react.turbomodule.core.CallInvokerHolderImpl;
 
 public class QuickSQLiteBridge {
   private native void installNativeJsi(long jsContextNativePointer, CallInvokerHolderImpl jsCallInvokerHolder, String docPath);
+  private native void handleMemoryPressureNative(boolean isCritical);
   public static final QuickSQLiteBridge instance = new QuickSQLiteBridge();
 
   public void install(ReactContext context) {
@@ -21,4 +22,11 @@ public class QuickSQLiteBridge {
         path
       );
   }
+
+  /**
+   * Shrinks the SQLite caches of the open databases, critical pressure also applies the critical heap limit
+   */
+  public void handleMemoryPressure(boolean isCritical) {
+    handleMemoryPressureNative(isCritical);
+  }
 }
\ No newline at end of file
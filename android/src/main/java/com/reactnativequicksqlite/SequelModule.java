@@ -1,6 +1,8 @@
 package com.reactnativequicksqlite;
 
 import androidx.annotation.NonNull;
+import android.content.ComponentCallbacks2;
+import android.content.res.Configuration;
 import android.util.Log;
 
 import com.facebook.jni.HybridData;
@@ -12,7 +14,29 @@ import com.facebook.react.turbomodule.core.CallInvokerHolderImpl;
 
 class SequelModule extends ReactContextBaseJavaModule {
   public static final String NAME = "QuickSQLite";
-  
+
+  // Lets SQLite give back its page cache instead of the app being killed
+  private final ComponentCallbacks2 memoryCallbacks = new ComponentCallbacks2() {
+    @Override
+    public void onTrimMemory(int level) {
+      if (level == TRIM_MEMORY_UI_HIDDEN || level < TRIM_MEMORY_RUNNING_LOW) {
+        return;
+      }
+      boolean isCritical = level == TRIM_MEMORY_RUNNING_CRITICAL || level >= TRIM_MEMORY_COMPLETE;
+      QuickSQLiteBridge.instance.handleMemoryPressure(isCritical);
+    }
+
+    @Override
+    public void onLowMemory() {
+      QuickSQLiteBridge.instance.handleMemoryPressure(true);
+    }
+
+    @Override
+    public void onConfigurationChanged(@NonNull Configuration configuration) {
+    }
+  };
+  private boolean isObservingMemory = false;
+
   public SequelModule(ReactApplicationContext context) {
     super(context);
   }
@@ -28,10 +52,23 @@ class SequelModule extends ReactContextBaseJavaModule {
     try {
       System.loadLibrary("react-native-quick-sqlite");
       QuickSQLiteBridge.instance.install(getReactApplicationContext());
+      if (!isObservingMemory) {
+        getReactApplicationContext().getApplicationContext().registerComponentCallbacks(memoryCallbacks);
+        isObservingMemory = true;
+      }
       return true;
     } catch (Exception exception) {
       Log.e(NAME, "Failed to install JSI Bindings!", exception);
       return false;
     }
   }
+
+  @Override
+  public void invalidate() {
+    if (isObservingMemory) {
+      getReactApplicationContext().getApplicationContext().unregisterComponentCallbacks(memoryCallbacks);
+      isObservingMemory = false;
+    }
+    super.invalidate();
+  }
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+//
+//  BenchmarkReport.cpp
+//  react-native-quick-sqlite
+//
+
+#include "BenchmarkReport.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <sstream>
+#include <sqlite3.h>
+
+using namespace std;
+
+#ifndef QUICK_SQLITE_VERSION
+#define QUICK_SQLITE_VERSION "unknown"
+#endif
+
+struct BenchmarkSummary
+{
+  double totalMs = 0;
+  double meanMs = 0;
+  double minMs = 0;
+  double p50Ms = 0;
+  double p95Ms = 0;
+  double maxMs = 0;
+};
+
+/**
+ * Nearest-rank percentile of sorted samples
+ */
+double percentile(vector<double> const &sorted, double fraction)
+{
+  if (sorted.empty())
+  {
+    return 0;
+  }
+  size_t rank = (size_t)ceil(fraction * sorted.size());
+  return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+BenchmarkSummary summarize(vector<double> samples)
+{
+  BenchmarkSummary summary;
+  if (samples.empty())
+  {
+    return summary;
+  }
+
+  sort(samples.begin(), samples.end());
+  for (double sample : samples)
+  {
+    summary.totalMs += sample;
+  }
+  summary.meanMs = summary.totalMs / samples.size();
+  summary.minMs = samples.front();
+  summary.p50Ms = percentile(samples, 0.5);
+  summary.p95Ms = percentile(samples, 0.95);
+  summary.maxMs = samples.back();
+  return summary;
+}
+
+string escapeJson(string const &value)
+{
+  string escaped;
+  for (char c : value)
+  {
+    if (c == '"' || c == '\\')
+    {
+      escaped += '\\';
+      escaped += c;
+    }
+    else if ((unsigned char)c < 0x20)
+    {
+      char code[7];
+      snprintf(code, sizeof(code), "\\u%04x", (unsigned char)c);
+      escaped += code;
+    }
+    else
+    {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+string currentTimestamp()
+{
+  time_t now = time(nullptr);
+  char timestamp[32];
+  strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+  return timestamp;
+}
+
+BenchmarkReport::BenchmarkReport(string platform, string filter) : platform(platform), filter(filter)
+{
+}
+
+bool BenchmarkReport::isSelected(string const &name) const
+{
+  return filter.empty() || name.find(filter) != string::npos;
+}
+
+void BenchmarkReport::measure(string const &name, int iterations, long long rows, function<void(void)> run, function<void(void)> setup)
+{
+  if (!isSelected(name))
+  {
+    return;
+  }
+
+  vector<double> samplesMs;
+  samplesMs.reserve(iterations);
+  for (int i = 0; i < iterations; i++)
+  {
+    if (setup != nullptr)
+    {
+      setup();
+    }
+    auto start = chrono::steady_clock::now();
+    run();
+    samplesMs.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+  }
+  add(name, rows, move(samplesMs));
+}
+
+void BenchmarkReport::add(string const &name, long long rows, vector<double> samplesMs)
+{
+  results.push_back({name, rows, move(samplesMs)});
+}
+
+string BenchmarkReport::toText() const
+{
+  stringstream text;
+  text.setf(ios::fixed);
+  text.precision(3);
+  for (auto &result : results)
+  {
+    auto summary = summarize(result.samplesMs);
+    text << result.name << ": " << result.samplesMs.size() << " runs, mean " << summary.meanMs
+         << " ms, p50 " << summary.p50Ms << " ms, p95 " << summary.p95Ms << " ms\n";
+  }
+  return text.str();
+}
+
+string BenchmarkReport::toJson() const
+{
+  stringstream json;
+  json.precision(6);
+  json << "{\n"
+       << "  \"suite\": \"react-native-quick-sqlite\",\n"
+       << "  \"version\": \"" << QUICK_SQLITE_VERSION << "\",\n"
+       << "  \"sqlite\": \"" << sqlite3_libversion() << "\",\n"
+       << "  \"platform\": \"" << escapeJson(platform) << "\",\n"
+       << "  \"timestamp\": \"" << currentTimestamp() << "\",\n"
+       << "  \"results\": [";
+
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    auto &result = results[i];
+    auto summary = summarize(result.samplesMs);
+    double seconds = summary.totalMs / 1000;
+    double opsPerSec = seconds > 0 ? result.samplesMs.size() / seconds : 0;
+
+    json << (i == 0 ? "\n" : ",\n")
+         << "    {\"name\": \"" << escapeJson(result.name) << "\""
+         << ", \"iterations\": " << result.samplesMs.size()
+         << ", \"rows\": " << result.rows
+         << ", \"totalMs\": " << summary.totalMs
+         << ", \"meanMs\": " << summary.meanMs
+         << ", \"minMs\": " << summary.minMs
+         << ", \"p50Ms\": " << summary.p50Ms
+         << ", \"p95Ms\": " << summary.p95Ms
+         << ", \"maxMs\": " << summary.maxMs
+         << ", \"opsPerSec\": " << opsPerSec
+         << ", \"rowsPerSec\": " << opsPerSec * result.rows << "}";
+  }
+  json << "\n  ]\n}\n";
+  return json.str();
+}
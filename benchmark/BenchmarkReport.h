@@ -0,0 +1,49 @@
+//
+//  BenchmarkReport.h
+//  react-native-quick-sqlite
+//
+//  Timed samples of every benchmark case, written as the JSON report shared with the example app runner
+//
+
+#ifndef BenchmarkReport_h
+#define BenchmarkReport_h
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+struct BenchmarkResult
+{
+  string name;
+  // Rows inserted, read or imported by a single sample, 0 when it does not apply
+  long long rows = 0;
+  vector<double> samplesMs;
+};
+
+class BenchmarkReport {
+public:
+  BenchmarkReport(string platform, string filter);
+
+  // Cases whose name does not contain the filter are skipped
+  bool isSelected(string const &name) const;
+  /**
+   * Calls setup, untimed, then run for every iteration.
+   * A case throws when an operation fails, a report never holds timings of failed runs
+   */
+  void measure(string const &name, int iterations, long long rows, function<void(void)> run, function<void(void)> setup = nullptr);
+  // Samples measured by the case itself, e.g. the latency of every task of a concurrent run
+  void add(string const &name, long long rows, vector<double> samplesMs);
+
+  // One line per case, meant for a terminal
+  string toText() const;
+  string toJson() const;
+
+private:
+  string platform;
+  string filter;
+  vector<BenchmarkResult> results;
+};
+
+#endif /* BenchmarkReport_h */
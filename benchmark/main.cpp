@@ -0,0 +1,463 @@
+//
+//  main.cpp
+//  react-native-quick-sqlite
+//
+//  Native benchmarks of the bridge hot paths, the JSON report is printed to stdout or written to --output
+//
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "BenchmarkReport.h"
+#include "sqliteBridge.h"
+#include "sqlbatchexecutor.h"
+#include "sqlfileloader.h"
+#include "ThreadPool.h"
+#include "SerialExecutor.h"
+
+#ifdef QUICK_SQLITE_BENCH_HERMES
+#include <hermes/hermes.h>
+#endif
+
+using namespace std;
+using namespace facebook;
+
+#define BENCHMARK_DB "benchmark.sqlite"
+#define BLOB_SIZE (1024 * 1024)
+
+struct BenchmarkOptions
+{
+  // Multiplies the rows and iterations of every case, 0.1 gives a quick smoke run
+  double scale = 1;
+  string filter;
+  string output;
+  string directory;
+};
+
+int scaled(BenchmarkOptions const &options, int count)
+{
+  return max(1, (int)(count * options.scale));
+}
+
+void check(SQLiteOPResult const &result)
+{
+  if (result.type == SQLiteError)
+  {
+    throw runtime_error(result.errorMessage);
+  }
+}
+
+void checkLiteral(string const &query)
+{
+  auto result = sqliteExecuteLiteral(BENCHMARK_DB, query);
+  if (result.type == SQLiteError)
+  {
+    throw runtime_error(result.message);
+  }
+}
+
+QuickParams userParams(int i)
+{
+  QuickParams params;
+  params.addText("user " + to_string(i));
+  params.addInt64(i % 100);
+  params.addDouble(i * 1.5);
+  return params;
+}
+
+void openBenchmarkDb(BenchmarkOptions const &options, size_t readerConnections)
+{
+  sqliteRemoveDb(BENCHMARK_DB, options.directory);
+  SQLiteOpenOptions openOptions;
+  openOptions.readerConnections = readerConnections;
+  check(sqliteOpenDb(BENCHMARK_DB, options.directory, openOptions));
+  checkLiteral("CREATE TABLE User (id INTEGER PRIMARY KEY, name TEXT NOT NULL, age INTEGER, networth REAL)");
+}
+
+void closeBenchmarkDb(BenchmarkOptions const &options)
+{
+  sqliteCloseDb(BENCHMARK_DB);
+  sqliteRemoveDb(BENCHMARK_DB, options.directory);
+}
+
+void fillUsers(int rows)
+{
+  vector<QuickParams> paramSets;
+  paramSets.reserve(rows);
+  for (int i = 0; i < rows; i++)
+  {
+    paramSets.push_back(userParams(i));
+  }
+  checkLiteral("BEGIN");
+  check(sqliteExecuteMany(BENCHMARK_DB, "INSERT INTO User (name, age, networth) VALUES (?, ?, ?)", &paramSets));
+  checkLiteral("COMMIT");
+}
+
+void benchmarkInserts(BenchmarkReport &report, BenchmarkOptions const &options)
+{
+  openBenchmarkDb(options, 0);
+
+  // Every insert commits on its own, as execute outside of a transaction does
+  int row = 0;
+  report.measure("insert.single", scaled(options, 1000), 1, [&row]()
+                 {
+    auto params = userParams(row++);
+    check(sqliteExecute(BENCHMARK_DB, "INSERT INTO User (name, age, networth) VALUES (?, ?, ?)", &params, NULL, NULL)); });
+
+  const int batchRows = scaled(options, 10000);
+  vector<QuickQueryArguments> commands;
+  auto clearUsers = [&commands, batchRows]()
+  {
+    checkLiteral("DELETE FROM User");
+    commands.assign(1, QuickQueryArguments{"INSERT INTO User (name, age, networth) VALUES (?, ?, ?)", {}});
+    commands[0].params.reserve(batchRows);
+    for (int i = 0; i < batchRows; i++)
+    {
+      commands[0].params.push_back(userParams(i));
+    }
+  };
+  report.measure("insert.batch.executeBatch", 10, batchRows, [&commands]()
+                 {
+    auto result = sqliteExecuteBatch(BENCHMARK_DB, &commands);
+    if (result.type == SQLiteError)
+    {
+      throw runtime_error(result.message);
+    } }, clearUsers);
+
+  report.measure("insert.batch.executeMany", 10, batchRows, [&commands]()
+                 {
+    checkLiteral("BEGIN");
+    check(sqliteExecuteMany(BENCHMARK_DB, commands[0].sql, &commands[0].params));
+    checkLiteral("COMMIT"); }, clearUsers);
+
+  closeBenchmarkDb(options);
+}
+
+void benchmarkSelects(BenchmarkReport &report, BenchmarkOptions const &options, jsi::Runtime *rt)
+{
+  openBenchmarkDb(options, 0);
+  const vector<int> sizes = {scaled(options, 10000), scaled(options, 100000)};
+  fillUsers(sizes.back());
+
+  const vector<pair<string, QuickResultFormat>> formats = {
+    {"objects", RESULT_OBJECTS},
+    {"arrays", RESULT_ARRAYS},
+    {"columns", RESULT_COLUMNS},
+    {"lazy", RESULT_LAZY},
+  };
+  for (int size : sizes)
+  {
+    const string query = "SELECT * FROM User LIMIT " + to_string(size);
+    const string prefix = "select." + to_string(size) + ".";
+    QuickResultSet results;
+    vector<QuickColumnMetadata> metadata;
+    auto readResults = [&query, &results, &metadata]()
+    {
+      QuickParams params;
+      results = QuickResultSet();
+      metadata.clear();
+      check(sqliteExecute(BENCHMARK_DB, query, &params, &results, &metadata));
+    };
+
+    report.measure(prefix + "step", 10, size, readResults);
+
+    // Without a runtime only the native half of execute can be measured
+    if (rt == nullptr)
+    {
+      continue;
+    }
+    for (auto &format : formats)
+    {
+      report.measure(prefix + "marshal." + format.first, 10, size, [rt, &results, &metadata, &format]()
+                     {
+        auto status = SQLiteOPResult{.type = SQLiteOk, .rowsAffected = 0};
+        jsi::Value value = createSequelQueryExecutionResult(*rt, status, &results, &metadata, format.second);
+        // Kept alive until the end of the sample so its JS objects are part of the measure
+        (void)value; }, readResults);
+    }
+  }
+
+  closeBenchmarkDb(options);
+}
+
+void benchmarkBlobs(BenchmarkReport &report, BenchmarkOptions const &options)
+{
+  openBenchmarkDb(options, 0);
+  checkLiteral("CREATE TABLE Thumbnail (id INTEGER PRIMARY KEY, data BLOB)");
+
+  vector<uint8_t> bytes(BLOB_SIZE);
+  for (size_t i = 0; i < bytes.size(); i++)
+  {
+    bytes[i] = (uint8_t)(i * 31);
+  }
+
+  // Written from memory borrowed like an ArrayBuffer parameter, read back into an owned copy
+  report.measure("blob.roundtrip.1mb", scaled(options, 100), 1, [&bytes]()
+                 {
+    QuickParams params;
+    params.addInt64(1);
+    params.addBlob(QuickBlob::borrow(bytes.data(), bytes.size()));
+    check(sqliteExecute(BENCHMARK_DB, "INSERT OR REPLACE INTO Thumbnail (id, data) VALUES (?, ?)", &params, NULL, NULL));
+
+    QuickParams noParams;
+    QuickResultSet results;
+    vector<QuickColumnMetadata> metadata;
+    check(sqliteExecute(BENCHMARK_DB, "SELECT data FROM Thumbnail WHERE id = 1", &noParams, &results, &metadata));
+    if (results.cells.size() != 1 || results.cells[0].arrayBufferValue == nullptr || results.cells[0].arrayBufferValue->size() != BLOB_SIZE)
+    {
+      throw runtime_error("blob read back with a different size");
+    }});
+
+  closeBenchmarkDb(options);
+}
+
+/**
+ * Producers queue tasks the way executeAsync does: reads straight on the pool and
+ * served by reader connections, writes behind each other on the database executor
+ */
+/**
+ * A search page over an FTS5 table, match positions returned as marked up strings and as offsets
+ */
+void benchmarkSearch(BenchmarkReport &report, BenchmarkOptions const &options)
+{
+  if (!report.isSelected("search.highlight") && !report.isSelected("search.matchOffsets"))
+  {
+    return;
+  }
+
+  openBenchmarkDb(options, 0);
+  checkLiteral("CREATE VIRTUAL TABLE Message USING fts5(body)");
+  const int rows = scaled(options, 100000);
+  checkLiteral("INSERT INTO Message (body) WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < " + to_string(rows) + ") "
+               "SELECT 'message ' || i || ' about topic ' || (i % 97) || ' from user ' || (i % 13) || ' with some more words' FROM n");
+
+  const int pageRows = 50;
+  auto search = [](string const &query)
+  {
+    QuickParams params;
+    params.addText("topic AND 42");
+    QuickResultSet results;
+    vector<QuickColumnMetadata> metadata;
+    check(sqliteExecute(BENCHMARK_DB, query, &params, &results, &metadata));
+  };
+  report.measure("search.highlight", scaled(options, 100), pageRows, [&search]()
+                 { search("SELECT rowid, highlight(Message, 0, '<b>', '</b>') FROM Message WHERE Message MATCH ? ORDER BY rank LIMIT 50"); });
+  report.measure("search.matchOffsets", scaled(options, 100), pageRows, [&search]()
+                 { search("SELECT rowid, body, match_offsets(Message) FROM Message WHERE Message MATCH ? ORDER BY rank LIMIT 50"); });
+
+  closeBenchmarkDb(options);
+}
+
+void benchmarkAsyncContention(BenchmarkReport &report, BenchmarkOptions const &options)
+{
+  const string queueWaitName = "async.contention.queueWait";
+  const string latencyName = "async.contention.latency";
+  if (!report.isSelected(queueWaitName) && !report.isSelected(latencyName))
+  {
+    return;
+  }
+
+  openBenchmarkDb(options, 2);
+  fillUsers(scaled(options, 10000));
+
+  const int producers = 4;
+  const int tasksPerProducer = scaled(options, 500);
+  auto pool = make_shared<ThreadPool>();
+  auto executor = make_shared<SerialExecutor>(pool);
+
+  mutex samplesMutex;
+  condition_variable finished;
+  vector<double> queueWaitMs;
+  vector<double> latencyMs;
+  int remaining = producers * tasksPerProducer;
+  atomic<bool> isFailed(false);
+
+  vector<thread> threads;
+  for (int p = 0; p < producers; p++)
+  {
+    threads.push_back(thread([&, p]()
+                             {
+      for (int i = 0; i < tasksPerProducer; i++)
+      {
+        const bool isWrite = i % 5 == 0;
+        auto queuedAt = chrono::steady_clock::now();
+        auto task = [&, isWrite, queuedAt, row = p * tasksPerProducer + i]()
+        {
+          auto startedAt = chrono::steady_clock::now();
+          SQLiteOPResult status;
+          if (isWrite)
+          {
+            auto params = userParams(row);
+            status = sqliteExecute(BENCHMARK_DB, "INSERT INTO User (name, age, networth) VALUES (?, ?, ?)", &params, NULL, NULL);
+          }
+          else
+          {
+            QuickParams params;
+            params.addInt64(row % 100);
+            QuickResultSet results;
+            vector<QuickColumnMetadata> metadata;
+            status = sqliteExecuteRead(BENCHMARK_DB, "SELECT * FROM User WHERE age = ? LIMIT 20", &params, &results, &metadata);
+          }
+          auto doneAt = chrono::steady_clock::now();
+
+          lock_guard<mutex> g(samplesMutex);
+          isFailed = isFailed || status.type == SQLiteError;
+          queueWaitMs.push_back(chrono::duration<double, milli>(startedAt - queuedAt).count());
+          latencyMs.push_back(chrono::duration<double, milli>(doneAt - queuedAt).count());
+          if (--remaining == 0)
+          {
+            finished.notify_one();
+          }
+        };
+
+        if (isWrite)
+        {
+          executor->queueWork(task);
+        }
+        else
+        {
+          pool->queueWork(task);
+        }
+      } }));
+  }
+  for (auto &producer : threads)
+  {
+    producer.join();
+  }
+
+  {
+    unique_lock<mutex> g(samplesMutex);
+    finished.wait(g, [&remaining]()
+                  { return remaining == 0; });
+  }
+  if (isFailed)
+  {
+    throw runtime_error("async task failed");
+  }
+
+  if (report.isSelected(queueWaitName))
+  {
+    report.add(queueWaitName, 1, queueWaitMs);
+  }
+  if (report.isSelected(latencyName))
+  {
+    report.add(latencyName, 1, latencyMs);
+  }
+
+  executor.reset();
+  pool.reset();
+  closeBenchmarkDb(options);
+}
+
+void benchmarkLoadFile(BenchmarkReport &report, BenchmarkOptions const &options)
+{
+  const int rows = scaled(options, 10000);
+  const string name = "loadFile." + to_string(rows);
+  if (!report.isSelected(name))
+  {
+    return;
+  }
+
+  const string sqlPath = options.directory + "/benchmark.sql";
+  {
+    ofstream sqlFile(sqlPath);
+    sqlFile << "CREATE TABLE Imported (id INTEGER PRIMARY KEY, name TEXT NOT NULL, age INTEGER, networth REAL);\n";
+    for (int i = 0; i < rows; i++)
+    {
+      sqlFile << "INSERT INTO Imported (name, age, networth) VALUES ('user " << i << "', " << i % 100 << ", " << i * 1.5 << ");\n";
+    }
+  }
+
+  openBenchmarkDb(options, 0);
+  report.measure(name, 10, rows, [&sqlPath]()
+                 {
+    auto result = importSQLFile(BENCHMARK_DB, sqlPath);
+    if (result.type == SQLiteError)
+    {
+      throw runtime_error(result.message);
+    } }, []()
+                 { checkLiteral("DROP TABLE IF EXISTS Imported"); });
+
+  closeBenchmarkDb(options);
+  remove(sqlPath.c_str());
+}
+
+int main(int argc, char **argv)
+{
+  BenchmarkOptions options;
+  const char *tmpDir = getenv("TMPDIR");
+  options.directory = string(tmpDir != nullptr ? tmpDir : "/tmp") + "/quick-sqlite-benchmark";
+
+  for (int i = 1; i < argc; i++)
+  {
+    string arg = argv[i];
+    if (i + 1 < argc && arg == "--scale")
+    {
+      options.scale = atof(argv[++i]);
+    }
+    else if (i + 1 < argc && arg == "--filter")
+    {
+      options.filter = argv[++i];
+    }
+    else if (i + 1 < argc && arg == "--output")
+    {
+      options.output = argv[++i];
+    }
+    else if (i + 1 < argc && arg == "--dir")
+    {
+      options.directory = argv[++i];
+    }
+    else
+    {
+      cerr << "Usage: " << argv[0] << " [--scale factor] [--filter name] [--output file.json] [--dir directory]" << endl;
+      return 1;
+    }
+  }
+  if (options.scale <= 0)
+  {
+    cerr << "--scale must be greater than 0" << endl;
+    return 1;
+  }
+
+#ifdef QUICK_SQLITE_BENCH_HERMES
+  unique_ptr<jsi::Runtime> runtime = hermes::makeHermesRuntime();
+  BenchmarkReport report("native-hermes", options.filter);
+#else
+  unique_ptr<jsi::Runtime> runtime;
+  BenchmarkReport report("native", options.filter);
+#endif
+
+  try
+  {
+    benchmarkInserts(report, options);
+    benchmarkSelects(report, options, runtime.get());
+    benchmarkBlobs(report, options);
+    benchmarkSearch(report, options);
+    benchmarkAsyncContention(report, options);
+    benchmarkLoadFile(report, options);
+  }
+  catch (exception &exc)
+  {
+    cerr << "Benchmark failed: " << exc.what() << endl;
+    sqliteCloseDb(BENCHMARK_DB);
+    return 1;
+  }
+
+  cerr << report.toText();
+  if (options.output.empty())
+  {
+    cout << report.toJson();
+  }
+  else
+  {
+    ofstream(options.output) << report.toJson();
+  }
+  return 0;
+}
@@ -0,0 +1,51 @@
+//
+//  CancelToken.cpp
+//  react-native-quick-sqlite
+//
+
+#include "CancelToken.h"
+#include "macros.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  CancelToken::CancelToken() : cancellation(make_shared<QueryCancellation>())
+  {
+  }
+
+  shared_ptr<QueryCancellation> CancelToken::getCancellation()
+  {
+    return cancellation;
+  }
+
+  vector<jsi::PropNameID> CancelToken::getPropertyNames(jsi::Runtime &rt)
+  {
+    vector<jsi::PropNameID> names;
+    names.push_back(jsi::PropNameID::forAscii(rt, "cancel"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "cancelled"));
+    return names;
+  }
+
+  jsi::Value CancelToken::get(jsi::Runtime &rt, const jsi::PropNameID &propNameId)
+  {
+    auto name = propNameId.utf8(rt);
+    auto cancellation = this->cancellation;
+
+    if (name == "cancel")
+    {
+      return HOSTFN("cancel", 0) {
+        // The queued queries are rejected from here, the running ones once they stopped
+        cancellation->cancel();
+        return {};
+      });
+    }
+
+    if (name == "cancelled")
+    {
+      return jsi::Value(cancellation->isCancelled());
+    }
+
+    return jsi::Value::undefined();
+  }
+}
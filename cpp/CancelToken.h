@@ -0,0 +1,32 @@
+//
+//  CancelToken.h
+//  react-native-quick-sqlite
+//
+//  JSI HostObject passed as the cancelToken option of async queries, cancel() abandons all of them
+//
+
+#ifndef CancelToken_h
+#define CancelToken_h
+
+#include <jsi/jsi.h>
+#include "QueryInterrupt.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  class CancelToken : public jsi::HostObject {
+  public:
+    CancelToken();
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &propNameId) override;
+    vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+    shared_ptr<QueryCancellation> getCancellation();
+
+  private:
+    shared_ptr<QueryCancellation> cancellation;
+  };
+}
+
+#endif /* CancelToken_h */
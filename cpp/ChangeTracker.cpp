@@ -0,0 +1,107 @@
+//
+//  ChangeTracker.cpp
+//  react-native-quick-sqlite
+//
+
+#include "ChangeTracker.h"
+#include <cctype>
+
+using namespace std;
+
+void mergeChangeSet(ChangeSet *target, ChangeSet const &changes)
+{
+  for (auto &change : changes)
+  {
+    TableChanges &tableChanges = (*target)[change.first];
+    if (tableChanges.isTruncated)
+    {
+      continue;
+    }
+    if (change.second.isTruncated || tableChanges.rowids.size() + change.second.rowids.size() > MAX_TRACKED_ROWIDS)
+    {
+      tableChanges.rowids.clear();
+      tableChanges.isTruncated = true;
+      continue;
+    }
+    tableChanges.rowids.insert(tableChanges.rowids.end(), change.second.rowids.begin(), change.second.rowids.end());
+  }
+}
+
+string lowercaseTableName(const char *table)
+{
+  string name(table);
+  for (char &c : name)
+  {
+    c = (char)tolower((unsigned char)c);
+  }
+  return name;
+}
+
+ChangeTracker::ChangeTracker(sqlite3 *db) : db(db), hasListener(false)
+{
+  sqlite3_update_hook(db, &ChangeTracker::onUpdate, this);
+  sqlite3_commit_hook(db, &ChangeTracker::onCommit, this);
+  sqlite3_rollback_hook(db, &ChangeTracker::onRollback, this);
+}
+
+ChangeTracker::~ChangeTracker()
+{
+  sqlite3_update_hook(db, NULL, NULL);
+  sqlite3_commit_hook(db, NULL, NULL);
+  sqlite3_rollback_hook(db, NULL, NULL);
+}
+
+void ChangeTracker::setListener(function<void(ChangeSet const &)> listener)
+{
+  lock_guard<mutex> g(listenerMutex);
+  this->listener = listener;
+  hasListener = listener != nullptr;
+}
+
+void ChangeTracker::onUpdate(void *context, int operation, const char *database, const char *table, sqlite3_int64 rowid)
+{
+  ChangeTracker *tracker = static_cast<ChangeTracker *>(context);
+  if (!tracker->hasListener)
+  {
+    return;
+  }
+
+  TableChanges &changes = tracker->pending[lowercaseTableName(table)];
+  if (changes.isTruncated)
+  {
+    return;
+  }
+  if (changes.rowids.size() == MAX_TRACKED_ROWIDS)
+  {
+    changes.rowids.clear();
+    changes.isTruncated = true;
+    return;
+  }
+  changes.rowids.push_back(rowid);
+}
+
+int ChangeTracker::onCommit(void *context)
+{
+  ChangeTracker *tracker = static_cast<ChangeTracker *>(context);
+  if (tracker->pending.empty())
+  {
+    return 0;
+  }
+
+  // The commit can still fail after the hook, listeners at worst re-read unchanged data
+  ChangeSet changes;
+  changes.swap(tracker->pending);
+  lock_guard<mutex> g(tracker->listenerMutex);
+  if (tracker->listener != nullptr)
+  {
+    tracker->listener(changes);
+  }
+  // Anything else would turn the commit into a rollback
+  return 0;
+}
+
+void ChangeTracker::onRollback(void *context)
+{
+  ChangeTracker *tracker = static_cast<ChangeTracker *>(context);
+  tracker->pending.clear();
+}
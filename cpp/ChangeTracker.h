@@ -0,0 +1,70 @@
+//
+//  ChangeTracker.h
+//  react-native-quick-sqlite
+//
+//  Collects the rows changed by every transaction of a connection through the SQLite hooks
+//
+
+#ifndef ChangeTracker_h
+#define ChangeTracker_h
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "sqlite3.h"
+
+using namespace std;
+
+// Rowids kept per table and transaction, larger changes only report the table
+#define MAX_TRACKED_ROWIDS 1000
+
+/**
+ * Rows changed in a table, isTruncated is set when there were too many to keep their rowids
+ */
+struct TableChanges
+{
+  vector<sqlite3_int64> rowids;
+  bool isTruncated = false;
+};
+
+// Keyed by the lowercase table name
+typedef map<string, TableChanges> ChangeSet;
+
+void mergeChangeSet(ChangeSet *target, ChangeSet const &changes);
+
+/**
+ * Table names are case insensitive, they are compared lowercase
+ */
+string lowercaseTableName(const char *table);
+
+class ChangeTracker {
+public:
+  // Installs the update, commit and rollback hooks on the connection
+  ChangeTracker(sqlite3 *db);
+  // Removes the hooks, MUST be called before the connection is closed
+  ~ChangeTracker();
+
+  /**
+   * Called with the changes of every committed transaction from the thread running the COMMIT,
+   * while the connection is locked. It must not use the connection, only queue work
+   */
+  void setListener(function<void(ChangeSet const &)> listener);
+
+private:
+  sqlite3 *db;
+  // Changes of the transaction in progress, the hooks run while the connection is locked
+  ChangeSet pending;
+  // Nothing is collected while there is no listener
+  atomic<bool> hasListener;
+  mutex listenerMutex;
+  function<void(ChangeSet const &)> listener;
+
+  static void onUpdate(void *context, int operation, const char *database, const char *table, sqlite3_int64 rowid);
+  static int onCommit(void *context);
+  static void onRollback(void *context);
+};
+
+#endif /* ChangeTracker_h */
@@ -0,0 +1,115 @@
+//
+//  ChangesetSession.cpp
+//  react-native-quick-sqlite
+//
+
+#include "ChangesetSession.h"
+#include "macros.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  ChangesetSession::ChangesetSession(
+                                     shared_ptr<SessionHandle> handle,
+                                     ExecutorProvider getExecutor,
+                                     shared_ptr<react::CallInvoker> invoker
+                                     ) :
+  handle(handle),
+  getExecutor(getExecutor),
+  invoker(invoker)
+  {
+  }
+
+  ChangesetSession::~ChangesetSession()
+  {
+    sqliteSessionClose(handle);
+  }
+
+  vector<jsi::PropNameID> ChangesetSession::getPropertyNames(jsi::Runtime &rt)
+  {
+    vector<jsi::PropNameID> names;
+    names.push_back(jsi::PropNameID::forAscii(rt, "isEmpty"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "changeset"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "changesetAsync"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "close"));
+    return names;
+  }
+
+  jsi::Value ChangesetSession::get(jsi::Runtime &rt, const jsi::PropNameID &propNameId)
+  {
+    auto name = propNameId.utf8(rt);
+    // The returned functions can outlive this object, they only hold on to the shared state
+    auto handle = this->handle;
+    auto getExecutor = this->getExecutor;
+    auto invoker = this->invoker;
+
+    if (name == "isEmpty")
+    {
+      bool isEmpty = true;
+      auto status = sqliteSessionIsEmpty(handle, &isEmpty);
+      if (status.type == SQLiteError)
+      {
+        throw jsi::JSError(rt, status.errorMessage);
+      }
+      return jsi::Value(isEmpty);
+    }
+
+    if (name == "changeset")
+    {
+      return HOSTFN("changeset", 0) {
+        shared_ptr<QuickBlob> changeset;
+        auto status = sqliteSessionChangeset(handle, &changeset);
+        if (status.type == SQLiteError)
+        {
+          throw jsi::JSError(rt, status.errorMessage);
+        }
+        return quickValueToJsiValue(rt, createArrayBufferQuickValue(changeset));
+      });
+    }
+
+    if (name == "changesetAsync")
+    {
+      return HOSTFN("changesetAsync", 0) {
+        auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+        auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+          auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+          auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+          auto task =
+          [&rt, handle, invoker, resolve, reject]()
+          {
+            shared_ptr<QuickBlob> changeset;
+            auto status = sqliteSessionChangeset(handle, &changeset);
+            invoker->invokeAsync([&rt, status_copy = move(status), changeset, resolve, reject]
+                                 {
+              if(status_copy.type == SQLiteOk) {
+                resolve->asObject(rt).asFunction(rt).call(rt, quickValueToJsiValue(rt, createArrayBufferQuickValue(changeset)));
+              } else {
+                auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+                auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+                reject->asObject(rt).asFunction(rt).call(rt, error);
+              }
+            });
+          };
+
+          getExecutor()->queueWork(task);
+
+          return {};
+        }));
+
+        return promise;
+      });
+    }
+
+    if (name == "close")
+    {
+      return HOSTFN("close", 0) {
+        sqliteSessionClose(handle);
+        return {};
+      });
+    }
+
+    return jsi::Value::undefined();
+  }
+}
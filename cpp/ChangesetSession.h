@@ -0,0 +1,39 @@
+//
+//  ChangesetSession.h
+//  react-native-quick-sqlite
+//
+//  JSI HostObject recording the changes of a database with the session extension, read back as a binary changeset
+//
+
+#ifndef ChangesetSession_h
+#define ChangesetSession_h
+
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+#include "sqliteBridge.h"
+#include "SerialExecutor.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  class ChangesetSession : public jsi::HostObject {
+  public:
+    ChangesetSession(
+                     shared_ptr<SessionHandle> handle,
+                     ExecutorProvider getExecutor,
+                     shared_ptr<react::CallInvoker> invoker
+                     );
+    ~ChangesetSession();
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &propNameId) override;
+    vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+  private:
+    shared_ptr<SessionHandle> handle;
+    ExecutorProvider getExecutor;
+    shared_ptr<react::CallInvoker> invoker;
+  };
+}
+
+#endif /* ChangesetSession_h */
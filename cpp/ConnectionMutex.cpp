@@ -0,0 +1,59 @@
+//
+//  ConnectionMutex.cpp
+//  react-native-quick-sqlite
+//
+
+#include "ConnectionMutex.h"
+#include "JSThreadDispatcher.h"
+#include <stdexcept>
+
+void ConnectionMutex::lock()
+{
+  if (try_lock())
+  {
+    return;
+  }
+
+  // The worker holding the connection might be waiting for the JS thread to run a custom function
+  if (JSThreadDispatcher::isJSThread())
+  {
+    if (JSThreadDispatcher::isServingCallOf(owner.load()))
+    {
+      throw std::runtime_error("[react-native-quick-sqlite] A custom function called by an async query cannot query the same database, the query holds the connection until the function returns");
+    }
+    JSThreadDispatcher::runPendingCallsUntil([this]()
+                                             { return try_lock(); });
+    return;
+  }
+
+  mutex.lock();
+  acquired();
+}
+
+bool ConnectionMutex::try_lock()
+{
+  if (!mutex.try_lock())
+  {
+    return false;
+  }
+  acquired();
+  return true;
+}
+
+void ConnectionMutex::unlock()
+{
+  if (--depth == 0)
+  {
+    owner = std::thread::id();
+  }
+  mutex.unlock();
+  JSThreadDispatcher::wake();
+}
+
+void ConnectionMutex::acquired()
+{
+  if (depth++ == 0)
+  {
+    owner = std::this_thread::get_id();
+  }
+}
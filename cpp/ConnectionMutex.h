@@ -0,0 +1,35 @@
+//
+//  ConnectionMutex.h
+//  react-native-quick-sqlite
+//
+//  Recursive mutex guarding a connection, the JS thread keeps serving the calls of
+//  custom functions while it waits for a worker to release the connection
+//
+
+#ifndef ConnectionMutex_h
+#define ConnectionMutex_h
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+class ConnectionMutex {
+public:
+  /**
+   * Throws when called from a custom function that runs for the worker holding the connection,
+   * waiting for it would never return
+   */
+  void lock();
+  bool try_lock();
+  void unlock();
+
+private:
+  void acquired();
+
+  std::recursive_mutex mutex;
+  // Thread holding the mutex, the depth is only changed by that thread
+  std::atomic<std::thread::id> owner;
+  int depth = 0;
+};
+
+#endif /* ConnectionMutex_h */
@@ -0,0 +1,120 @@
+//
+//  Cursor.cpp
+//  react-native-quick-sqlite
+//
+
+#include "Cursor.h"
+#include "macros.h"
+
+using namespace std;
+using namespace facebook;
+
+#define DEFAULT_CURSOR_BATCH_SIZE 100
+
+namespace osp {
+  Cursor::Cursor(
+                 shared_ptr<PreparedStatementHandle> handle,
+                 QuickResultFormat format,
+                 ExecutorProvider getExecutor,
+                 shared_ptr<react::CallInvoker> invoker
+                 ) :
+  state(make_shared<CursorState>()),
+  getExecutor(getExecutor),
+  invoker(invoker)
+  {
+    state->handle = handle;
+    state->format = format;
+    state->isFetching = false;
+    state->isDone = false;
+  }
+
+  Cursor::~Cursor()
+  {
+    sqliteFinalizePreparedStatement(state->handle);
+  }
+
+  vector<jsi::PropNameID> Cursor::getPropertyNames(jsi::Runtime &rt)
+  {
+    vector<jsi::PropNameID> names;
+    names.push_back(jsi::PropNameID::forAscii(rt, "next"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "close"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "done"));
+    return names;
+  }
+
+  jsi::Value Cursor::get(jsi::Runtime &rt, const jsi::PropNameID &propNameId)
+  {
+    auto name = propNameId.utf8(rt);
+    auto state = this->state;
+    auto getExecutor = this->getExecutor;
+    auto invoker = this->invoker;
+
+    if (name == "done")
+    {
+      return jsi::Value(state->isDone.load());
+    }
+
+    if (name == "next")
+    {
+      return HOSTFN("next", 1) {
+        size_t batchSize = DEFAULT_CURSOR_BATCH_SIZE;
+        if (count > 0 && args[0].isNumber())
+        {
+          double requestedSize = args[0].asNumber();
+          batchSize = requestedSize >= 1 ? (size_t)requestedSize : 1;
+        }
+
+        if (state->isFetching.exchange(true))
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][next] The previous batch has not been fetched yet");
+        }
+
+        auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+        auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+          auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+          auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+          auto task =
+          [&rt, state, batchSize, invoker, resolve, reject]()
+          {
+            auto results = make_shared<QuickResultSet>();
+            bool done = true;
+            auto status = state->isDone ? SQLiteOPResult{.type = SQLiteOk} : sqliteStepPreparedStatement(state->handle, batchSize, results.get(), &done);
+            state->isDone = done;
+
+            invoker->invokeAsync([&rt, state, results, status_copy = move(status), done, resolve, reject]
+                                 {
+              state->isFetching = false;
+              if(status_copy.type == SQLiteOk) {
+                auto jsiResult = createSequelQueryExecutionResult(rt, status_copy, results.get(), NULL, state->format);
+                jsiResult.asObject(rt).setProperty(rt, "done", jsi::Value(done));
+                resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResult));
+              } else {
+                auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+                auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+                reject->asObject(rt).asFunction(rt).call(rt, error);
+              }
+            });
+          };
+
+          getExecutor()->queueWork(task);
+
+          return {};
+        }));
+
+        return promise;
+      });
+    }
+
+    if (name == "close")
+    {
+      return HOSTFN("close", 0) {
+        state->isDone = true;
+        sqliteFinalizePreparedStatement(state->handle);
+        return {};
+      });
+    }
+
+    return jsi::Value::undefined();
+  }
+}
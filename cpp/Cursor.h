@@ -0,0 +1,54 @@
+//
+//  Cursor.h
+//  react-native-quick-sqlite
+//
+//  JSI HostObject reading the rows of a query in batches from a worker thread
+//
+
+#ifndef Cursor_h
+#define Cursor_h
+
+#include <atomic>
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+#include "sqliteBridge.h"
+#include "SerialExecutor.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  /**
+   * State shared between the cursor and the tasks fetching its batches
+   */
+  struct CursorState
+  {
+    shared_ptr<PreparedStatementHandle> handle;
+    QuickResultFormat format;
+    // Set while a batch is being fetched, batches have to be requested one after the other
+    atomic<bool> isFetching;
+    // Once the statement is done it must not be stepped again, that would restart the query
+    atomic<bool> isDone;
+  };
+
+  class Cursor : public jsi::HostObject {
+  public:
+    Cursor(
+           shared_ptr<PreparedStatementHandle> handle,
+           QuickResultFormat format,
+           ExecutorProvider getExecutor,
+           shared_ptr<react::CallInvoker> invoker
+           );
+    ~Cursor();
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &propNameId) override;
+    vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+  private:
+    shared_ptr<CursorState> state;
+    ExecutorProvider getExecutor;
+    shared_ptr<react::CallInvoker> invoker;
+  };
+}
+
+#endif /* Cursor_h */
@@ -9,6 +9,8 @@
 #include<string>
 #include<sqlite3.h>
 #include<JSIHelper.h>
+#include<cmath>
+#include "JSThreadDispatcher.h"
 
 using namespace std;
 using namespace facebook;
@@ -23,7 +25,8 @@ namespace osp {
 	     const bool resultIsFunction,
 	     const std::shared_ptr<jsi::Function> start,
 	     const std::shared_ptr<jsi::Function> inverse,
-	     const std::shared_ptr<jsi::Function> result
+	     const std::shared_ptr<jsi::Function> result,
+	     const int batchSize
 	    ) :
 	        CustomFunction(rt, name, step),
 	        startIsFunction(startIsFunction),
@@ -31,41 +34,113 @@ namespace osp {
 	        inverseIsFunction(inverseIsFunction),
 	        inverse(inverse),
 	        resultIsFunction(resultIsFunction),
-	        result(result)
+	        result(result),
+	        batchSize(batchSize)
 	        {
 	        }
 
 	void CustomAggregate::xStep(sqlite3_context* invocation, int argc, sqlite3_value** argv) {
 	    CustomAggregate* self = (CustomAggregate*) sqlite3_user_data(invocation);
-	    CustomAggregate::xStepBase(invocation, argc, argv, self->fn);
+	    if (self->batchSize > 0) {
+	        CustomAggregate::bufferRow(invocation, argc, argv);
+	        return;
+	    }
+
+	    JSThreadDispatcher::call([&]() {
+	        CustomAggregate* self = (CustomAggregate*) sqlite3_user_data(invocation);
+	        CustomAggregate::xStepBase(invocation, argc, argv, self->fn);
+	    });
 	}
 
 	void CustomAggregate::xInverse(sqlite3_context* invocation, int argc, sqlite3_value** argv) {
-	    CustomAggregate* self = (CustomAggregate*) sqlite3_user_data(invocation);
-	    CustomAggregate::xStepBase(invocation, argc, argv, self->inverse);
+	    JSThreadDispatcher::call([&]() {
+	        CustomAggregate* self = (CustomAggregate*) sqlite3_user_data(invocation);
+	        // The rows still buffered were stepped before the one removed here
+	        flushBatch(invocation, self->GetAccumulator(invocation));
+	        CustomAggregate::xStepBase(invocation, argc, argv, self->inverse);
+	    });
 	}
 
 	void CustomAggregate::xValue(sqlite3_context* invocation) {
-	    CustomAggregate::xValueBase(invocation, false);
+	    JSThreadDispatcher::call([&]() { CustomAggregate::xValueBase(invocation, false); });
 	}
 
 	void CustomAggregate::xFinal(sqlite3_context* invocation) {
-	    CustomAggregate::xValueBase(invocation, true);
+	    JSThreadDispatcher::call([&]() { CustomAggregate::xValueBase(invocation, true); });
 	}
 
 	void CustomAggregate::xStepBase(sqlite3_context* invocation, int argc, sqlite3_value** argv, shared_ptr<jsi::Function> ptrtm) {
 	    CustomAggregate* self = (CustomAggregate*) sqlite3_user_data(invocation);
 	    Accumulator* acc = self->GetAccumulator(invocation);
 
-	    jsi::Value* value = getArguments(self->rt, argv, argc);
-	    jsi::Value convertedValue[argc+1];
+	    vector<jsi::Value> convertedValue(argc + 1);
 	    convertedValue[0] = copyValue(self->rt, acc->value);
-	    for (int i = 0; i < argc; i++) convertedValue[i+1] = copyValue(self->rt, value[i]);
+	    getArguments(self->rt, argv, argc, convertedValue.data() + 1);
+
+	    try {
+	        jsi::Value maybeReturnValue = ptrtm.get()->call(self->rt, (const jsi::Value*) convertedValue.data(), argc + 1);
+
+	        if (!maybeReturnValue.isUndefined()) {
+	            acc->value = copyValue(self->rt, maybeReturnValue);
+	        }
+	    } catch (const exception& e) {
+	        CustomFunction::PropagateJSError(invocation, e.what());
+	    }
+	}
 
-	    jsi::Value maybeReturnValue = ptrtm.get()->call(self->rt, convertedValue, argc + 1);
+	void CustomAggregate::bufferRow(sqlite3_context* invocation, int argc, sqlite3_value** argv) {
+	    CustomAggregate* self = (CustomAggregate*) sqlite3_user_data(invocation);
+	    Accumulator* acc = static_cast<Accumulator*>(sqlite3_aggregate_context(invocation, sizeof(Accumulator)));
+	    if (!acc->initialized) {
+	        // The start value comes from JS, the rows after it are buffered without entering JS
+	        JSThreadDispatcher::call([&]() { self->GetAccumulator(invocation); });
+	    }
 
-	    if (!maybeReturnValue.isUndefined()) {
-	        acc->value = copyValue(self->rt, maybeReturnValue);
+	    // Allocated once per aggregate and reused by every batch
+	    if (acc->batch == nullptr) {
+	        acc->batch = new vector<double>((size_t) argc * self->batchSize);
+	        acc->batchRows = 0;
+	    } else if (acc->batch->size() != (size_t) argc * self->batchSize) {
+	        // Sized for the arguments of the first row, flushBatch reads the count back from it
+	        sqlite3_result_error(invocation, "[react-native-quick-sqlite] stepBatch received rows with a different number of arguments", -1);
+	        return;
+	    }
+
+	    for (int i = 0; i < argc; i++) {
+	        // Numbers as SQLite casts them to REAL, NULL becomes NaN
+	        (*acc->batch)[(size_t) i * self->batchSize + acc->batchRows] = sqlite3_value_type(argv[i]) == SQLITE_NULL
+	            ? NAN
+	            : sqlite3_value_double(argv[i]);
+	    }
+	    acc->batchRows++;
+
+	    if (acc->batchRows == self->batchSize) {
+	        JSThreadDispatcher::call([&]() { flushBatch(invocation, acc); });
+	    }
+	}
+
+	void CustomAggregate::flushBatch(sqlite3_context* invocation, Accumulator* acc) {
+	    CustomAggregate* self = (CustomAggregate*) sqlite3_user_data(invocation);
+	    if (acc->batch == nullptr || acc->batchRows == 0) return;
+
+	    // stepBatch(accumulator, rows, ...one Float64Array per argument)
+	    const size_t argc = acc->batch->size() / self->batchSize;
+	    vector<jsi::Value> convertedValue(argc + 2);
+	    convertedValue[0] = copyValue(self->rt, acc->value);
+	    convertedValue[1] = jsi::Value(acc->batchRows);
+	    for (size_t i = 0; i < argc; i++) {
+	        convertedValue[i + 2] = createFloat64Array(self->rt, acc->batch->data() + i * self->batchSize, acc->batchRows);
+	    }
+	    acc->batchRows = 0;
+
+	    try {
+	        jsi::Value maybeReturnValue = self->fn->call(self->rt, (const jsi::Value*) convertedValue.data(), argc + 2);
+
+	        if (!maybeReturnValue.isUndefined()) {
+	            acc->value = copyValue(self->rt, maybeReturnValue);
+	        }
+	    } catch (const exception& e) {
+	        CustomFunction::PropagateJSError(invocation, e.what());
 	    }
 	}
 
@@ -80,6 +155,7 @@ namespace osp {
 	        return;
 	    }
 
+	    flushBatch(invocation, acc);
 	    jsi::Value result = copyValue(self->rt, acc->value);
 	    if (self->resultIsFunction) {
 	        result = self->result.get()->call(self->rt, result);
@@ -110,6 +186,8 @@ namespace osp {
 	    Accumulator* acc = static_cast<Accumulator*>(sqlite3_aggregate_context(invocation, sizeof(Accumulator)));
 	    assert(acc->initialized);
 	    acc->value = jsi::Value::undefined();
+	    delete acc->batch;
+	    acc->batch = nullptr;
 	}
 
 	void CustomAggregate::PropagateJSError(sqlite3_context* invocation) {
@@ -10,6 +10,7 @@
 
 #include<stdio.h>
 #include<string>
+#include<vector>
 #include<sqlite3.h>
 #include<JSIHelper.h>
 #include<CustomFunction.h>
@@ -23,6 +24,9 @@ namespace osp {
 	        jsi::Value value;
 	        bool initialized;
 	        bool is_window;
+	        // Arguments of the rows waiting for stepBatch, one column of batchSize values per argument
+	        vector<double>* batch;
+	        int batchRows;
 	};
 
 	class CustomAggregate : public CustomFunction {
@@ -33,6 +37,8 @@ namespace osp {
 	    const std::shared_ptr<jsi::Function> inverse;
 	    const std::shared_ptr<jsi::Function> result;
 	    const std::shared_ptr<jsi::Function> start;
+	    // Rows buffered before fn is called with all of them, 0 calls fn for every row
+	    const int batchSize;
 
 	    explicit CustomAggregate(
 	                             jsi::Runtime& rt,
@@ -43,7 +49,8 @@ namespace osp {
 	                             const bool resultIsFunction,
 	                             const std::shared_ptr<jsi::Function> start,
 	                             const std::shared_ptr<jsi::Function> inverse,
-	                             const std::shared_ptr<jsi::Function> result
+	                             const std::shared_ptr<jsi::Function> result,
+	                             const int batchSize = 0
 	    );
 
 	    static void xStep(sqlite3_context* invocation, int argc, sqlite3_value** argv);
@@ -55,6 +62,8 @@ namespace osp {
 
 	    static inline void xStepBase(sqlite3_context* invocation, int argc, sqlite3_value** argv, const shared_ptr<jsi::Function> ptrtm);
 	    static inline void xValueBase(sqlite3_context* invocation, bool is_final);
+	    static inline void bufferRow(sqlite3_context* invocation, int argc, sqlite3_value** argv);
+	    static inline void flushBatch(sqlite3_context* invocation, Accumulator* acc);
 
 	    Accumulator* GetAccumulator(sqlite3_context* invocation);
 	    static void DestroyAccumulator(sqlite3_context* invocation);
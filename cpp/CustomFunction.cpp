@@ -2,6 +2,7 @@
 #include<sqlite3.h>
 #include "JSIHelper.h"
 #include<CustomFunction.h>
+#include "JSThreadDispatcher.h"
 
 using namespace std;
 using namespace facebook;
@@ -24,49 +25,48 @@ namespace osp {
         delete static_cast<CustomFunction*>(self);
     }
 
-    jsi::Value* CustomFunction::getArguments(jsi::Runtime& rt, sqlite3_value** argv, int argc, jsi::Value* value, const size_t startIndex) {
-        if (value == nullptr) {
-            value = (jsi::Value*) malloc(sizeof(jsi::Value) * argc);
-        }
-        
-        for (int i = startIndex; i < startIndex + argc; i++) {
+    void CustomFunction::getArguments(jsi::Runtime& rt, sqlite3_value** argv, int argc, jsi::Value* values) {
+        for (int i = 0; i < argc; i++) {
             int type = sqlite3_value_type(argv[i]);
             switch (type) {
-                case SQLITE_BLOB:
                 case SQLITE_TEXT:
-                    value[i] = jsi::String::createFromAscii(rt, (char *) sqlite3_value_blob(argv[i]));
+                    values[i] = jsi::String::createFromUtf8(rt, sqlite3_value_text(argv[i]), sqlite3_value_bytes(argv[i]));
+                    break;
+                case SQLITE_BLOB:
+                    values[i] = quickValueToJsiValue(rt, createArrayBufferQuickValue(make_shared<QuickBlob>(sqlite3_value_blob(argv[i]), sqlite3_value_bytes(argv[i]))));
                     break;
                 case SQLITE_INTEGER:
-                    value[i] = sqlite3_value_int(argv[i]);
+                    values[i] = (double) sqlite3_value_int64(argv[i]);
                     break;
                 case SQLITE_FLOAT:
-                    value[i] = sqlite3_value_double(argv[i]);
+                    values[i] = sqlite3_value_double(argv[i]);
                     break;
                 default:
-                    value[i] = nullptr;
+                    values[i] = nullptr;
                     break;
             }
         }
-        
-        return value;
     }
 
     void CustomFunction::xFunc(sqlite3_context* invocation, int argc, sqlite3_value** argv) {
-        CustomFunction* self = (CustomFunction*) sqlite3_user_data(invocation);
-        
-        jsi::Value value[argc];
-        CustomFunction::getArguments(self->rt, argv, argc, value);
-        try {
-            const jsi::Value mayBeResult = self->fn->call(self->rt, value, argc);
-            if (!isEmpty(self->rt, &mayBeResult)) {
-                CustomFunction::jsToSqliteValue(mayBeResult, self->rt, invocation);
-                return;
+        // Queries of executeAsync call the function on a worker, the runtime may only be used from the JS thread
+        JSThreadDispatcher::call([&]() {
+            CustomFunction* self = (CustomFunction*) sqlite3_user_data(invocation);
+
+            vector<jsi::Value> values(argc);
+            CustomFunction::getArguments(self->rt, argv, argc, values.data());
+            try {
+                const jsi::Value mayBeResult = self->fn->call(self->rt, (const jsi::Value*) values.data(), argc);
+                if (!isEmpty(self->rt, &mayBeResult)) {
+                    CustomFunction::jsToSqliteValue(mayBeResult, self->rt, invocation);
+                    return;
+                }
+
+                CustomFunction::PropagateJSError (invocation, "");
+            } catch (const exception& e) {
+                CustomFunction::PropagateJSError (invocation, e.what());
             }
-            
-            CustomFunction::PropagateJSError (invocation, "");
-        } catch (const exception& e) {
-            CustomFunction::PropagateJSError (invocation, e.what());
-        }
+        });
     }
 
 
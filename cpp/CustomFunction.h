@@ -3,6 +3,7 @@
 #define CustomFunction_hpp
 
 #include<string>
+#include<vector>
 #include<sqlite3.h>
 #include "JSIHelper.h"
 
@@ -28,7 +29,8 @@ namespace osp {
         static void xDestroy(void* self);
         static void jsToSqliteValue(const jsi::Value& value, jsi::Runtime& rt, sqlite3_context* invocation);
         static void xFunc(sqlite3_context* invocation, int argc, sqlite3_value** argv);
-        static jsi::Value* getArguments(jsi::Runtime& rt, sqlite3_value** argv, int argc, jsi::Value* value = nullptr, const size_t startIndex = 0);
+        // Fills values, which has room for argc values
+        static void getArguments(jsi::Runtime& rt, sqlite3_value** argv, int argc, jsi::Value* values);
         static jsi::Value copyValue (jsi::Runtime& rt, jsi::Value& value);
     };
 };
@@ -0,0 +1,221 @@
+//
+//  FullTextSearch.cpp
+//  react-native-quick-sqlite
+//
+
+#include "FullTextSearch.h"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+struct RegisteredTokenizer
+{
+  fts5_tokenizer tokenizer;
+  void *context;
+};
+
+mutex tokenizersMutex;
+map<string, RegisteredTokenizer> tokenizers;
+
+void registerFts5Tokenizer(string const &name, fts5_tokenizer tokenizer, void *context)
+{
+  lock_guard<mutex> g(tokenizersMutex);
+  tokenizers[name] = RegisteredTokenizer{tokenizer, context};
+}
+
+/**
+ * The documented way to reach the FTS5 API of a connection, null when FTS5 is not compiled in
+ */
+fts5_api *fts5_api_from_db(sqlite3 *db)
+{
+  fts5_api *api = nullptr;
+  sqlite3_stmt *statement = nullptr;
+  if (sqlite3_prepare_v2(db, "SELECT fts5(?1)", -1, &statement, nullptr) == SQLITE_OK)
+  {
+    sqlite3_bind_pointer(statement, 1, (void *)&api, "fts5_api_ptr", nullptr);
+    sqlite3_step(statement);
+  }
+  sqlite3_finalize(statement);
+  return api;
+}
+
+// Byte range of every token of a column, indexed by token position
+int collect_token_range(void *context, int flags, const char *token, int tokenLength, int start, int end)
+{
+  // Synonyms share the position of the token before them
+  if ((flags & FTS5_TOKEN_COLOCATED) == 0)
+  {
+    static_cast<vector<pair<int, int>> *>(context)->push_back(make_pair(start, end));
+  }
+  return SQLITE_OK;
+}
+
+/**
+ * Converts sorted byte offsets of UTF-8 text into offsets in UTF-16 code units, the unit of JS strings
+ */
+void utf8_to_utf16_offsets(const char *text, int length, vector<int> const &byteOffsets, vector<int> *utf16Offsets)
+{
+  int bytePosition = 0;
+  int utf16Position = 0;
+  for (int byteOffset : byteOffsets)
+  {
+    for (; bytePosition < byteOffset && bytePosition < length; bytePosition++)
+    {
+      unsigned char c = (unsigned char)text[bytePosition];
+      // Continuation bytes are part of a character already counted, a 4 byte character is a surrogate pair
+      if ((c & 0xC0) != 0x80)
+      {
+        utf16Position += c >= 0xF0 ? 2 : 1;
+      }
+    }
+    utf16Offsets->push_back(utf16Position);
+  }
+}
+
+/**
+ * match_offsets(table): a BLOB of 32-bit integers, a (column, start, end) triple per phrase matched in the row,
+ * ordered by column and start. Offsets are in UTF-16 code units, they can be used on the JS strings of the columns
+ */
+void match_offsets(const Fts5ExtensionApi *api, Fts5Context *fts, sqlite3_context *context, int argc, sqlite3_value **argv)
+{
+  int instanceCount = 0;
+  int exit = api->xInstCount(fts, &instanceCount);
+  if (exit != SQLITE_OK)
+  {
+    sqlite3_result_error_code(context, exit);
+    return;
+  }
+
+  // (column, first token, last token) of every instance
+  vector<int> instances;
+  instances.reserve(instanceCount * 3);
+  for (int i = 0; i < instanceCount; i++)
+  {
+    int phrase, column, offset;
+    exit = api->xInst(fts, i, &phrase, &column, &offset);
+    if (exit != SQLITE_OK)
+    {
+      sqlite3_result_error_code(context, exit);
+      return;
+    }
+    instances.push_back(column);
+    instances.push_back(offset);
+    instances.push_back(offset + max(1, api->xPhraseSize(fts, phrase)) - 1);
+  }
+
+  vector<int32_t> offsets;
+  offsets.reserve(instanceCount * 3);
+  vector<pair<int, int>> tokenRanges;
+  vector<int> byteOffsets;
+  vector<int> utf16Offsets;
+  vector<pair<int, int>> columnRanges;
+
+  const int columnCount = api->xColumnCount(fts);
+  for (int column = 0; column < columnCount; column++)
+  {
+    columnRanges.clear();
+    for (size_t i = 0; i < instances.size(); i += 3)
+    {
+      if (instances[i] == column)
+      {
+        columnRanges.push_back(make_pair(instances[i + 1], instances[i + 2]));
+      }
+    }
+    if (columnRanges.empty())
+    {
+      continue;
+    }
+
+    const char *text = nullptr;
+    int length = 0;
+    exit = api->xColumnText(fts, column, &text, &length);
+    if (exit != SQLITE_OK)
+    {
+      sqlite3_result_error_code(context, exit);
+      return;
+    }
+    // Contentless tables have no text to point into
+    if (text == nullptr)
+    {
+      continue;
+    }
+
+    tokenRanges.clear();
+    exit = api->xTokenize(fts, text, length, &tokenRanges, collect_token_range);
+    if (exit != SQLITE_OK)
+    {
+      sqlite3_result_error_code(context, exit);
+      return;
+    }
+
+    byteOffsets.clear();
+    for (auto &range : columnRanges)
+    {
+      if (range.second < (int)tokenRanges.size())
+      {
+        byteOffsets.push_back(tokenRanges[range.first].first);
+        byteOffsets.push_back(tokenRanges[range.second].second);
+      }
+    }
+    vector<int> sortedByteOffsets = byteOffsets;
+    sort(sortedByteOffsets.begin(), sortedByteOffsets.end());
+    sortedByteOffsets.erase(unique(sortedByteOffsets.begin(), sortedByteOffsets.end()), sortedByteOffsets.end());
+    utf16Offsets.clear();
+    utf8_to_utf16_offsets(text, length, sortedByteOffsets, &utf16Offsets);
+
+    auto toUtf16 = [&](int byteOffset)
+    {
+      return utf16Offsets[lower_bound(sortedByteOffsets.begin(), sortedByteOffsets.end(), byteOffset) - sortedByteOffsets.begin()];
+    };
+    vector<pair<int, int>> matches;
+    for (size_t i = 0; i < byteOffsets.size(); i += 2)
+    {
+      matches.push_back(make_pair(toUtf16(byteOffsets[i]), toUtf16(byteOffsets[i + 1])));
+    }
+    sort(matches.begin(), matches.end());
+    for (auto &match : matches)
+    {
+      offsets.push_back(column);
+      offsets.push_back(match.first);
+      offsets.push_back(match.second);
+    }
+  }
+
+  if (offsets.empty())
+  {
+    sqlite3_result_zeroblob(context, 0);
+    return;
+  }
+  sqlite3_result_blob(context, offsets.data(), (int)(offsets.size() * sizeof(int32_t)), SQLITE_TRANSIENT);
+}
+
+int registerFullTextSearch(sqlite3 *db)
+{
+  fts5_api *api = fts5_api_from_db(db);
+  if (api == nullptr)
+  {
+    return SQLITE_OK;
+  }
+
+  int exit = api->xCreateFunction(api, "match_offsets", nullptr, match_offsets, nullptr);
+  if (exit != SQLITE_OK)
+  {
+    return exit;
+  }
+
+  lock_guard<mutex> g(tokenizersMutex);
+  for (auto &tokenizer : tokenizers)
+  {
+    exit = api->xCreateTokenizer(api, tokenizer.first.c_str(), tokenizer.second.context, &tokenizer.second.tokenizer, nullptr);
+    if (exit != SQLITE_OK)
+    {
+      return exit;
+    }
+  }
+  return SQLITE_OK;
+}
@@ -0,0 +1,29 @@
+//
+//  FullTextSearch.h
+//  react-native-quick-sqlite
+//
+//  FTS5 tokenizers registered natively by the app and auxiliary functions returning match offsets
+//
+
+#ifndef FullTextSearch_h
+#define FullTextSearch_h
+
+#include <string>
+#include <sqlite3.h>
+
+using namespace std;
+
+/**
+ * Makes a native FTS5 tokenizer available under name to the connections opened afterwards, so it
+ * MUST be registered before opening the databases using it. context is passed to tokenizer.xCreate
+ * and has to stay valid for the lifetime of the app. Registering a name again replaces the tokenizer
+ */
+void registerFts5Tokenizer(string const &name, fts5_tokenizer tokenizer, void *context);
+
+/**
+ * Registers the app tokenizers and the match_offsets auxiliary function on the connection.
+ * Does nothing when SQLite was built without FTS5, returns the SQLite status code of the first registration that failed
+ */
+int registerFullTextSearch(sqlite3 *db);
+
+#endif /* FullTextSearch_h */
@@ -0,0 +1,277 @@
+//
+//  IncrementalBlob.cpp
+//  react-native-quick-sqlite
+//
+
+#include "IncrementalBlob.h"
+#include "macros.h"
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  struct BlobRange
+  {
+    int offset;
+    int length;
+  };
+
+  double getIndexArgument(jsi::Runtime &rt, const string &method, const jsi::Value *args, size_t count, size_t index)
+  {
+    if (count <= index || !args[index].isNumber() || !(args[index].getNumber() >= 0) || args[index].getNumber() > INT_MAX || floor(args[index].getNumber()) != args[index].getNumber())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][" + method + "] offset and length must be positive integers");
+    }
+    return args[index].getNumber();
+  }
+
+  /**
+   * Checks a range against the current size of the blob, SQLite can't read or write past its end
+   */
+  BlobRange getBlobRange(jsi::Runtime &rt, shared_ptr<BlobHandle> handle, const string &method, double offset, double length)
+  {
+    int size = 0;
+    auto status = sqliteBlobSize(handle, &size);
+    if (status.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, status.errorMessage);
+    }
+
+    BlobRange range = {(int)offset, (int)length};
+    if ((long long)range.offset + range.length > size)
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][" + method + "] range ends after the " + to_string(size) + " bytes of the blob");
+    }
+    return range;
+  }
+
+  jsi::ArrayBuffer getBufferArgument(jsi::Runtime &rt, const string &method, const jsi::Value *args, size_t count, size_t index)
+  {
+    if (count <= index || !args[index].isObject() || !args[index].asObject(rt).isArrayBuffer(rt))
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][" + method + "] buffer must be an ArrayBuffer");
+    }
+    return args[index].asObject(rt).getArrayBuffer(rt);
+  }
+
+  /**
+   * The ArrayBuffer data read from or written into, it has to hold at least length bytes
+   */
+  uint8_t *getBufferData(jsi::Runtime &rt, const string &method, jsi::ArrayBuffer buffer, int length)
+  {
+    if (buffer.size(rt) < (size_t)length)
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][" + method + "] buffer is smaller than the length");
+    }
+    return buffer.data(rt);
+  }
+
+  /**
+   * Range of write(offset, buffer, length?), length defaults to the whole buffer
+   */
+  BlobRange getWriteRange(jsi::Runtime &rt, shared_ptr<BlobHandle> handle, const string &method, const jsi::Value *args, size_t count)
+  {
+    const double offset = getIndexArgument(rt, method, args, count, 0);
+    auto buffer = getBufferArgument(rt, method, args, count, 1);
+    const double length = count > 2 && !args[2].isUndefined() ? getIndexArgument(rt, method, args, count, 2) : (double)buffer.size(rt);
+    return getBlobRange(rt, handle, method, offset, length);
+  }
+
+  void throwIfError(jsi::Runtime &rt, SQLiteOPResult const &status)
+  {
+    if (status.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, status.errorMessage);
+    }
+  }
+
+  IncrementalBlob::IncrementalBlob(
+                                   shared_ptr<BlobHandle> handle,
+                                   ExecutorProvider getExecutor,
+                                   shared_ptr<react::CallInvoker> invoker
+                                   ) :
+  handle(handle),
+  getExecutor(getExecutor),
+  invoker(invoker)
+  {
+  }
+
+  IncrementalBlob::~IncrementalBlob()
+  {
+    sqliteBlobClose(handle);
+  }
+
+  vector<jsi::PropNameID> IncrementalBlob::getPropertyNames(jsi::Runtime &rt)
+  {
+    vector<jsi::PropNameID> names;
+    names.push_back(jsi::PropNameID::forAscii(rt, "size"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "read"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "readAsync"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "write"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "writeAsync"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "reopen"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "close"));
+    return names;
+  }
+
+  jsi::Value IncrementalBlob::get(jsi::Runtime &rt, const jsi::PropNameID &propNameId)
+  {
+    auto name = propNameId.utf8(rt);
+    // The returned functions can outlive this object, they only hold on to the shared state
+    auto handle = this->handle;
+    auto getExecutor = this->getExecutor;
+    auto invoker = this->invoker;
+
+    if (name == "size")
+    {
+      int size = 0;
+      throwIfError(rt, sqliteBlobSize(handle, &size));
+      return jsi::Value(size);
+    }
+
+    // read(offset, length, buffer?): the bytes are written into buffer, or into a new ArrayBuffer without it
+    if (name == "read")
+    {
+      return HOSTFN("read", 3) {
+        const BlobRange range = getBlobRange(rt, handle, "read", getIndexArgument(rt, "read", args, count, 0), getIndexArgument(rt, "read", args, count, 1));
+        if (count > 2 && !args[2].isUndefined())
+        {
+          uint8_t *target = getBufferData(rt, "read", getBufferArgument(rt, "read", args, count, 2), range.length);
+          throwIfError(rt, sqliteBlobRead(handle, target, range.length, range.offset));
+          return jsi::Value(rt, args[2]);
+        }
+
+        auto blob = make_shared<QuickBlob>((size_t)range.length);
+        throwIfError(rt, sqliteBlobRead(handle, blob->data(), range.length, range.offset));
+        return quickValueToJsiValue(rt, createArrayBufferQuickValue(blob));
+      });
+    }
+
+    if (name == "readAsync")
+    {
+      return HOSTFN("readAsync", 3) {
+        const BlobRange range = getBlobRange(rt, handle, "readAsync", getIndexArgument(rt, "readAsync", args, count, 0), getIndexArgument(rt, "readAsync", args, count, 1));
+
+        // Read into native memory, the given buffer is only filled in the JS thread once the read is done
+        shared_ptr<jsi::Value> buffer;
+        if (count > 2 && !args[2].isUndefined())
+        {
+          getBufferData(rt, "readAsync", getBufferArgument(rt, "readAsync", args, count, 2), range.length);
+          buffer = make_shared<jsi::Value>(rt, args[2]);
+        }
+        auto blob = make_shared<QuickBlob>((size_t)range.length);
+
+        auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+        auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+          auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+          auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+          auto task =
+          [&rt, handle, invoker, range, buffer, blob, resolve, reject]()
+          {
+            auto status = sqliteBlobRead(handle, blob->data(), range.length, range.offset);
+            invoker->invokeAsync([&rt, status_copy = move(status), buffer, blob, resolve, reject]
+                                 {
+              if(status_copy.type == SQLiteOk && buffer != nullptr) {
+                // Looked up again, JS may have detached or replaced it meanwhile
+                auto arrayBuffer = buffer->asObject(rt).getArrayBuffer(rt);
+                if (arrayBuffer.size(rt) < blob->size()) {
+                  auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+                  auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, "[react-native-quick-sqlite][readAsync] buffer is smaller than the length"));
+                  reject->asObject(rt).asFunction(rt).call(rt, error);
+                  return;
+                }
+                memcpy(arrayBuffer.data(rt), blob->data(), blob->size());
+                resolve->asObject(rt).asFunction(rt).call(rt, jsi::Value(rt, *buffer));
+              } else if(status_copy.type == SQLiteOk) {
+                resolve->asObject(rt).asFunction(rt).call(rt, quickValueToJsiValue(rt, createArrayBufferQuickValue(blob)));
+              } else {
+                auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+                auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+                reject->asObject(rt).asFunction(rt).call(rt, error);
+              }
+            });
+          };
+
+          getExecutor()->queueWork(task);
+
+          return {};
+        }));
+
+        return promise;
+      });
+    }
+
+    if (name == "write")
+    {
+      return HOSTFN("write", 3) {
+        const BlobRange range = getWriteRange(rt, handle, "write", args, count);
+        const uint8_t *source = getBufferData(rt, "write", getBufferArgument(rt, "write", args, count, 1), range.length);
+        throwIfError(rt, sqliteBlobWrite(handle, source, range.length, range.offset));
+        return {};
+      });
+    }
+
+    if (name == "writeAsync")
+    {
+      return HOSTFN("writeAsync", 3) {
+        const BlobRange range = getWriteRange(rt, handle, "writeAsync", args, count);
+        // Copied, the JS engine may move or collect the buffer once the call returns
+        auto source = make_shared<QuickBlob>(getBufferData(rt, "writeAsync", getBufferArgument(rt, "writeAsync", args, count, 1), range.length), (size_t)range.length);
+
+        auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+        auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+          auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+          auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+          auto task =
+          [&rt, handle, invoker, range, source, resolve, reject]()
+          {
+            auto status = sqliteBlobWrite(handle, source->data(), range.length, range.offset);
+            invoker->invokeAsync([&rt, status_copy = move(status), resolve, reject]
+                                 {
+              if(status_copy.type == SQLiteOk) {
+                resolve->asObject(rt).asFunction(rt).call(rt, jsi::Value::undefined());
+              } else {
+                auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+                auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+                reject->asObject(rt).asFunction(rt).call(rt, error);
+              }
+            });
+          };
+
+          getExecutor()->queueWork(task);
+
+          return {};
+        }));
+
+        return promise;
+      });
+    }
+
+    if (name == "reopen")
+    {
+      return HOSTFN("reopen", 1) {
+        if (count == 0 || !args[0].isNumber())
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][reopen] rowId must be a number");
+        }
+        throwIfError(rt, sqliteBlobReopen(handle, (long long)args[0].getNumber()));
+        return {};
+      });
+    }
+
+    if (name == "close")
+    {
+      return HOSTFN("close", 0) {
+        sqliteBlobClose(handle);
+        return {};
+      });
+    }
+
+    return jsi::Value::undefined();
+  }
+}
@@ -0,0 +1,39 @@
+//
+//  IncrementalBlob.h
+//  react-native-quick-sqlite
+//
+//  JSI HostObject reading and writing ranges of a blob in place, large values never have to be held in memory at once
+//
+
+#ifndef IncrementalBlob_h
+#define IncrementalBlob_h
+
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+#include "sqliteBridge.h"
+#include "SerialExecutor.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  class IncrementalBlob : public jsi::HostObject {
+  public:
+    IncrementalBlob(
+                    shared_ptr<BlobHandle> handle,
+                    ExecutorProvider getExecutor,
+                    shared_ptr<react::CallInvoker> invoker
+                    );
+    ~IncrementalBlob();
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &propNameId) override;
+    vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+  private:
+    shared_ptr<BlobHandle> handle;
+    ExecutorProvider getExecutor;
+    shared_ptr<react::CallInvoker> invoker;
+  };
+}
+
+#endif /* IncrementalBlob_h */
@@ -7,6 +7,9 @@
 
 #include "JSIHelper.h"
 #include "sqlite3.h"
+#include "LazyResultSet.h"
+#include <algorithm>
+#include <cmath>
 
 using namespace std;
 using namespace facebook;
@@ -59,12 +62,50 @@ QuickValue createDoubleQuickValue(double value)
     .doubleOrIntValue = value};
 }
 
-QuickValue createArrayBufferQuickValue(uint8_t *arrayBufferValue, size_t arrayBufferSize)
+QuickValue createArrayBufferQuickValue(shared_ptr<QuickBlob> arrayBufferValue)
 {
   return QuickValue{
     .dataType = ARRAY_BUFFER,
-    .arrayBufferValue = shared_ptr<uint8_t>{arrayBufferValue},
-    .arrayBufferSize = arrayBufferSize};
+    .arrayBufferValue = arrayBufferValue};
+}
+
+QuickBlob::QuickBlob(const void *data, size_t size) : storage(size), length(size)
+{
+  if (size > 0)
+  {
+    memcpy(storage.data(), data, size);
+  }
+  bytes = storage.data();
+}
+
+QuickBlob::QuickBlob(size_t size) : storage(size), length(size)
+{
+  bytes = storage.data();
+}
+
+shared_ptr<QuickBlob> QuickBlob::borrow(uint8_t *data, size_t size)
+{
+  shared_ptr<QuickBlob> blob(new QuickBlob());
+  blob->bytes = data;
+  blob->length = size;
+  return blob;
+}
+
+size_t QuickBlob::size() const
+{
+  return length;
+}
+
+uint8_t *QuickBlob::data()
+{
+  return bytes;
+}
+
+jsi::Value createFloat64Array(jsi::Runtime &rt, const double *values, size_t count)
+{
+  jsi::Value buffer = quickValueToJsiValue(rt, createArrayBufferQuickValue(make_shared<QuickBlob>(values, count * sizeof(double))));
+  jsi::Function float64ArrayCtor = rt.global().getPropertyAsFunction(rt, "Float64Array");
+  return float64ArrayCtor.callAsConstructor(rt, buffer);
 }
 
 int createSQLiteFunctionOptions(bool DETERMINISTIC, bool DIRECTONLY, bool INNOCUOUS, bool SUBTYPE) {
@@ -76,67 +117,371 @@ int createSQLiteFunctionOptions(bool DETERMINISTIC, bool DIRECTONLY, bool INNOCU
   return mask;
 }
 
-void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &params, vector<QuickValue> *target)
+void QuickParams::addNull()
+{
+  QuickParam param = {};
+  param.type = PARAM_NULL;
+  values.push_back(param);
+}
+
+void QuickParams::addInt64(long long value)
+{
+  QuickParam param = {};
+  param.type = PARAM_INT64;
+  param.int64Value = value;
+  values.push_back(param);
+}
+
+void QuickParams::addDouble(double value)
+{
+  QuickParam param = {};
+  param.type = PARAM_DOUBLE;
+  param.doubleValue = value;
+  values.push_back(param);
+}
+
+void QuickParams::addText(const char *text, size_t length)
+{
+  QuickParam param = {};
+  param.type = PARAM_TEXT;
+  param.text.offset = (uint32_t)arena.size();
+  param.text.length = (uint32_t)length;
+  arena.append(text, length);
+  values.push_back(param);
+}
+
+void QuickParams::addText(string const &text)
+{
+  addText(text.data(), text.size());
+}
+
+void QuickParams::addBlob(shared_ptr<QuickBlob> blob)
+{
+  QuickParam param = {};
+  param.type = PARAM_BLOB;
+  param.blobIndex = (uint32_t)blobs.size();
+  blobs.push_back(move(blob));
+  values.push_back(param);
+}
+
+void QuickParams::setLastName(string const &name)
+{
+  QuickParam &param = values.back();
+  param.nameOffset = (uint32_t)arena.size();
+  param.nameLength = (uint32_t)name.size();
+  arena.append(name);
+}
+
+size_t QuickParams::size() const
+{
+  return values.size();
+}
+
+bool QuickParams::empty() const
+{
+  return values.empty();
+}
+
+void QuickParams::clear()
+{
+  values.clear();
+  arena.clear();
+  blobs.clear();
+}
+
+// Doubles are exact integers up to 2^53, beyond that an integral double still fits an int64 below 2^63
+#define INT64_DOUBLE_LIMIT 9223372036854775808.0
+
+void jsiValueToQuickParam(jsi::Runtime &rt, jsi::Value const &value, QuickParams *target, bool borrowBuffers)
+{
+  if (value.isNull() || value.isUndefined())
+  {
+    target->addNull();
+  }
+  else if (value.isBool())
+  {
+    target->addInt64(value.getBool() ? 1 : 0);
+  }
+  else if (value.isNumber())
+  {
+    double doubleVal = value.asNumber();
+    if (doubleVal == trunc(doubleVal) && doubleVal >= -INT64_DOUBLE_LIMIT && doubleVal < INT64_DOUBLE_LIMIT)
+    {
+      target->addInt64((long long)doubleVal);
+    }
+    else
+    {
+      target->addDouble(doubleVal);
+    }
+  }
+  else if (value.isBigInt())
+  {
+    // Throws for values outside of the int64 range instead of silently wrapping them
+    target->addInt64(value.getBigInt(rt).asInt64(rt));
+  }
+  else if (value.isString())
+  {
+    string strVal = value.asString(rt).utf8(rt);
+    target->addText(strVal);
+  }
+  else if (value.isObject() && value.asObject(rt).isArrayBuffer(rt))
+  {
+    auto buf = value.asObject(rt).getArrayBuffer(rt);
+    // The JS engine may move or collect the buffer once the call returns, async work needs its own copy
+    target->addBlob(borrowBuffers ? QuickBlob::borrow(buf.data(rt), buf.size(rt)) : make_shared<QuickBlob>(buf.data(rt), buf.size(rt)));
+  }
+  else
+  {
+    target->addNull();
+  }
+}
+
+void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &params, QuickParams *target, bool borrowBuffers)
 {
   if (params.isNull() || params.isUndefined())
   {
     return;
   }
 
-  jsi::Array values = params.asObject(rt).asArray(rt);
-
-  for (int ii = 0; ii < values.length(rt); ii++)
+  jsi::Object object = params.asObject(rt);
+  if (object.isArray(rt))
   {
-
-    jsi::Value value = values.getValueAtIndex(rt, ii);
-    if (value.isNull() || value.isUndefined())
+    jsi::Array values = object.asArray(rt);
+    size_t length = values.length(rt);
+    target->values.reserve(target->values.size() + length);
+    for (size_t ii = 0; ii < length; ii++)
     {
-      target->push_back(createNullQuickValue());
+      jsiValueToQuickParam(rt, values.getValueAtIndex(rt, ii), target, borrowBuffers);
     }
-    else if (value.isBool())
+    return;
+  }
+
+  // Named parameters, the keys are matched against the names used in the statement
+  jsi::Array names = object.getPropertyNames(rt);
+  size_t length = names.length(rt);
+  target->values.reserve(target->values.size() + length);
+  for (size_t ii = 0; ii < length; ii++)
+  {
+    string name = names.getValueAtIndex(rt, ii).asString(rt).utf8(rt);
+    if (name.empty())
     {
-      target->push_back(createBooleanQuickValue(value.getBool()));
+      throw jsi::JSError(rt, "[react-native-quick-sqlite] Named parameters cannot have an empty name");
     }
-    else if (value.isNumber())
+    jsiValueToQuickParam(rt, object.getProperty(rt, name.c_str()), target, borrowBuffers);
+    target->setLastName(name);
+  }
+}
+
+/**
+ * Reads a PRAGMA keyword option, the value is checked against the allowed ones since it ends up in the statement
+ */
+string jsiOpenOptionToPragmaValue(jsi::Runtime &rt, jsi::Object &values, const char *name, vector<string> const &allowed)
+{
+  jsi::Value value = values.getProperty(rt, name);
+  if (value.isUndefined() || value.isNull())
+  {
+    return "";
+  }
+
+  string keyword = value.isString() ? value.asString(rt).utf8(rt) : "";
+  transform(keyword.begin(), keyword.end(), keyword.begin(), ::toupper);
+  if (find(allowed.begin(), allowed.end(), keyword) == allowed.end())
+  {
+    throw jsi::JSError(rt, "[react-native-quick-sqlite][open] Invalid " + string(name) + " option");
+  }
+  return keyword;
+}
+
+void jsiOpenOptionsToSQLiteOpenOptions(jsi::Runtime &rt, jsi::Value const &options, SQLiteOpenOptions *target)
+{
+  if (options.isNull() || options.isUndefined())
+  {
+    return;
+  }
+
+  jsi::Object values = options.asObject(rt);
+
+  jsi::Value statementCacheSize = values.getProperty(rt, "statementCacheSize");
+  if (statementCacheSize.isNumber())
+  {
+    double size = statementCacheSize.asNumber();
+    target->statementCacheSize = size > 0 ? (size_t)size : 0;
+  }
+
+  jsi::Value readerConnections = values.getProperty(rt, "readerConnections");
+  if (readerConnections.isNumber())
+  {
+    double connections = readerConnections.asNumber();
+    target->readerConnections = connections > 0 ? (size_t)connections : 0;
+  }
+
+  jsi::Value assetPath = values.getProperty(rt, "assetPath");
+  if (assetPath.isString())
+  {
+    target->assetPath = assetPath.asString(rt).utf8(rt);
+  }
+
+  jsi::Value mmapSize = values.getProperty(rt, "mmapSize");
+  if (mmapSize.isNumber())
+  {
+    double size = mmapSize.asNumber();
+    target->mmapSize = size >= 0 ? (long long)size : -1;
+  }
+
+  jsi::Value profile = values.getProperty(rt, "profile");
+  if (profile.isBool())
+  {
+    target->profile = profile.getBool();
+  }
+
+  jsi::Value bigInt = values.getProperty(rt, "bigInt");
+  if (bigInt.isBool())
+  {
+    target->bigInt = bigInt.getBool();
+  }
+
+  target->journalMode = jsiOpenOptionToPragmaValue(rt, values, "journalMode", {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"});
+  target->synchronous = jsiOpenOptionToPragmaValue(rt, values, "synchronous", {"OFF", "NORMAL", "FULL", "EXTRA"});
+  target->tempStore = jsiOpenOptionToPragmaValue(rt, values, "tempStore", {"DEFAULT", "FILE", "MEMORY"});
+  if (target->readerConnections > 0 && !target->journalMode.empty() && target->journalMode != "WAL")
+  {
+    throw jsi::JSError(rt, "[react-native-quick-sqlite][open] readerConnections need journalMode 'WAL'");
+  }
+
+  jsi::Value cacheSize = values.getProperty(rt, "cacheSize");
+  if (cacheSize.isNumber())
+  {
+    target->cacheSize = (long long)cacheSize.asNumber();
+  }
+
+  jsi::Value busyTimeout = values.getProperty(rt, "busyTimeout");
+  if (busyTimeout.isNumber())
+  {
+    double timeout = busyTimeout.asNumber();
+    target->busyTimeout = timeout >= 0 ? (int)timeout : -1;
+  }
+
+  jsi::Value pageSize = values.getProperty(rt, "pageSize");
+  if (pageSize.isNumber())
+  {
+    int size = (int)pageSize.asNumber();
+    // SQLite only accepts powers of two between 512 and 65536
+    if (size < 512 || size > 65536 || (size & (size - 1)) != 0)
     {
-      double doubleVal = value.asNumber();
-      int intVal = (int)doubleVal;
-      long long longVal = (long)doubleVal;
-      if (intVal == doubleVal)
-      {
-        target->push_back(createIntegerQuickValue(intVal));
-      }
-      else if (longVal == doubleVal)
-      {
-        target->push_back(createInt64QuickValue(longVal));
-      }
-      else
-      {
-        target->push_back(createDoubleQuickValue(doubleVal));
-      }
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][open] pageSize must be a power of two between 512 and 65536");
     }
-    else if (value.isString())
+    target->pageSize = size;
+  }
+}
+
+QuickResultFormat jsiQueryOptionsToResultFormat(jsi::Runtime &rt, jsi::Value const &options)
+{
+  if (!options.isObject())
+  {
+    return RESULT_OBJECTS;
+  }
+
+  jsi::Value format = options.asObject(rt).getProperty(rt, "resultFormat");
+  if (!format.isString())
+  {
+    return RESULT_OBJECTS;
+  }
+
+  string formatName = format.asString(rt).utf8(rt);
+  if (formatName == "arrays")
+  {
+    return RESULT_ARRAYS;
+  }
+  if (formatName == "columns")
+  {
+    return RESULT_COLUMNS;
+  }
+  if (formatName == "lazy")
+  {
+    return RESULT_LAZY;
+  }
+  return RESULT_OBJECTS;
+}
+
+jsi::Value quickValueToJsiValue(jsi::Runtime &rt, QuickValue const &value)
+{
+  if (value.dataType == TEXT)
+  {
+    // using value.textValue (std::string) directly allows jsi::String to use length property of std::string (allowing strings with NULLs in them like SQLite does)
+    return jsi::String::createFromUtf8(rt, value.textValue);
+  }
+  else if (value.dataType == INTEGER || value.dataType == DOUBLE)
+  {
+    return jsi::Value(value.doubleOrIntValue);
+  }
+  else if (value.dataType == INT64)
+  {
+    return jsi::BigInt::fromInt64(rt, value.int64Value);
+  }
+  else if (value.dataType == ARRAY_BUFFER)
+  {
+#ifdef QUICK_SQLITE_MUTABLE_BUFFER
+    // The ArrayBuffer shares ownership of the native bytes, nothing is copied
+    return jsi::ArrayBuffer(rt, value.arrayBufferValue);
+#else
+    jsi::Function array_buffer_ctor = rt.global().getPropertyAsFunction(rt, "ArrayBuffer");
+    jsi::Object o = array_buffer_ctor.callAsConstructor(rt, (int)value.arrayBufferValue->size()).getObject(rt);
+    jsi::ArrayBuffer buf = o.getArrayBuffer(rt);
+    // It's a shame we have to copy here: see https://github.com/facebook/hermes/pull/419 and https://github.com/facebook/hermes/issues/564.
+    memcpy(buf.data(rt), value.arrayBufferValue->data(), value.arrayBufferValue->size());
+    return move(o);
+#endif
+  }
+
+  return jsi::Value(nullptr);
+}
+
+/**
+ * One array per column, columns holding only numbers are sent as a Float64Array
+ */
+jsi::Array createColumnValues(jsi::Runtime &rt, QuickResultSet *results)
+{
+  size_t columnCount = results->columnNames.size();
+  size_t rowCount = results->rowCount;
+  auto columnValues = jsi::Array(rt, columnCount);
+  auto array_buffer_ctor = rt.global().getPropertyAsFunction(rt, "ArrayBuffer");
+  auto float64_array_ctor = rt.global().getPropertyAsFunction(rt, "Float64Array");
+
+  for (size_t c = 0; c < columnCount; c++)
+  {
+    bool isNumeric = true;
+    for (size_t r = 0; r < rowCount && isNumeric; r++)
     {
-      string strVal = value.asString(rt).utf8(rt);
-      target->push_back(createTextQuickValue(strVal));
+      QuickDataType dataType = results->cells[r * columnCount + c].dataType;
+      isNumeric = dataType == INTEGER || dataType == DOUBLE;
     }
-    else if (value.isObject())
+
+    if (isNumeric)
     {
-      auto obj = value.asObject(rt);
-      if (obj.isArrayBuffer(rt))
+      jsi::Object o = array_buffer_ctor.callAsConstructor(rt, (int)(rowCount * sizeof(double))).getObject(rt);
+      jsi::ArrayBuffer buf = o.getArrayBuffer(rt);
+      double *data = reinterpret_cast<double *>(buf.data(rt));
+      for (size_t r = 0; r < rowCount; r++)
       {
-        auto buf = obj.getArrayBuffer(rt);
-        target->push_back(createArrayBufferQuickValue(buf.data(rt), buf.size(rt)));
+        data[r] = results->cells[r * columnCount + c].doubleOrIntValue;
       }
+      columnValues.setValueAtIndex(rt, c, float64_array_ctor.callAsConstructor(rt, move(o)));
     }
     else
     {
-      target->push_back(createNullQuickValue());
+      auto values = jsi::Array(rt, rowCount);
+      for (size_t r = 0; r < rowCount; r++)
+      {
+        values.setValueAtIndex(rt, r, quickValueToJsiValue(rt, results->cells[r * columnCount + c]));
+      }
+      columnValues.setValueAtIndex(rt, c, move(values));
     }
   }
+
+  return columnValues;
 }
 
-jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, vector<map<string, QuickValue>> *results, vector<QuickColumnMetadata> *metadata)
+jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, QuickResultSet *results, vector<QuickColumnMetadata> *metadata, QuickResultFormat format)
 {
   if(status.type == SQLiteError) {
     throw std::invalid_argument(status.errorMessage);
@@ -150,50 +495,69 @@ jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult sta
     res.setProperty(rt, "insertId", jsi::Value(status.insertId));
   }
 
-  // Converting row results into objects
-  size_t rowCount = results->size();
+  size_t rowCount = results->rowCount;
+  size_t columnCount = results->columnNames.size();
+
+  if (format != RESULT_OBJECTS && format != RESULT_LAZY)
+  {
+    auto columns = jsi::Array(rt, columnCount);
+    for (size_t c = 0; c < columnCount; c++)
+    {
+      columns.setValueAtIndex(rt, c, jsi::String::createFromUtf8(rt, results->columnNames[c]));
+    }
+    res.setProperty(rt, "columns", move(columns));
+  }
+
+  if (format == RESULT_COLUMNS)
+  {
+    res.setProperty(rt, "columnValues", createColumnValues(rt, results));
+  }
+
+  if (format == RESULT_LAZY)
+  {
+    auto lazyRows = make_shared<osp::LazyRows>(make_shared<QuickResultSet>(move(*results)));
+    res.setProperty(rt, "rows", jsi::Object::createFromHostObject(rt, lazyRows));
+  }
+
+  // Converting row results into objects or arrays
   jsi::Object rows = jsi::Object(rt);
-  if (rowCount > 0)
+  if (rowCount > 0 && format != RESULT_COLUMNS && format != RESULT_LAZY)
   {
+    // Property names are created once per column instead of once per cell
+    vector<jsi::PropNameID> columnNames;
+    if (format == RESULT_OBJECTS)
+    {
+      for (auto const &name : results->columnNames)
+      {
+        columnNames.push_back(jsi::PropNameID::forUtf8(rt, name));
+      }
+    }
+
     auto array = jsi::Array(rt, rowCount);
-    for (int i = 0; i < rowCount; i++)
+    for (size_t i = 0; i < rowCount; i++)
     {
-      jsi::Object rowObject = jsi::Object(rt);
-      auto row = results->at(i);
-      for (auto const &entry : row)
+      const QuickValue *row = &results->cells[i * columnCount];
+      if (format == RESULT_OBJECTS)
       {
-        std::string columnName = entry.first;
-        QuickValue value = entry.second;
-        if (value.dataType == TEXT)
-        {
-          // using value.textValue (std::string) directly allows jsi::String to use length property of std::string (allowing strings with NULLs in them like SQLite does)
-          rowObject.setProperty(rt, columnName.c_str(), jsi::String::createFromUtf8(rt, value.textValue));
-        }
-        else if (value.dataType == INTEGER)
-        {
-          rowObject.setProperty(rt, columnName.c_str(), jsi::Value(value.doubleOrIntValue));
-        }
-        else if (value.dataType == DOUBLE)
-        {
-          rowObject.setProperty(rt, columnName.c_str(), jsi::Value(value.doubleOrIntValue));
-        }
-        else if (value.dataType == ARRAY_BUFFER)
+        jsi::Object rowObject = jsi::Object(rt);
+        for (size_t c = 0; c < columnCount; c++)
         {
-          jsi::Function array_buffer_ctor = rt.global().getPropertyAsFunction(rt, "ArrayBuffer");
-          jsi::Object o = array_buffer_ctor.callAsConstructor(rt, (int)value.arrayBufferSize).getObject(rt);
-          jsi::ArrayBuffer buf = o.getArrayBuffer(rt);
-          // It's a shame we have to copy here: see https://github.com/facebook/hermes/pull/419 and https://github.com/facebook/hermes/issues/564.
-          memcpy(buf.data(rt), value.arrayBufferValue.get(), value.arrayBufferSize);
-          rowObject.setProperty(rt, columnName.c_str(), o);
+          rowObject.setProperty(rt, columnNames[c], quickValueToJsiValue(rt, row[c]));
         }
-        else
+        array.setValueAtIndex(rt, i, move(rowObject));
+      }
+      else
+      {
+        auto rowArray = jsi::Array(rt, columnCount);
+        for (size_t c = 0; c < columnCount; c++)
         {
-          rowObject.setProperty(rt, columnName.c_str(), jsi::Value(nullptr));
+          rowArray.setValueAtIndex(rt, c, quickValueToJsiValue(rt, row[c]));
         }
+        array.setValueAtIndex(rt, i, move(rowArray));
       }
-      array.setValueAtIndex(rt, i, move(rowObject));
     }
     rows.setProperty(rt, "_array", move(array));
+    rows.setProperty(rt, "length", jsi::Value((int)rowCount));
     res.setProperty(rt, "rows", move(rows));
   }
 
@@ -211,7 +575,6 @@ jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult sta
     }
     res.setProperty(rt, "metadata", move(column_array));
   }
-  rows.setProperty(rt, "length", jsi::Value((int)rowCount));
 
   return move(res);
 }
@@ -16,6 +16,39 @@
 
 using namespace std;
 using namespace facebook;
+
+// jsi::ArrayBuffer can wrap native memory through jsi::MutableBuffer since JSI version 9
+#if defined(JSI_VERSION) && JSI_VERSION >= 9
+#define QUICK_SQLITE_MUTABLE_BUFFER 1
+#endif
+
+/**
+ * Bytes of a blob. Blobs read from SQLite own a copy of the column, it is handed to JS
+ * as the backing store of an ArrayBuffer without copying it again. A blob created with
+ * borrow points to memory owned by someone else and must not outlive it
+ */
+#ifdef QUICK_SQLITE_MUTABLE_BUFFER
+class QuickBlob : public jsi::MutableBuffer
+#else
+class QuickBlob
+#endif
+{
+public:
+  QuickBlob(const void *data, size_t size);
+  // Zero-filled bytes, to be written in place
+  explicit QuickBlob(size_t size);
+  static shared_ptr<QuickBlob> borrow(uint8_t *data, size_t size);
+
+  size_t size() const;
+  uint8_t *data();
+
+private:
+  QuickBlob() = default;
+  vector<uint8_t> storage;
+  uint8_t *bytes = nullptr;
+  size_t length = 0;
+};
+
 /**
  * Enum for QuickValue to store/determine correct type for dynamic JSI values
  */
@@ -40,8 +73,91 @@ struct QuickValue
   double doubleOrIntValue;
   long long int64Value;
   string textValue;
-  shared_ptr<uint8_t> arrayBufferValue;
-  size_t arrayBufferSize;
+  shared_ptr<QuickBlob> arrayBufferValue;
+};
+
+/**
+ * Compact parameter of a statement. Text and names are slices of the arena of their QuickParams
+ */
+enum QuickParamType : uint8_t
+{
+  PARAM_NULL,
+  PARAM_INT64,
+  PARAM_DOUBLE,
+  PARAM_TEXT,
+  PARAM_BLOB,
+};
+
+struct QuickParam
+{
+  QuickParamType type;
+  // Set for named parameters, the name includes its prefix (:name, @name or $name)
+  uint32_t nameOffset;
+  uint32_t nameLength;
+  union
+  {
+    long long int64Value;
+    double doubleValue;
+    struct
+    {
+      uint32_t offset;
+      uint32_t length;
+    } text;
+    uint32_t blobIndex;
+  };
+};
+
+/**
+ * Parameters of a statement, either positional or named. The bytes of every string are
+ * appended to a single arena, so binding thousands of values does not allocate per value
+ * and the text can be bound without SQLite copying it
+ */
+struct QuickParams
+{
+  vector<QuickParam> values;
+  string arena;
+  vector<shared_ptr<QuickBlob>> blobs;
+
+  void addNull();
+  void addInt64(long long value);
+  void addDouble(double value);
+  void addText(const char *text, size_t length);
+  void addText(string const &text);
+  void addBlob(shared_ptr<QuickBlob> blob);
+  // Names the parameter added last
+  void setLastName(string const &name);
+
+  size_t size() const;
+  bool empty() const;
+  void clear();
+};
+
+/**
+ * Rows of a result set, the values are stored row-major in a single contiguous buffer
+ * and the column names only once for the whole set
+ */
+struct QuickResultSet
+{
+  vector<string> columnNames;
+  vector<QuickValue> cells;
+  size_t rowCount = 0;
+  // INTEGER values beyond 2^53 are kept as INT64 cells and converted to BigInt instead of losing precision
+  bool bigInt = false;
+};
+
+/**
+ * Shape of the JS object created from a result set
+ */
+enum QuickResultFormat
+{
+  // rows._array is an array of objects keyed by column name
+  RESULT_OBJECTS,
+  // columns holds the column names, rows._array is an array of arrays in the same order
+  RESULT_ARRAYS,
+  // columns holds the column names, columnValues one array per column, numeric columns as Float64Array
+  RESULT_COLUMNS,
+  // rows is a HostObject owning the result set, row objects are created when accessed
+  RESULT_LAZY,
 };
 
 /**
@@ -88,6 +204,35 @@ struct SequelBatchOperationResult
   string message;
   int affectedRows;
   int commands;
+  // Milliseconds spent on every command of the batch, in the order they were passed
+  vector<double> commandTimings;
+};
+
+/**
+ * Connection settings passed from JS to open
+ */
+struct SQLiteOpenOptions
+{
+  // Maximum number of prepared statements kept per connection, 0 disables the cache
+  size_t statementCacheSize = 32;
+  // Read-only connections opened next to the writer, enables WAL mode when greater than 0
+  size_t readerConnections = 0;
+  // Absolute path of a bundled database, opened read-only in place instead of docPath/dbName
+  string assetPath;
+  // Bytes of the file read through memory mapping, -1 keeps the SQLite default
+  long long mmapSize = -1;
+  // PRAGMA values applied to every connection, empty or the default value keeps the SQLite default
+  string journalMode;
+  string synchronous;
+  string tempStore;
+  // Pages when positive, KiB when negative
+  long long cacheSize = 0;
+  int busyTimeout = -1;
+  int pageSize = 0;
+  // Return INTEGER values that do not fit a double as BigInt
+  bool bigInt = false;
+  // Collect the stats returned by getStats
+  bool profile = false;
 };
 
 /**
@@ -101,9 +246,21 @@ struct QuickColumnMetadata
 };
 
 /**
- * Fill the target vector with parsed parameters
+ * Fill target with the parsed parameters, either an array of positional ones or an object of named ones ({':name': value}).
+ * ArrayBuffers are copied so the values can be used from any thread, with borrowBuffers they point
+ * to the JS memory and are only valid during the current call
+ * */
+void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &args, QuickParams *target, bool borrowBuffers = false);
+
+/**
+ * Fill the target options with the ones set on the JS options object, missing keys keep their defaults
+ * */
+void jsiOpenOptionsToSQLiteOpenOptions(jsi::Runtime &rt, jsi::Value const &options, SQLiteOpenOptions *target);
+
+/**
+ * Read the result format from the execute options object, defaults to RESULT_OBJECTS
  * */
-void jsiQueryArgumentsToSequelParam(jsi::Runtime &rt, jsi::Value const &args, vector<QuickValue> *target);
+QuickResultFormat jsiQueryOptionsToResultFormat(jsi::Runtime &rt, jsi::Value const &options);
 
 QuickValue createNullQuickValue();
 QuickValue createBooleanQuickValue(bool value);
@@ -112,8 +269,16 @@ QuickValue createIntegerQuickValue(int value);
 QuickValue createIntegerQuickValue(double value);
 QuickValue createInt64QuickValue(long long value);
 QuickValue createDoubleQuickValue(double value);
-QuickValue createArrayBufferQuickValue(uint8_t *arrayBufferValue, size_t arrayBufferSize);
-jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, vector<map<string, QuickValue>> *results, vector<QuickColumnMetadata> *metadata);
+QuickValue createArrayBufferQuickValue(shared_ptr<QuickBlob> arrayBufferValue);
+/**
+ * Convert a result set into its JS representation, with RESULT_LAZY the result set is moved out of results
+ * */
+jsi::Value createSequelQueryExecutionResult(jsi::Runtime &rt, SQLiteOPResult status, QuickResultSet *results, vector<QuickColumnMetadata> *metadata, QuickResultFormat format = RESULT_OBJECTS);
+jsi::Value quickValueToJsiValue(jsi::Runtime &rt, QuickValue const &value);
+/**
+ * Copies count doubles into a new Float64Array
+ */
+jsi::Value createFloat64Array(jsi::Runtime &rt, const double *values, size_t count);
 int createSQLiteFunctionOptions(bool DETERMINISTIC, bool DIRECTONLY, bool INNOCUOUS, bool SUBTYPE);
 template<typename T>
 T* clone(const T* source);
@@ -0,0 +1,137 @@
+//
+//  JSThreadDispatcher.cpp
+//  react-native-quick-sqlite
+//
+
+#include "JSThreadDispatcher.h"
+#include <algorithm>
+
+// Set once by install, the JS thread is the one that installed the module
+static shared_ptr<JSThreadDispatcher> dispatcher;
+
+void JSThreadDispatcher::install(shared_ptr<react::CallInvoker> invoker)
+{
+  dispatcher = shared_ptr<JSThreadDispatcher>(new JSThreadDispatcher(invoker));
+}
+
+JSThreadDispatcher::JSThreadDispatcher(shared_ptr<react::CallInvoker> invoker) : invoker(invoker), jsThreadId(this_thread::get_id()), isScheduled(false), isJSThreadWaiting(false)
+{
+}
+
+bool JSThreadDispatcher::isJSThread()
+{
+  return dispatcher == nullptr || this_thread::get_id() == dispatcher->jsThreadId;
+}
+
+void JSThreadDispatcher::call(function<void(void)> fn)
+{
+  if (isJSThread())
+  {
+    fn();
+    return;
+  }
+
+  // Keeps the dispatcher alive if the module is installed again meanwhile
+  auto self = dispatcher;
+  auto pendingCall = make_shared<PendingCall>(PendingCall{.fn = fn, .caller = this_thread::get_id(), .isDone = false});
+  bool needsSchedule = false;
+  unique_lock<mutex> g(self->callsMutex);
+  self->pendingCalls.push_back(pendingCall);
+  if (!self->isScheduled)
+  {
+    self->isScheduled = true;
+    needsSchedule = true;
+  }
+  // Wakes the JS thread if it is blocked on this worker
+  self->callsConditionVariable.notify_all();
+  g.unlock();
+
+  if (needsSchedule)
+  {
+    self->invoker->invokeAsync([self]()
+                               {
+      unique_lock<mutex> g(self->callsMutex);
+      self->isScheduled = false;
+      self->runPendingCalls(g); });
+  }
+
+  g.lock();
+  self->callsConditionVariable.wait(g, [&]
+                                    { return pendingCall->isDone; });
+}
+
+void JSThreadDispatcher::runPendingCalls(unique_lock<mutex> &lock)
+{
+  while (!pendingCalls.empty())
+  {
+    vector<shared_ptr<PendingCall>> calls;
+    calls.swap(pendingCalls);
+    lock.unlock();
+    for (auto &pendingCall : calls)
+    {
+      servedCallers.push_back(pendingCall->caller);
+      // The calls report their errors through their SQLite context, nothing should be thrown here
+      try
+      {
+        pendingCall->fn();
+      }
+      catch (...)
+      {
+      }
+      servedCallers.pop_back();
+    }
+    lock.lock();
+    for (auto &pendingCall : calls)
+    {
+      pendingCall->isDone = true;
+    }
+    callsConditionVariable.notify_all();
+  }
+}
+
+void JSThreadDispatcher::runPendingCallsUntil(function<bool(void)> isDone)
+{
+  if (dispatcher == nullptr)
+  {
+    while (!isDone())
+    {
+      this_thread::yield();
+    }
+    return;
+  }
+
+  auto self = dispatcher;
+  unique_lock<mutex> g(self->callsMutex);
+  self->isJSThreadWaiting = true;
+  while (true)
+  {
+    self->runPendingCalls(g);
+    if (isDone())
+    {
+      break;
+    }
+    self->callsConditionVariable.wait(g);
+  }
+  self->isJSThreadWaiting = false;
+}
+
+void JSThreadDispatcher::wake()
+{
+  auto self = dispatcher;
+  if (self == nullptr || !self->isJSThreadWaiting)
+  {
+    return;
+  }
+  lock_guard<mutex> g(self->callsMutex);
+  self->callsConditionVariable.notify_all();
+}
+
+bool JSThreadDispatcher::isServingCallOf(thread::id caller)
+{
+  auto self = dispatcher;
+  if (self == nullptr || caller == thread::id())
+  {
+    return false;
+  }
+  return find(self->servedCallers.begin(), self->servedCallers.end(), caller) != self->servedCallers.end();
+}
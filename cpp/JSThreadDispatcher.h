@@ -0,0 +1,75 @@
+//
+//  JSThreadDispatcher.h
+//  react-native-quick-sqlite
+//
+//  Runs calls into the JS runtime that come from the worker threads on the JS thread
+//
+
+#ifndef JSThreadDispatcher_h
+#define JSThreadDispatcher_h
+
+#include <ReactCommon/CallInvoker.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace facebook;
+
+class JSThreadDispatcher {
+public:
+  /**
+   * MUST be called from the JS thread, every later call of call() from another thread goes through the invoker
+   */
+  static void install(shared_ptr<react::CallInvoker> invoker);
+  static bool isJSThread();
+
+  /**
+   * Runs fn on the JS thread and blocks until it returned, fn runs right away when already on the JS thread.
+   * Calls queued by several threads at once are run together by a single invokeAsync
+   */
+  static void call(function<void(void)> fn);
+
+  /**
+   * Blocks the JS thread until isDone returns true, running the calls other threads queue meanwhile.
+   * isDone is checked again after every wake()
+   */
+  static void runPendingCallsUntil(function<bool(void)> isDone);
+  static void wake();
+
+  /**
+   * MUST be called from the JS thread, whether it is running a call queued by the caller thread
+   */
+  static bool isServingCallOf(thread::id caller);
+
+private:
+  struct PendingCall
+  {
+    function<void(void)> fn;
+    thread::id caller;
+    bool isDone;
+  };
+
+  JSThreadDispatcher(shared_ptr<react::CallInvoker> invoker);
+  void runPendingCalls(unique_lock<mutex> &lock);
+
+  shared_ptr<react::CallInvoker> invoker;
+  thread::id jsThreadId;
+
+  // Protects pendingCalls, isScheduled and the isDone flags
+  mutex callsMutex;
+  condition_variable callsConditionVariable;
+  vector<shared_ptr<PendingCall>> pendingCalls;
+  // Set while a drain of the pending calls is queued on the invoker
+  bool isScheduled;
+  // Set while the JS thread is blocked in runPendingCallsUntil
+  atomic<bool> isJSThreadWaiting;
+  // Threads whose calls the JS thread is running, nested when a call waits for a connection. Only used on the JS thread
+  vector<thread::id> servedCallers;
+};
+
+#endif /* JSThreadDispatcher_h */
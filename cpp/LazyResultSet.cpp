@@ -0,0 +1,117 @@
+//
+//  LazyResultSet.cpp
+//  react-native-quick-sqlite
+//
+
+#include "LazyResultSet.h"
+#include "macros.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  jsi::Value createLazyRow(jsi::Runtime &rt, QuickResultSet *results, double index)
+  {
+    if (index < 0 || index >= results->rowCount || index != (size_t)index)
+    {
+      return jsi::Value::undefined();
+    }
+
+    size_t columnCount = results->columnNames.size();
+    const QuickValue *row = &results->cells[(size_t)index * columnCount];
+    jsi::Object rowObject = jsi::Object(rt);
+    for (size_t c = 0; c < columnCount; c++)
+    {
+      rowObject.setProperty(rt, results->columnNames[c].c_str(), quickValueToJsiValue(rt, row[c]));
+    }
+    return move(rowObject);
+  }
+
+  LazyRows::LazyRows(shared_ptr<QuickResultSet> results) : results(results)
+  {
+  }
+
+  vector<jsi::PropNameID> LazyRows::getPropertyNames(jsi::Runtime &rt)
+  {
+    vector<jsi::PropNameID> names;
+    names.push_back(jsi::PropNameID::forAscii(rt, "length"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "item"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "toArray"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "_array"));
+    return names;
+  }
+
+  jsi::Value LazyRows::get(jsi::Runtime &rt, const jsi::PropNameID &propNameId)
+  {
+    auto name = propNameId.utf8(rt);
+    auto results = this->results;
+
+    if (name == "length")
+    {
+      return jsi::Value((double)results->rowCount);
+    }
+
+    if (name == "item")
+    {
+      return HOSTFN("item", 1) {
+        if (count == 0 || !args[0].isNumber())
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][item] index must be a number");
+        }
+        return createLazyRow(rt, results.get(), args[0].asNumber());
+      });
+    }
+
+    // Materializes every row at once, for callers that need a real JS array
+    if (name == "toArray")
+    {
+      return HOSTFN("toArray", 0) {
+        auto array = jsi::Array(rt, results->rowCount);
+        for (size_t i = 0; i < results->rowCount; i++)
+        {
+          array.setValueAtIndex(rt, i, createLazyRow(rt, results.get(), i));
+        }
+        return move(array);
+      });
+    }
+
+    if (name == "_array")
+    {
+      return jsi::Object::createFromHostObject(rt, make_shared<LazyRowArray>(results));
+    }
+
+    return jsi::Value::undefined();
+  }
+
+  LazyRowArray::LazyRowArray(shared_ptr<QuickResultSet> results) : results(results)
+  {
+  }
+
+  vector<jsi::PropNameID> LazyRowArray::getPropertyNames(jsi::Runtime &rt)
+  {
+    vector<jsi::PropNameID> names;
+    names.push_back(jsi::PropNameID::forAscii(rt, "length"));
+    for (size_t i = 0; i < results->rowCount; i++)
+    {
+      names.push_back(jsi::PropNameID::forAscii(rt, to_string(i)));
+    }
+    return names;
+  }
+
+  jsi::Value LazyRowArray::get(jsi::Runtime &rt, const jsi::PropNameID &propNameId)
+  {
+    auto name = propNameId.utf8(rt);
+
+    if (name == "length")
+    {
+      return jsi::Value((double)results->rowCount);
+    }
+
+    if (name.empty() || name.find_first_not_of("0123456789") != string::npos)
+    {
+      return jsi::Value::undefined();
+    }
+
+    return createLazyRow(rt, results.get(), stod(name));
+  }
+}
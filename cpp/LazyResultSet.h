@@ -0,0 +1,52 @@
+//
+//  LazyResultSet.h
+//  react-native-quick-sqlite
+//
+//  JSI HostObjects keeping a result set native, rows are only turned into JS objects when accessed
+//
+
+#ifndef LazyResultSet_h
+#define LazyResultSet_h
+
+#include <jsi/jsi.h>
+#include "JSIHelper.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  /**
+   * Exposed as result.rows: length, item(i), toArray() and _array
+   */
+  class LazyRows : public jsi::HostObject {
+  public:
+    LazyRows(shared_ptr<QuickResultSet> results);
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &propNameId) override;
+    vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+  private:
+    shared_ptr<QuickResultSet> results;
+  };
+
+  /**
+   * Exposed as result.rows._array, supports index access and length
+   */
+  class LazyRowArray : public jsi::HostObject {
+  public:
+    LazyRowArray(shared_ptr<QuickResultSet> results);
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &propNameId) override;
+    vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+  private:
+    shared_ptr<QuickResultSet> results;
+  };
+
+  /**
+   * Creates the JS object for a single row, undefined when the index is out of range
+   */
+  jsi::Value createLazyRow(jsi::Runtime &rt, QuickResultSet *results, double index);
+}
+
+#endif /* LazyResultSet_h */
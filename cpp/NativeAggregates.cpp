@@ -0,0 +1,438 @@
+//
+//  NativeAggregates.cpp
+//  react-native-quick-sqlite
+//
+
+#include "NativeAggregates.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define QUICK_SQLITE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define QUICK_SQLITE_SSE2 1
+#endif
+
+using namespace std;
+
+// Rows removed by xInverse are only compacted away once they are this many
+#define MIN_COMPACTION_ROWS 1024
+
+enum NativeAggregateKind
+{
+  MEDIAN,
+  PERCENTILE,
+  STDDEV,
+  STDDEV_POP,
+  VARIANCE,
+  VARIANCE_POP,
+  WEIGHTED_AVG,
+  HISTOGRAM,
+};
+
+/**
+ * Values of the rows currently in the aggregate. Window frames drop their oldest rows first,
+ * so xInverse only has to move the start forward
+ */
+class DoubleColumn {
+public:
+  void push(double value)
+  {
+    values.push_back(value);
+  }
+
+  void popFront()
+  {
+    head++;
+    if (head >= MIN_COMPACTION_ROWS && head * 2 >= values.size())
+    {
+      values.erase(values.begin(), values.begin() + head);
+      head = 0;
+    }
+  }
+
+  const double *data() const
+  {
+    return values.data() + head;
+  }
+
+  size_t size() const
+  {
+    return values.size() - head;
+  }
+
+private:
+  vector<double> values;
+  size_t head = 0;
+};
+
+struct NativeAggregateState
+{
+  DoubleColumn values;
+  DoubleColumn weights;
+  // Arguments that must be the same for every row, read from the first one
+  bool hasParameters;
+  double percentile;
+  double histogramMin;
+  double histogramMax;
+  int histogramBuckets;
+  // Reused by every percentile computation
+  vector<double> scratch;
+};
+
+/**
+ * Kernels over the buffered columns, two accumulators hide the latency of the vector adds
+ */
+double sumKernel(const double *values, size_t count)
+{
+  size_t i = 0;
+  double sum = 0;
+#if defined(QUICK_SQLITE_NEON)
+  float64x2_t sum0 = vdupq_n_f64(0);
+  float64x2_t sum1 = vdupq_n_f64(0);
+  for (; i + 4 <= count; i += 4)
+  {
+    sum0 = vaddq_f64(sum0, vld1q_f64(values + i));
+    sum1 = vaddq_f64(sum1, vld1q_f64(values + i + 2));
+  }
+  sum = vaddvq_f64(vaddq_f64(sum0, sum1));
+#elif defined(QUICK_SQLITE_SSE2)
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  for (; i + 4 <= count; i += 4)
+  {
+    sum0 = _mm_add_pd(sum0, _mm_loadu_pd(values + i));
+    sum1 = _mm_add_pd(sum1, _mm_loadu_pd(values + i + 2));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+  sum = lanes[0] + lanes[1];
+#endif
+  for (; i < count; i++)
+  {
+    sum += values[i];
+  }
+  return sum;
+}
+
+double squaredDeviationsKernel(const double *values, size_t count, double mean)
+{
+  size_t i = 0;
+  double sum = 0;
+#if defined(QUICK_SQLITE_NEON)
+  float64x2_t means = vdupq_n_f64(mean);
+  float64x2_t sum0 = vdupq_n_f64(0);
+  float64x2_t sum1 = vdupq_n_f64(0);
+  for (; i + 4 <= count; i += 4)
+  {
+    float64x2_t deviation0 = vsubq_f64(vld1q_f64(values + i), means);
+    float64x2_t deviation1 = vsubq_f64(vld1q_f64(values + i + 2), means);
+    sum0 = vfmaq_f64(sum0, deviation0, deviation0);
+    sum1 = vfmaq_f64(sum1, deviation1, deviation1);
+  }
+  sum = vaddvq_f64(vaddq_f64(sum0, sum1));
+#elif defined(QUICK_SQLITE_SSE2)
+  __m128d means = _mm_set1_pd(mean);
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128d deviation0 = _mm_sub_pd(_mm_loadu_pd(values + i), means);
+    __m128d deviation1 = _mm_sub_pd(_mm_loadu_pd(values + i + 2), means);
+    sum0 = _mm_add_pd(sum0, _mm_mul_pd(deviation0, deviation0));
+    sum1 = _mm_add_pd(sum1, _mm_mul_pd(deviation1, deviation1));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+  sum = lanes[0] + lanes[1];
+#endif
+  for (; i < count; i++)
+  {
+    double deviation = values[i] - mean;
+    sum += deviation * deviation;
+  }
+  return sum;
+}
+
+double dotKernel(const double *a, const double *b, size_t count)
+{
+  size_t i = 0;
+  double sum = 0;
+#if defined(QUICK_SQLITE_NEON)
+  float64x2_t sum0 = vdupq_n_f64(0);
+  float64x2_t sum1 = vdupq_n_f64(0);
+  for (; i + 4 <= count; i += 4)
+  {
+    sum0 = vfmaq_f64(sum0, vld1q_f64(a + i), vld1q_f64(b + i));
+    sum1 = vfmaq_f64(sum1, vld1q_f64(a + i + 2), vld1q_f64(b + i + 2));
+  }
+  sum = vaddvq_f64(vaddq_f64(sum0, sum1));
+#elif defined(QUICK_SQLITE_SSE2)
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  for (; i + 4 <= count; i += 4)
+  {
+    sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+  sum = lanes[0] + lanes[1];
+#endif
+  for (; i < count; i++)
+  {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+/**
+ * Values below min are counted in the first bucket, values above max in the last one
+ */
+void histogramKernel(const double *values, size_t count, double min, double max, int buckets, vector<int64_t> *counts)
+{
+  const double scale = buckets / (max - min);
+  const double lastBucket = buckets - 1;
+  size_t i = 0;
+#if defined(QUICK_SQLITE_NEON)
+  float64x2_t mins = vdupq_n_f64(min);
+  float64x2_t scales = vdupq_n_f64(scale);
+  float64x2_t zeros = vdupq_n_f64(0);
+  float64x2_t lasts = vdupq_n_f64(lastBucket);
+  for (; i + 2 <= count; i += 2)
+  {
+    float64x2_t position = vmulq_f64(vsubq_f64(vld1q_f64(values + i), mins), scales);
+    int64x2_t bucket = vcvtq_s64_f64(vminq_f64(vmaxq_f64(position, zeros), lasts));
+    (*counts)[vgetq_lane_s64(bucket, 0)]++;
+    (*counts)[vgetq_lane_s64(bucket, 1)]++;
+  }
+#endif
+  for (; i < count; i++)
+  {
+    double position = (values[i] - min) * scale;
+    (*counts)[(size_t)std::min(std::max(position, 0.0), lastBucket)]++;
+  }
+}
+
+double percentileOf(NativeAggregateState *state, double percentile)
+{
+  // nth_element reorders, the column has to keep the insertion order for xInverse
+  state->scratch.assign(state->values.data(), state->values.data() + state->values.size());
+  auto &values = state->scratch;
+  double position = percentile / 100 * (values.size() - 1);
+  size_t lower = (size_t)floor(position);
+  nth_element(values.begin(), values.begin() + lower, values.end());
+  double lowerValue = values[lower];
+  if (lower + 1 >= values.size() || position == lower)
+  {
+    return lowerValue;
+  }
+  // Interpolates between the two closest values, the next one is the smallest of the upper part
+  double upperValue = *min_element(values.begin() + lower + 1, values.end());
+  return lowerValue + (upperValue - lowerValue) * (position - lower);
+}
+
+NativeAggregateState *getState(sqlite3_context *invocation, bool create)
+{
+  auto holder = static_cast<NativeAggregateState **>(sqlite3_aggregate_context(invocation, create ? sizeof(NativeAggregateState *) : 0));
+  if (holder == NULL)
+  {
+    return NULL;
+  }
+  if (*holder == NULL && create)
+  {
+    *holder = new NativeAggregateState();
+  }
+  return *holder;
+}
+
+bool readParameters(sqlite3_context *invocation, NativeAggregateKind kind, NativeAggregateState *state, sqlite3_value **argv)
+{
+  if (state->hasParameters)
+  {
+    return true;
+  }
+
+  if (kind == PERCENTILE)
+  {
+    double percentile = sqlite3_value_double(argv[1]);
+    if (sqlite3_value_type(argv[1]) == SQLITE_NULL || percentile < 0 || percentile > 100)
+    {
+      sqlite3_result_error(invocation, "percentile() must be between 0 and 100", -1);
+      return false;
+    }
+    state->percentile = percentile;
+  }
+  else if (kind == HISTOGRAM)
+  {
+    state->histogramMin = sqlite3_value_double(argv[1]);
+    state->histogramMax = sqlite3_value_double(argv[2]);
+    state->histogramBuckets = sqlite3_value_int(argv[3]);
+    if (!(state->histogramMax > state->histogramMin) || state->histogramBuckets < 1 || state->histogramBuckets > 10000)
+    {
+      sqlite3_result_error(invocation, "histogram() needs min < max and between 1 and 10000 buckets", -1);
+      return false;
+    }
+  }
+  state->hasParameters = true;
+  return true;
+}
+
+void nativeStep(sqlite3_context *invocation, int argc, sqlite3_value **argv)
+{
+  auto kind = (NativeAggregateKind)(intptr_t)sqlite3_user_data(invocation);
+  NativeAggregateState *state = getState(invocation, true);
+  if (state == NULL)
+  {
+    sqlite3_result_error_nomem(invocation);
+    return;
+  }
+
+  // NULLs are ignored like in the built-in aggregates
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL || (kind == WEIGHTED_AVG && sqlite3_value_type(argv[1]) == SQLITE_NULL))
+  {
+    return;
+  }
+  if (!readParameters(invocation, kind, state, argv))
+  {
+    return;
+  }
+
+  state->values.push(sqlite3_value_double(argv[0]));
+  if (kind == WEIGHTED_AVG)
+  {
+    state->weights.push(sqlite3_value_double(argv[1]));
+  }
+}
+
+void nativeInverse(sqlite3_context *invocation, int argc, sqlite3_value **argv)
+{
+  auto kind = (NativeAggregateKind)(intptr_t)sqlite3_user_data(invocation);
+  NativeAggregateState *state = getState(invocation, false);
+  if (state == NULL || state->values.size() == 0)
+  {
+    return;
+  }
+
+  // Skipped by nativeStep, they were never added
+  if (sqlite3_value_type(argv[0]) == SQLITE_NULL || (kind == WEIGHTED_AVG && sqlite3_value_type(argv[1]) == SQLITE_NULL))
+  {
+    return;
+  }
+
+  state->values.popFront();
+  if (kind == WEIGHTED_AVG)
+  {
+    state->weights.popFront();
+  }
+}
+
+void nativeValue(sqlite3_context *invocation)
+{
+  auto kind = (NativeAggregateKind)(intptr_t)sqlite3_user_data(invocation);
+  NativeAggregateState *state = getState(invocation, false);
+  size_t count = state != NULL ? state->values.size() : 0;
+  if (count == 0)
+  {
+    sqlite3_result_null(invocation);
+    return;
+  }
+
+  const double *values = state->values.data();
+  switch (kind)
+  {
+  case MEDIAN:
+    sqlite3_result_double(invocation, percentileOf(state, 50));
+    break;
+  case PERCENTILE:
+    sqlite3_result_double(invocation, percentileOf(state, state->percentile));
+    break;
+  case STDDEV:
+  case STDDEV_POP:
+  case VARIANCE:
+  case VARIANCE_POP:
+  {
+    const bool isSample = kind == STDDEV || kind == VARIANCE;
+    if (isSample && count < 2)
+    {
+      sqlite3_result_null(invocation);
+      break;
+    }
+    // Two passes over the values, more accurate than a running sum of squares
+    double mean = sumKernel(values, count) / count;
+    double variance = squaredDeviationsKernel(values, count, mean) / (isSample ? count - 1 : count);
+    sqlite3_result_double(invocation, kind == STDDEV || kind == STDDEV_POP ? sqrt(variance) : variance);
+    break;
+  }
+  case WEIGHTED_AVG:
+  {
+    double totalWeight = sumKernel(state->weights.data(), count);
+    if (totalWeight == 0)
+    {
+      sqlite3_result_null(invocation);
+      break;
+    }
+    sqlite3_result_double(invocation, dotKernel(values, state->weights.data(), count) / totalWeight);
+    break;
+  }
+  case HISTOGRAM:
+  {
+    vector<int64_t> counts(state->histogramBuckets, 0);
+    histogramKernel(values, count, state->histogramMin, state->histogramMax, state->histogramBuckets, &counts);
+    string json = "[";
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+      json += (i > 0 ? "," : "") + to_string(counts[i]);
+    }
+    json += "]";
+    sqlite3_result_text(invocation, json.c_str(), (int)json.size(), SQLITE_TRANSIENT);
+    sqlite3_result_subtype(invocation, 'J');
+    break;
+  }
+  }
+}
+
+void nativeFinal(sqlite3_context *invocation)
+{
+  nativeValue(invocation);
+  auto holder = static_cast<NativeAggregateState **>(sqlite3_aggregate_context(invocation, 0));
+  if (holder != NULL)
+  {
+    delete *holder;
+    *holder = NULL;
+  }
+}
+
+int registerNativeAggregates(sqlite3 *db)
+{
+  struct Definition
+  {
+    const char *name;
+    int nArgs;
+    NativeAggregateKind kind;
+  };
+  const Definition definitions[] = {
+    {"median", 1, MEDIAN},
+    {"percentile", 2, PERCENTILE},
+    {"stddev", 1, STDDEV},
+    {"stddev_pop", 1, STDDEV_POP},
+    {"variance", 1, VARIANCE},
+    {"variance_pop", 1, VARIANCE_POP},
+    {"weighted_avg", 2, WEIGHTED_AVG},
+    {"histogram", 4, HISTOGRAM},
+  };
+
+  for (auto &definition : definitions)
+  {
+    int exit = sqlite3_create_window_function(db, definition.name, definition.nArgs, SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS, (void *)(intptr_t)definition.kind, nativeStep, nativeFinal, nativeValue, nativeInverse, NULL);
+    if (exit != SQLITE_OK)
+    {
+      return exit;
+    }
+  }
+  return SQLITE_OK;
+}
@@ -0,0 +1,20 @@
+//
+//  NativeAggregates.h
+//  react-native-quick-sqlite
+//
+//  Statistics aggregates implemented natively, they never enter JS
+//
+
+#ifndef NativeAggregates_h
+#define NativeAggregates_h
+
+#include <sqlite3.h>
+
+/**
+ * Registers median, percentile, stddev, stddev_pop, variance, variance_pop, weighted_avg and histogram
+ * on the connection, all of them can also be used as window functions.
+ * Returns the SQLite status code of the first registration that failed
+ */
+int registerNativeAggregates(sqlite3 *db);
+
+#endif /* NativeAggregates_h */
@@ -0,0 +1,150 @@
+//
+//  PreparedStatement.cpp
+//  react-native-quick-sqlite
+//
+
+#include "PreparedStatement.h"
+#include "macros.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  /**
+   * Reads the parameters passed to execute/executeAsync, returns false when there are none and the current bindings are used
+   */
+  bool readArgumentsIfPresent(jsi::Runtime &rt, const jsi::Value *args, size_t count, QuickParams *params)
+  {
+    if (count == 0 || args[0].isUndefined() || args[0].isNull())
+    {
+      return false;
+    }
+
+    jsiQueryArgumentsToSequelParam(rt, args[0], params);
+    return true;
+  }
+
+  PreparedStatement::PreparedStatement(
+                                       shared_ptr<PreparedStatementHandle> handle,
+                                       ExecutorProvider getExecutor,
+                                       shared_ptr<react::CallInvoker> invoker
+                                       ) :
+  handle(handle),
+  getExecutor(getExecutor),
+  invoker(invoker)
+  {
+  }
+
+  PreparedStatement::~PreparedStatement()
+  {
+    sqliteFinalizePreparedStatement(handle);
+  }
+
+  vector<jsi::PropNameID> PreparedStatement::getPropertyNames(jsi::Runtime &rt)
+  {
+    vector<jsi::PropNameID> names;
+    names.push_back(jsi::PropNameID::forAscii(rt, "bind"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "execute"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "executeAsync"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "finalize"));
+    return names;
+  }
+
+  jsi::Value PreparedStatement::get(jsi::Runtime &rt, const jsi::PropNameID &propNameId)
+  {
+    auto name = propNameId.utf8(rt);
+    // The returned functions can outlive this object, they only hold on to the shared state
+    auto handle = this->handle;
+    auto getExecutor = this->getExecutor;
+    auto invoker = this->invoker;
+
+    if (name == "bind")
+    {
+      return HOSTFN("bind", 1) {
+        if (count == 0)
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][bind] params are required");
+        }
+
+        QuickParams params;
+        jsiQueryArgumentsToSequelParam(rt, args[0], &params);
+        auto status = sqliteBindPreparedStatement(handle, &params);
+        if (status.type == SQLiteError)
+        {
+          throw jsi::JSError(rt, status.errorMessage);
+        }
+        return {};
+      });
+    }
+
+    if (name == "execute")
+    {
+      return HOSTFN("execute", 2) {
+        QuickParams params;
+        const bool hasParams = readArgumentsIfPresent(rt, args, count, &params);
+        const QuickResultFormat format = count > 1 ? jsiQueryOptionsToResultFormat(rt, args[1]) : RESULT_OBJECTS;
+
+        QuickResultSet results;
+        vector<QuickColumnMetadata> metadata;
+        auto status = sqliteExecutePreparedStatement(handle, hasParams ? &params : NULL, &results, &metadata);
+        if (status.type == SQLiteError)
+        {
+          throw jsi::JSError(rt, status.errorMessage);
+        }
+
+        return createSequelQueryExecutionResult(rt, status, &results, &metadata, format);
+      });
+    }
+
+    if (name == "executeAsync")
+    {
+      return HOSTFN("executeAsync", 2) {
+        // Bound on the worker right before the statement runs, calls that are not awaited keep their own values
+        auto params = make_shared<QuickParams>();
+        const bool hasParams = readArgumentsIfPresent(rt, args, count, params.get());
+        const QuickResultFormat format = count > 1 ? jsiQueryOptionsToResultFormat(rt, args[1]) : RESULT_OBJECTS;
+
+        auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+        auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+          auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+          auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+          auto task =
+          [&rt, handle, invoker, params, hasParams, format, resolve, reject]()
+          {
+            auto results = make_shared<QuickResultSet>();
+            auto metadata = make_shared<vector<QuickColumnMetadata>>();
+            auto status = sqliteExecutePreparedStatement(handle, hasParams ? params.get() : NULL, results.get(), metadata.get());
+            invoker->invokeAsync([&rt, results, metadata, status_copy = move(status), format, resolve, reject]
+                                 {
+              if(status_copy.type == SQLiteOk) {
+                auto jsiResult = createSequelQueryExecutionResult(rt, status_copy, results.get(), metadata.get(), format);
+                resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResult));
+              } else {
+                auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+                auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+                reject->asObject(rt).asFunction(rt).call(rt, error);
+              }
+            });
+          };
+
+          getExecutor()->queueWork(task);
+
+          return {};
+        }));
+
+        return promise;
+      });
+    }
+
+    if (name == "finalize")
+    {
+      return HOSTFN("finalize", 0) {
+        sqliteFinalizePreparedStatement(handle);
+        return {};
+      });
+    }
+
+    return jsi::Value::undefined();
+  }
+}
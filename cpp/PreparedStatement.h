@@ -0,0 +1,39 @@
+//
+//  PreparedStatement.h
+//  react-native-quick-sqlite
+//
+//  JSI HostObject wrapping a statement prepared once and executed many times
+//
+
+#ifndef PreparedStatement_h
+#define PreparedStatement_h
+
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+#include "sqliteBridge.h"
+#include "SerialExecutor.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  class PreparedStatement : public jsi::HostObject {
+  public:
+    PreparedStatement(
+                      shared_ptr<PreparedStatementHandle> handle,
+                      ExecutorProvider getExecutor,
+                      shared_ptr<react::CallInvoker> invoker
+                      );
+    ~PreparedStatement();
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &propNameId) override;
+    vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+  private:
+    shared_ptr<PreparedStatementHandle> handle;
+    ExecutorProvider getExecutor;
+    shared_ptr<react::CallInvoker> invoker;
+  };
+}
+
+#endif /* PreparedStatement_h */
@@ -0,0 +1,131 @@
+//
+//  QueryInterrupt.cpp
+//  react-native-quick-sqlite
+//
+
+#include "QueryInterrupt.h"
+#include <algorithm>
+
+using namespace std;
+
+// Innermost scope of the thread, the progress handler runs in the thread stepping the statement
+thread_local QueryInterruptScope *currentScope = nullptr;
+
+QueryCancellation::QueryCancellation() : cancelled(false)
+{
+}
+
+void QueryCancellation::cancel()
+{
+  cancelled = true;
+
+  vector<pair<TaskHandle, function<void(void)>>> queued;
+  {
+    lock_guard<mutex> g(tasksMutex);
+    queued.swap(tasks);
+  }
+  for (auto &task : queued)
+  {
+    if (task.first->cancel())
+    {
+      task.second();
+    }
+  }
+}
+
+bool QueryCancellation::isCancelled() const
+{
+  return cancelled;
+}
+
+void QueryCancellation::addTask(TaskHandle task, function<void(void)> onCancelled)
+{
+  {
+    lock_guard<mutex> g(tasksMutex);
+    if (!cancelled)
+    {
+      // A token reused for many queries only keeps the ones still waiting
+      tasks.erase(remove_if(tasks.begin(), tasks.end(), [](pair<TaskHandle, function<void(void)>> const &queued)
+                            { return !queued.first->isQueued(); }),
+                  tasks.end());
+      tasks.emplace_back(move(task), move(onCancelled));
+      return;
+    }
+  }
+
+  if (task->cancel())
+  {
+    onCancelled();
+  }
+}
+
+QueryInterruptScope::QueryInterruptScope(QueryInterruptOptions const &options) : options(options), previous(currentScope)
+{
+  currentScope = this;
+}
+
+QueryInterruptScope::~QueryInterruptScope()
+{
+  currentScope = previous;
+}
+
+const char *QueryInterruptScope::interruptReason() const
+{
+  if (options.cancellation != nullptr && options.cancellation->isCancelled())
+  {
+    return QUERY_CANCELLED_MESSAGE;
+  }
+  if (options.deadline != QueryDeadline::max() && chrono::steady_clock::now() >= options.deadline)
+  {
+    return QUERY_TIMED_OUT_MESSAGE;
+  }
+  return nullptr;
+}
+
+bool QueryInterruptScope::isCurrentThreadInterrupted()
+{
+  for (QueryInterruptScope *scope = currentScope; scope != nullptr; scope = scope->previous)
+  {
+    if (scope->interruptReason() != nullptr)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// A non-zero return makes the running statement fail with SQLITE_INTERRUPT
+int interrupt_progress_handler(void *context)
+{
+  return QueryInterruptScope::isCurrentThreadInterrupted() ? 1 : 0;
+}
+
+void installQueryInterruptHandler(sqlite3 *db)
+{
+  sqlite3_progress_handler(db, INTERRUPT_CHECK_INSTRUCTIONS, interrupt_progress_handler, nullptr);
+}
+
+SQLiteOPResult runInterruptible(QueryInterruptOptions const &options, function<SQLiteOPResult(void)> execute)
+{
+  if (options.isEmpty())
+  {
+    return execute();
+  }
+
+  QueryInterruptScope scope(options);
+  const char *reason = scope.interruptReason();
+  if (reason == nullptr)
+  {
+    SQLiteOPResult status = execute();
+    reason = status.type == SQLiteError ? scope.interruptReason() : nullptr;
+    if (reason == nullptr)
+    {
+      return status;
+    }
+  }
+
+  return SQLiteOPResult{
+    .type = SQLiteError,
+    .errorMessage = reason,
+  };
+}
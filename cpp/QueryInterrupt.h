@@ -0,0 +1,97 @@
+//
+//  QueryInterrupt.h
+//  react-native-quick-sqlite
+//
+//  Cancellation and timeouts of queries, checked by a progress handler installed on every connection
+//
+
+#ifndef QueryInterrupt_h
+#define QueryInterrupt_h
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <sqlite3.h>
+#include "JSIHelper.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Virtual machine instructions between two checks, a few microseconds of work
+#define INTERRUPT_CHECK_INSTRUCTIONS 1000
+
+#define QUERY_CANCELLED_MESSAGE "[react-native-quick-sqlite] Query cancelled"
+#define QUERY_TIMED_OUT_MESSAGE "[react-native-quick-sqlite] Query timed out"
+
+typedef chrono::steady_clock::time_point QueryDeadline;
+
+/**
+ * Shared by the queries given the same cancel token, cancelling it drops the ones still queued
+ * and stops the running ones at their next progress check
+ */
+class QueryCancellation {
+public:
+  QueryCancellation();
+
+  void cancel();
+  bool isCancelled() const;
+
+  /**
+   * Remembers a queued task, onCancelled runs in the thread calling cancel if the task never started.
+   * A task added after the token was cancelled is cancelled right away
+   */
+  void addTask(TaskHandle task, function<void(void)> onCancelled);
+
+private:
+  atomic<bool> cancelled;
+  mutex tasksMutex;
+  vector<pair<TaskHandle, function<void(void)>>> tasks;
+};
+
+struct QueryInterruptOptions
+{
+  shared_ptr<QueryCancellation> cancellation;
+  // Measured from the call, the time spent queued counts
+  QueryDeadline deadline = QueryDeadline::max();
+
+  bool isEmpty() const
+  {
+    return cancellation == nullptr && deadline == QueryDeadline::max();
+  }
+};
+
+/**
+ * Applies the options to the queries run by the current thread until it is destroyed.
+ * Scopes nest, a query run by a custom function also stops with the query that called it
+ */
+class QueryInterruptScope {
+public:
+  QueryInterruptScope(QueryInterruptOptions const &options);
+  ~QueryInterruptScope();
+
+  // nullptr while the queries may run, otherwise the error message of the interruption
+  const char *interruptReason() const;
+
+  static bool isCurrentThreadInterrupted();
+
+private:
+  const QueryInterruptOptions options;
+  QueryInterruptScope *previous;
+};
+
+/**
+ * MUST be called once on every connection, replaces any other progress handler
+ */
+void installQueryInterruptHandler(sqlite3 *db);
+
+/**
+ * Runs execute within a QueryInterruptScope. When the token was cancelled or the deadline passed,
+ * before or during the execution, the result is an error with the reason instead
+ */
+SQLiteOPResult runInterruptible(QueryInterruptOptions const &options, function<SQLiteOPResult(void)> execute);
+
+#endif /* QueryInterrupt_h */
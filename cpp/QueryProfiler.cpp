@@ -0,0 +1,91 @@
+//
+//  QueryProfiler.cpp
+//  react-native-quick-sqlite
+//
+
+#include "QueryProfiler.h"
+#include <algorithm>
+
+using namespace std;
+
+QueryStats &QueryProfiler::statsOf(string const &query)
+{
+  auto existing = stats.find(query);
+  if (existing != stats.end())
+  {
+    return existing->second;
+  }
+  if (stats.size() >= MAX_PROFILED_QUERIES)
+  {
+    return stats[PROFILER_OVERFLOW_QUERY];
+  }
+  return stats[query];
+}
+
+void QueryProfiler::recordExecution(string const &query, QueryExecution const &execution)
+{
+  lock_guard<mutex> g(statsMutex);
+  QueryStats &queryStats = statsOf(query);
+  queryStats.calls += execution.runs;
+  queryStats.errors += execution.isFailed ? 1 : 0;
+  queryStats.prepareMs += execution.prepareMs;
+  queryStats.stepMs += execution.stepMs;
+  queryStats.maxMs = max(queryStats.maxMs, execution.prepareMs + execution.stepMs);
+  queryStats.rows += execution.rows;
+  queryStats.bytes += execution.bytes;
+  queryStats.fullscanSteps += execution.fullscanSteps;
+  queryStats.sorts += execution.sorts;
+  queryStats.autoindexes += execution.autoindexes;
+}
+
+void QueryProfiler::recordMarshal(string const &query, double ms)
+{
+  lock_guard<mutex> g(statsMutex);
+  statsOf(query).marshalMs += ms;
+}
+
+void QueryProfiler::recordQueueWait(string const &query, double ms)
+{
+  lock_guard<mutex> g(statsMutex);
+  statsOf(query).queueWaitMs += ms;
+}
+
+vector<pair<string, QueryStats>> QueryProfiler::getStats()
+{
+  vector<pair<string, QueryStats>> sortedStats;
+  {
+    lock_guard<mutex> g(statsMutex);
+    sortedStats.assign(stats.begin(), stats.end());
+  }
+
+  auto totalMs = [](QueryStats const &s)
+  { return s.prepareMs + s.stepMs + s.marshalMs + s.queueWaitMs; };
+  sort(sortedStats.begin(), sortedStats.end(), [&totalMs](pair<string, QueryStats> const &a, pair<string, QueryStats> const &b)
+       { return totalMs(a.second) > totalMs(b.second); });
+  return sortedStats;
+}
+
+void QueryProfiler::reset()
+{
+  lock_guard<mutex> g(statsMutex);
+  stats.clear();
+}
+
+bool TraceBuffer::push(TraceEvent event)
+{
+  lock_guard<mutex> g(eventsMutex);
+  if (events.size() >= MAX_TRACE_EVENTS)
+  {
+    return false;
+  }
+  events.push_back(move(event));
+  return events.size() == 1;
+}
+
+vector<TraceEvent> TraceBuffer::take()
+{
+  lock_guard<mutex> g(eventsMutex);
+  vector<TraceEvent> taken;
+  taken.swap(events);
+  return taken;
+}
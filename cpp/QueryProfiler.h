@@ -0,0 +1,119 @@
+//
+//  QueryProfiler.h
+//  react-native-quick-sqlite
+//
+//  Aggregated timings and SQLite counters per query of a database, enabled with the profile open option
+//
+
+#ifndef QueryProfiler_h
+#define QueryProfiler_h
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Distinct queries tracked, once reached new ones are aggregated under PROFILER_OVERFLOW_QUERY
+#define MAX_PROFILED_QUERIES 256
+#define PROFILER_OVERFLOW_QUERY "(other queries)"
+// Trace events waiting for the JS thread, later ones are dropped until the buffer is flushed
+#define MAX_TRACE_EVENTS 10000
+
+typedef chrono::steady_clock::time_point ProfilerTime;
+
+inline ProfilerTime profilerNow()
+{
+  return chrono::steady_clock::now();
+}
+
+inline double elapsedMs(ProfilerTime start, ProfilerTime end)
+{
+  return chrono::duration<double, milli>(end - start).count();
+}
+
+/**
+ * Measures of a single execution, a statement run for several parameter sets counts as runs executions
+ */
+struct QueryExecution
+{
+  double prepareMs = 0;
+  double stepMs = 0;
+  long long rows = 0;
+  long long bytes = 0;
+  long long fullscanSteps = 0;
+  long long sorts = 0;
+  long long autoindexes = 0;
+  int runs = 1;
+  bool isFailed = false;
+};
+
+/**
+ * Totals of every execution of a query since the last reset
+ */
+struct QueryStats
+{
+  long long calls = 0;
+  long long errors = 0;
+  // Taking the statement from the cache (compiling it on a miss) and binding the parameters
+  double prepareMs = 0;
+  // Stepping the statement and reading the rows
+  double stepMs = 0;
+  // Converting the results into JS values on the JavaScript Thread
+  double marshalMs = 0;
+  // Time async executions waited for a worker thread
+  double queueWaitMs = 0;
+  // Slowest prepare and step of a single execution
+  double maxMs = 0;
+  long long rows = 0;
+  long long bytes = 0;
+  long long fullscanSteps = 0;
+  long long sorts = 0;
+  long long autoindexes = 0;
+};
+
+/**
+ * Every method MAY be called from any thread
+ */
+class QueryProfiler {
+public:
+  void recordExecution(string const &query, QueryExecution const &execution);
+  void recordMarshal(string const &query, double ms);
+  void recordQueueWait(string const &query, double ms);
+
+  // Sorted by the total time spent, slowest first
+  vector<pair<string, QueryStats>> getStats();
+  void reset();
+
+private:
+  mutex statsMutex;
+  unordered_map<string, QueryStats> stats;
+
+  // MUST be called with statsMutex held
+  QueryStats &statsOf(string const &query);
+};
+
+struct TraceEvent
+{
+  string sql;
+  double durationMs;
+};
+
+/**
+ * Statements traced on the worker threads until the JS thread takes them
+ */
+class TraceBuffer {
+public:
+  // Returns true when the buffer was empty, the caller then schedules a flush
+  bool push(TraceEvent event);
+  vector<TraceEvent> take();
+
+private:
+  mutex eventsMutex;
+  vector<TraceEvent> events;
+};
+
+#endif /* QueryProfiler_h */
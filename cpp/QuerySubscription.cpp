@@ -0,0 +1,195 @@
+//
+//  QuerySubscription.cpp
+//  react-native-quick-sqlite
+//
+
+#include "QuerySubscription.h"
+#include <algorithm>
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  /**
+   * Rowids changed per table, null for a table changed in too many rows to list them
+   */
+  jsi::Object createChangesObject(jsi::Runtime &rt, ChangeSet const &changes)
+  {
+    jsi::Object object = jsi::Object(rt);
+    for (auto &change : changes)
+    {
+      if (change.second.isTruncated)
+      {
+        object.setProperty(rt, change.first.c_str(), jsi::Value(nullptr));
+        continue;
+      }
+
+      jsi::Array rowids = jsi::Array(rt, change.second.rowids.size());
+      for (size_t i = 0; i < change.second.rowids.size(); i++)
+      {
+        rowids.setValueAtIndex(rt, i, jsi::Value((double)change.second.rowids[i]));
+      }
+      object.setProperty(rt, change.first.c_str(), move(rowids));
+    }
+    return object;
+  }
+
+  QuerySubscription::QuerySubscription(
+                                       jsi::Runtime &rt,
+                                       string dbName,
+                                       string query,
+                                       QuickParams params,
+                                       set<string> tables,
+                                       QuickResultFormat format,
+                                       shared_ptr<jsi::Function> callback,
+                                       shared_ptr<jsi::Function> onError,
+                                       shared_ptr<SerialExecutor> executor,
+                                       shared_ptr<react::CallInvoker> invoker
+                                       ) :
+  rt(&rt),
+  dbName(dbName),
+  query(query),
+  params(move(params)),
+  tables(tables),
+  format(format),
+  callback(callback),
+  onError(onError),
+  executor(executor),
+  invoker(invoker),
+  isCancelled(false),
+  isQueued(false)
+  {
+  }
+
+  void QuerySubscription::start()
+  {
+    lock_guard<mutex> g(changesMutex);
+    queueRun();
+  }
+
+  void QuerySubscription::notify(ChangeSet const &changes)
+  {
+    ChangeSet relevantChanges;
+    for (auto &change : changes)
+    {
+      if (tables.count(change.first) > 0)
+      {
+        relevantChanges.insert(change);
+      }
+    }
+    if (relevantChanges.empty() || isCancelled)
+    {
+      return;
+    }
+
+    lock_guard<mutex> g(changesMutex);
+    mergeChangeSet(&pendingChanges, relevantChanges);
+    queueRun();
+  }
+
+  void QuerySubscription::cancel()
+  {
+    isCancelled = true;
+    callback.reset();
+    onError.reset();
+  }
+
+  /**
+   * Commits in quick succession share a single run, MUST be called with changesMutex held
+   */
+  void QuerySubscription::queueRun()
+  {
+    if (isQueued)
+    {
+      return;
+    }
+    isQueued = true;
+
+    auto self = shared_from_this();
+    executor->queueWork([self]()
+                        { self->run(); });
+  }
+
+  void QuerySubscription::run()
+  {
+    ChangeSet changes;
+    {
+      // Changes committed from now on need another run
+      lock_guard<mutex> g(changesMutex);
+      changes.swap(pendingChanges);
+      isQueued = false;
+    }
+    if (isCancelled)
+    {
+      return;
+    }
+
+    // The commit hook notifies before the commit is done, the readers only see it once the writer released the connection
+    auto connectionMutex = sqliteGetConnectionMutex(dbName);
+    if (connectionMutex != nullptr)
+    {
+      lock_guard<ConnectionMutex> g(*connectionMutex);
+    }
+
+    auto results = make_shared<QuickResultSet>();
+    auto metadata = make_shared<vector<QuickColumnMetadata>>();
+    auto status = sqliteIsReadQuery(dbName, query)
+      ? sqliteExecuteRead(dbName, query, &params, results.get(), metadata.get())
+      : sqliteExecute(dbName, query, &params, results.get(), metadata.get());
+
+    auto self = shared_from_this();
+    invoker->invokeAsync([self, results, metadata, status_copy = move(status), changes = move(changes)]
+                         {
+      if (self->isCancelled)
+      {
+        return;
+      }
+
+      jsi::Runtime &rt = *self->rt;
+      if (status_copy.type == SQLiteError)
+      {
+        if (self->onError != nullptr)
+        {
+          auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+          auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+          self->onError->call(rt, error);
+        }
+        return;
+      }
+
+      auto jsiResult = createSequelQueryExecutionResult(rt, status_copy, results.get(), metadata.get(), self->format);
+      self->callback->call(rt, move(jsiResult), createChangesObject(rt, changes));
+    });
+  }
+
+  void QuerySubscriptions::add(shared_ptr<QuerySubscription> subscription)
+  {
+    lock_guard<mutex> g(subscriptionsMutex);
+    subscriptions.push_back(subscription);
+  }
+
+  void QuerySubscriptions::remove(shared_ptr<QuerySubscription> subscription)
+  {
+    lock_guard<mutex> g(subscriptionsMutex);
+    subscriptions.erase(std::remove(subscriptions.begin(), subscriptions.end(), subscription), subscriptions.end());
+  }
+
+  void QuerySubscriptions::notify(ChangeSet const &changes)
+  {
+    lock_guard<mutex> g(subscriptionsMutex);
+    for (auto &subscription : subscriptions)
+    {
+      subscription->notify(changes);
+    }
+  }
+
+  void QuerySubscriptions::cancelAll()
+  {
+    lock_guard<mutex> g(subscriptionsMutex);
+    for (auto &subscription : subscriptions)
+    {
+      subscription->cancel();
+    }
+    subscriptions.clear();
+  }
+}
@@ -0,0 +1,88 @@
+//
+//  QuerySubscription.h
+//  react-native-quick-sqlite
+//
+//  Query re-run on a worker thread whenever a transaction changed one of its tables
+//
+
+#ifndef QuerySubscription_h
+#define QuerySubscription_h
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+#include "sqliteBridge.h"
+#include "SerialExecutor.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  class QuerySubscription : public enable_shared_from_this<QuerySubscription> {
+  public:
+    QuerySubscription(
+                      jsi::Runtime &rt,
+                      string dbName,
+                      string query,
+                      QuickParams params,
+                      set<string> tables,
+                      QuickResultFormat format,
+                      shared_ptr<jsi::Function> callback,
+                      shared_ptr<jsi::Function> onError,
+                      shared_ptr<SerialExecutor> executor,
+                      shared_ptr<react::CallInvoker> invoker
+                      );
+
+    // Queues the first run, the callback receives the current results
+    void start();
+    /**
+     * Queues a run if the changes touched one of the tables, changes arriving before it started are merged.
+     * MAY be called from any thread
+     */
+    void notify(ChangeSet const &changes);
+    // No run or callback happens afterwards, MUST be called in the JavaScript Thread
+    void cancel();
+
+  private:
+    jsi::Runtime *rt;
+    const string dbName;
+    const string query;
+    QuickParams params;
+    const set<string> tables;
+    const QuickResultFormat format;
+    // Only used and released in the JavaScript Thread
+    shared_ptr<jsi::Function> callback;
+    shared_ptr<jsi::Function> onError;
+    shared_ptr<SerialExecutor> executor;
+    shared_ptr<react::CallInvoker> invoker;
+
+    atomic<bool> isCancelled;
+    mutex changesMutex;
+    // Changes not passed to the callback yet, they are merged until the queued run takes them
+    ChangeSet pendingChanges;
+    bool isQueued;
+
+    void queueRun();
+    void run();
+  };
+
+  /**
+   * Subscriptions of a database, notified by the change listener of its connection
+   */
+  class QuerySubscriptions {
+  public:
+    void add(shared_ptr<QuerySubscription> subscription);
+    void remove(shared_ptr<QuerySubscription> subscription);
+    void notify(ChangeSet const &changes);
+    // MUST be called in the JavaScript Thread
+    void cancelAll();
+
+  private:
+    mutex subscriptionsMutex;
+    vector<shared_ptr<QuerySubscription>> subscriptions;
+  };
+}
+
+#endif /* QuerySubscription_h */
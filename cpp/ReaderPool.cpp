@@ -0,0 +1,193 @@
+//
+//  ReaderPool.cpp
+//  react-native-quick-sqlite
+//
+
+#include "ReaderPool.h"
+#include "JSThreadDispatcher.h"
+
+using namespace std;
+
+// Bounds the memory used to remember query kinds when the SQL text is not reused
+#define MAX_KNOWN_QUERIES 1024
+
+ReaderPool::ReaderPool()
+{
+}
+
+ReaderPool::~ReaderPool()
+{
+  close();
+}
+
+int ReaderPool::open(const string &dbPath, size_t count, size_t statementCacheSize, function<int(sqlite3 *, string *)> configure, string *errorMessage)
+{
+  // dbPath can be the URI of a bundled database
+  int sqlOpenFlags = SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    sqlite3 *db;
+    int exit = sqlite3_open_v2(dbPath.c_str(), &db, sqlOpenFlags, nullptr);
+    if (exit != SQLITE_OK)
+    {
+      *errorMessage = sqlite3_errmsg(db);
+      sqlite3_close_v2(db);
+      close();
+      return exit;
+    }
+
+    exit = configure(db, errorMessage);
+    if (exit != SQLITE_OK)
+    {
+      sqlite3_close_v2(db);
+      close();
+      return exit;
+    }
+
+    lock_guard<mutex> g(poolMutex);
+    connections.push_back(new ReaderConnection{
+      .db = db,
+      .statementCache = make_shared<StatementCache>(db, statementCacheSize),
+      .isBusy = false,
+    });
+  }
+
+  return SQLITE_OK;
+}
+
+ReaderConnection *ReaderPool::acquire()
+{
+  unique_lock<mutex> g(poolMutex);
+  ReaderConnection *idle = nullptr;
+  idleConditionVariable.wait(g, [&]
+                             {
+    for (auto connection : connections)
+    {
+      if (!connection->isBusy)
+      {
+        idle = connection;
+        return true;
+      }
+    }
+    return false; });
+
+  idle->isBusy = true;
+  return idle;
+}
+
+void ReaderPool::release(ReaderConnection *connection)
+{
+  {
+    lock_guard<mutex> g(poolMutex);
+    connection->isBusy = false;
+  }
+  // Wakes a waiting query as well as a pending close
+  idleConditionVariable.notify_all();
+  JSThreadDispatcher::wake();
+}
+
+void ReaderPool::waitUntil(unique_lock<mutex> &g, function<bool(void)> isDone)
+{
+  if (!JSThreadDispatcher::isJSThread())
+  {
+    idleConditionVariable.wait(g, isDone);
+    return;
+  }
+
+  // A busy reader might be waiting for the JS thread to run a custom function
+  g.unlock();
+  JSThreadDispatcher::runPendingCallsUntil([&]()
+                                           {
+    g.lock();
+    if (isDone())
+    {
+      return true;
+    }
+    g.unlock();
+    return false; });
+}
+
+void ReaderPool::forEachConnection(function<void(ReaderConnection *)> fn)
+{
+  for (size_t i = 0; i < size(); i++)
+  {
+    ReaderConnection *connection;
+    {
+      unique_lock<mutex> g(poolMutex);
+      connection = connections[i];
+      waitUntil(g, [&]
+                { return !connection->isBusy; });
+      connection->isBusy = true;
+    }
+
+    fn(connection);
+    release(connection);
+  }
+}
+
+void ReaderPool::interrupt()
+{
+  // Connections are only closed with poolMutex held
+  lock_guard<mutex> g(poolMutex);
+  for (auto connection : connections)
+  {
+    if (connection->isBusy)
+    {
+      sqlite3_interrupt(connection->db);
+    }
+  }
+}
+
+void ReaderPool::clearStatementCaches()
+{
+  lock_guard<mutex> g(poolMutex);
+  for (auto connection : connections)
+  {
+    connection->statementCache->clear();
+  }
+}
+
+void ReaderPool::setReadOnly(const string &sql, bool isReadOnly)
+{
+  lock_guard<mutex> g(queryMutex);
+  if (readOnlyQueries.size() >= MAX_KNOWN_QUERIES && readOnlyQueries.count(sql) == 0)
+  {
+    readOnlyQueries.clear();
+  }
+  readOnlyQueries[sql] = isReadOnly;
+}
+
+bool ReaderPool::isReadOnly(const string &sql)
+{
+  lock_guard<mutex> g(queryMutex);
+  auto query = readOnlyQueries.find(sql);
+  return query != readOnlyQueries.end() && query->second;
+}
+
+void ReaderPool::close()
+{
+  unique_lock<mutex> g(poolMutex);
+  // Wait for the queries still running on the readers
+  waitUntil(g, [&]
+            {
+    for (auto connection : connections)
+    {
+      if (connection->isBusy) return false;
+    }
+    return true; });
+
+  for (auto connection : connections)
+  {
+    connection->statementCache->clear();
+    sqlite3_close_v2(connection->db);
+    delete connection;
+  }
+  connections.clear();
+}
+
+size_t ReaderPool::size()
+{
+  lock_guard<mutex> g(poolMutex);
+  return connections.size();
+}
@@ -0,0 +1,80 @@
+//
+//  ReaderPool.h
+//  react-native-quick-sqlite
+//
+//  Read-only connections of a WAL database, used to run async reads concurrently with the writer
+//
+
+#ifndef ReaderPool_h
+#define ReaderPool_h
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sqlite3.h>
+#include "StatementCache.h"
+
+using namespace std;
+
+struct ReaderConnection
+{
+  sqlite3 *db;
+  shared_ptr<StatementCache> statementCache;
+  bool isBusy;
+};
+
+class ReaderPool {
+public:
+  ReaderPool();
+  ~ReaderPool();
+
+  /**
+   * Opens count read-only connections to the database file, configure runs on each of them once opened.
+   * Returns the SQLite status code and fills errorMessage if a connection could not be opened
+   */
+  int open(const string &dbPath, size_t count, size_t statementCacheSize, function<int(sqlite3 *, string *)> configure, string *errorMessage);
+
+  /**
+   * Blocks until a reader is idle and reserves it for the caller
+   */
+  ReaderConnection *acquire();
+  void release(ReaderConnection *connection);
+
+  /**
+   * Runs fn on every reader, waiting for each of them to be idle.
+   * Used to keep the readers in sync with the writer (attached databases, functions)
+   */
+  void forEachConnection(function<void(ReaderConnection *)> fn);
+
+  // sqlite3_interrupt on the readers running a query
+  void interrupt();
+  void clearStatementCaches();
+  void close();
+  size_t size();
+
+  /**
+   * Remember whether the SQL only reads the database, as reported by sqlite3_stmt_readonly
+   * the first time it was prepared. Only queries known to be read-only are sent to the readers
+   */
+  void setReadOnly(const string &sql, bool isReadOnly);
+  bool isReadOnly(const string &sql);
+
+private:
+  vector<ReaderConnection *> connections;
+  mutex poolMutex;
+  condition_variable idleConditionVariable;
+
+  /**
+   * Waits on idleConditionVariable, the JS thread runs the pending custom function calls meanwhile
+   */
+  void waitUntil(unique_lock<mutex> &g, function<bool(void)> isDone);
+
+  mutex queryMutex;
+  unordered_map<string, bool> readOnlyQueries;
+};
+
+#endif /* ReaderPool_h */
@@ -0,0 +1,233 @@
+//
+//  SQLFileReader.cpp
+//  react-native-quick-sqlite
+//
+
+#include "SQLFileReader.h"
+#include <vector>
+#include <zlib.h>
+#ifdef QUICK_SQLITE_USE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+// Compressed bytes read from the file at once
+#define COMPRESSED_CHUNK_SIZE (256 * 1024)
+
+class PlainSQLFileReader : public SQLFileReader {
+public:
+  PlainSQLFileReader(ifstream &&file, size_t fileSize) : SQLFileReader(move(file), fileSize)
+  {
+  }
+
+  size_t read(char *buffer, size_t size) override
+  {
+    return readFile(buffer, size);
+  }
+};
+
+class GzipSQLFileReader : public SQLFileReader {
+public:
+  GzipSQLFileReader(ifstream &&file, size_t fileSize) : SQLFileReader(move(file), fileSize), input(COMPRESSED_CHUNK_SIZE), isFinished(false)
+  {
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    // 16 selects the gzip wrapper
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+    {
+      errorMessage = "[react-native-quick-sqlite][loadSQLFile] Could not initialize gzip decompression";
+      isFinished = true;
+    }
+  }
+
+  ~GzipSQLFileReader()
+  {
+    inflateEnd(&stream);
+  }
+
+  size_t read(char *buffer, size_t size) override
+  {
+    stream.next_out = reinterpret_cast<Bytef *>(buffer);
+    stream.avail_out = (uInt)size;
+
+    while (stream.avail_out > 0 && !isFinished)
+    {
+      if (stream.avail_in == 0 && !fillInput())
+      {
+        errorMessage = "[react-native-quick-sqlite][loadSQLFile] The gzip file is truncated";
+        isFinished = true;
+        break;
+      }
+
+      int status = inflate(&stream, Z_NO_FLUSH);
+      if (status == Z_STREAM_END)
+      {
+        // gzip files can be made of several members, continue with the next one if there is one
+        if (stream.avail_in == 0 && !fillInput())
+        {
+          isFinished = true;
+          break;
+        }
+        inflateReset(&stream);
+      }
+      else if (status != Z_OK && status != Z_BUF_ERROR)
+      {
+        errorMessage = "[react-native-quick-sqlite][loadSQLFile] The gzip file is corrupted";
+        isFinished = true;
+      }
+    }
+
+    return size - stream.avail_out;
+  }
+
+private:
+  z_stream stream;
+  vector<char> input;
+  bool isFinished;
+
+  bool fillInput()
+  {
+    size_t length = readFile(input.data(), input.size());
+    stream.next_in = reinterpret_cast<Bytef *>(input.data());
+    stream.avail_in = (uInt)length;
+    return length > 0;
+  }
+};
+
+#ifdef QUICK_SQLITE_USE_ZSTD
+class ZstdSQLFileReader : public SQLFileReader {
+public:
+  ZstdSQLFileReader(ifstream &&file, size_t fileSize) : SQLFileReader(move(file), fileSize), input(COMPRESSED_CHUNK_SIZE), isFinished(false), pendingFrame(0)
+  {
+    stream = ZSTD_createDStream();
+    inputBuffer = {input.data(), 0, 0};
+    if (stream == NULL)
+    {
+      errorMessage = "[react-native-quick-sqlite][loadSQLFile] Could not initialize zstd decompression";
+      isFinished = true;
+    }
+  }
+
+  ~ZstdSQLFileReader()
+  {
+    ZSTD_freeDStream(stream);
+  }
+
+  size_t read(char *buffer, size_t size) override
+  {
+    ZSTD_outBuffer outputBuffer = {buffer, size, 0};
+
+    while (outputBuffer.pos < outputBuffer.size && !isFinished)
+    {
+      if (inputBuffer.pos == inputBuffer.size)
+      {
+        size_t length = readFile(input.data(), input.size());
+        if (length == 0)
+        {
+          // 0 means the last frame was fully decoded
+          if (pendingFrame != 0)
+          {
+            errorMessage = "[react-native-quick-sqlite][loadSQLFile] The zstd file is truncated";
+          }
+          isFinished = true;
+          break;
+        }
+        inputBuffer = {input.data(), length, 0};
+      }
+
+      pendingFrame = ZSTD_decompressStream(stream, &outputBuffer, &inputBuffer);
+      if (ZSTD_isError(pendingFrame))
+      {
+        errorMessage = "[react-native-quick-sqlite][loadSQLFile] The zstd file is corrupted: " + string(ZSTD_getErrorName(pendingFrame));
+        isFinished = true;
+      }
+    }
+
+    return outputBuffer.pos;
+  }
+
+private:
+  ZSTD_DStream *stream;
+  vector<char> input;
+  ZSTD_inBuffer inputBuffer;
+  bool isFinished;
+  size_t pendingFrame;
+};
+#endif
+
+unique_ptr<SQLFileReader> SQLFileReader::open(const string &path, string *errorMessage)
+{
+  ifstream file(path, ios::binary);
+  if (!file.is_open())
+  {
+    *errorMessage = "[react-native-quick-sqlite][loadSQLFile] Could not open file";
+    return nullptr;
+  }
+
+  file.seekg(0, ios::end);
+  size_t fileSize = (size_t)file.tellg();
+  file.seekg(0, ios::beg);
+
+  unsigned char magic[4] = {0, 0, 0, 0};
+  file.read(reinterpret_cast<char *>(magic), sizeof(magic));
+  file.clear();
+  file.seekg(0, ios::beg);
+
+  if (magic[0] == 0x1f && magic[1] == 0x8b)
+  {
+    return unique_ptr<SQLFileReader>(new GzipSQLFileReader(move(file), fileSize));
+  }
+
+  if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+  {
+#ifdef QUICK_SQLITE_USE_ZSTD
+    return unique_ptr<SQLFileReader>(new ZstdSQLFileReader(move(file), fileSize));
+#else
+    *errorMessage = "[react-native-quick-sqlite][loadSQLFile] zstd compressed files need the QUICK_SQLITE_USE_ZSTD flag";
+    return nullptr;
+#endif
+  }
+
+  return unique_ptr<SQLFileReader>(new PlainSQLFileReader(move(file), fileSize));
+}
+
+SQLFileReader::SQLFileReader(ifstream &&file, size_t fileSize) : file(move(file)), fileSize(fileSize), consumed(0)
+{
+}
+
+SQLFileReader::~SQLFileReader()
+{
+  file.close();
+}
+
+size_t SQLFileReader::readFile(char *buffer, size_t size)
+{
+  if (!file)
+  {
+    return 0;
+  }
+
+  file.read(buffer, size);
+  size_t length = (size_t)file.gcount();
+  consumed += length;
+  return length;
+}
+
+size_t SQLFileReader::bytesRead() const
+{
+  return consumed;
+}
+
+size_t SQLFileReader::totalBytes() const
+{
+  return fileSize;
+}
+
+const string &SQLFileReader::error() const
+{
+  return errorMessage;
+}
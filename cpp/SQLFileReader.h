@@ -0,0 +1,49 @@
+//
+//  SQLFileReader.h
+//  react-native-quick-sqlite
+//
+//  Reads plain, gzip or zstd compressed SQL files in chunks
+//
+
+#ifndef SQLFileReader_h
+#define SQLFileReader_h
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+class SQLFileReader {
+public:
+  /**
+   * Opens the file, compressed files are recognized by their first bytes and decompressed while reading.
+   * Returns nullptr and sets errorMessage if the file cannot be read
+   */
+  static unique_ptr<SQLFileReader> open(const string &path, string *errorMessage);
+  virtual ~SQLFileReader();
+
+  /**
+   * Fills buffer with up to size bytes of SQL, returns 0 once the file is done or failed
+   */
+  virtual size_t read(char *buffer, size_t size) = 0;
+
+  // Bytes of the file consumed so far, compressed files consume fewer bytes than they produce
+  size_t bytesRead() const;
+  size_t totalBytes() const;
+  // Set when the file is corrupted or truncated
+  const string &error() const;
+
+protected:
+  SQLFileReader(ifstream &&file, size_t fileSize);
+  size_t readFile(char *buffer, size_t size);
+
+  string errorMessage;
+
+private:
+  ifstream file;
+  size_t fileSize;
+  size_t consumed;
+};
+
+#endif /* SQLFileReader_h */
@@ -0,0 +1,127 @@
+//
+//  SerialExecutor.cpp
+//  react-native-quick-sqlite
+//
+
+#include "SerialExecutor.h"
+
+SerialExecutor::SerialExecutor(std::shared_ptr<ThreadPool> pool) : pool(pool), isScheduled(false), isPaused(false), isParked(false)
+{
+}
+
+TaskHandle SerialExecutor::queueWork(std::function<void(void)> task, TaskPriority priority)
+{
+  auto handle = std::make_shared<PoolTask>(std::move(task), priority);
+  std::lock_guard<std::mutex> g(workQueueMutex);
+  workQueue.push(handle);
+  if (!isScheduled)
+  {
+    isScheduled = true;
+    schedule();
+  }
+  return handle;
+}
+
+void SerialExecutor::schedule()
+{
+  auto pool = this->pool.lock();
+  if (pool == nullptr)
+  {
+    dropQueuedTasks();
+    return;
+  }
+
+  // The pool task keeps the executor alive even if the database is closed in the meantime
+  auto self = shared_from_this();
+  pool->queueWork([self]()
+                  { self->runNext(); }, workQueue.front()->getPriority());
+}
+
+void SerialExecutor::dropQueuedTasks()
+{
+  while (!workQueue.empty())
+  {
+    workQueue.front()->cancel();
+    workQueue.pop();
+  }
+  isScheduled = false;
+}
+
+void SerialExecutor::runNext()
+{
+  TaskHandle task;
+  {
+    std::lock_guard<std::mutex> g(workQueueMutex);
+    while (!workQueue.empty() && task == nullptr)
+    {
+      if (workQueue.front()->start())
+      {
+        task = workQueue.front();
+      }
+      workQueue.pop();
+    }
+  }
+
+  if (task != nullptr)
+  {
+    try
+    {
+      task->work();
+    }
+    catch (...)
+    {
+      // Tasks report their own errors back to JS, a failing one must not stall the ones behind it
+    }
+  }
+
+  std::lock_guard<std::mutex> g(workQueueMutex);
+  if (isPaused)
+  {
+    // isScheduled stays set so new tasks are only queued, resume picks them up
+    isParked = true;
+    return;
+  }
+
+  // Going back through the pool instead of looping lets the other databases take turns
+  if (workQueue.empty())
+  {
+    isScheduled = false;
+  }
+  else
+  {
+    schedule();
+  }
+}
+
+bool SerialExecutor::isIdle()
+{
+  std::lock_guard<std::mutex> g(workQueueMutex);
+  return !isScheduled;
+}
+
+void SerialExecutor::pause()
+{
+  std::lock_guard<std::mutex> g(workQueueMutex);
+  isPaused = true;
+}
+
+void SerialExecutor::resume()
+{
+  std::lock_guard<std::mutex> g(workQueueMutex);
+  isPaused = false;
+  // When the paused task is still running it continues with the queue itself
+  if (!isParked)
+  {
+    return;
+  }
+
+  isParked = false;
+  if (workQueue.empty())
+  {
+    isScheduled = false;
+  }
+  else
+  {
+    schedule();
+  }
+}
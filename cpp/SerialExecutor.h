@@ -0,0 +1,69 @@
+//
+//  SerialExecutor.h
+//  react-native-quick-sqlite
+//
+//  Runs the tasks of a single database one at a time and in order on the shared ThreadPool
+//
+
+#ifndef SerialExecutor_h
+#define SerialExecutor_h
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include "ThreadPool.h"
+
+class SerialExecutor;
+
+/**
+ * Returns the executor to queue a task on at the time it is queued. Objects kept by JS, like prepared statements,
+ * hold one instead of an executor, as the tasks of a database go to another executor while a transaction is open
+ */
+typedef std::function<std::shared_ptr<SerialExecutor>(void)> ExecutorProvider;
+
+class SerialExecutor : public std::enable_shared_from_this<SerialExecutor> {
+public:
+  SerialExecutor(std::shared_ptr<ThreadPool> pool);
+  /**
+   * Tasks keep their order whatever their priority, it decides the lane of the pool the executor takes its turn in.
+   * A cancelled task is skipped when its turn comes
+   */
+  TaskHandle queueWork(std::function<void(void)> task, TaskPriority priority = PRIORITY_INTERACTIVE);
+
+  /**
+   * Called from inside a running task, the tasks queued behind it wait until resume is called.
+   * Used by transactions to own the database until they are committed or rolled back
+   */
+  void pause();
+  void resume();
+
+  // No task is queued or running
+  bool isIdle();
+
+private:
+  // Owned by the module, a task queued after it was released is dropped
+  std::weak_ptr<ThreadPool> pool;
+
+  // Mutex to protect workQueue and isScheduled
+  std::mutex workQueueMutex;
+
+  // Tasks waiting for the previous ones of this database to finish
+  std::queue<TaskHandle> workQueue;
+
+  // Set while a task of this executor is queued or running on the pool. Only one is handed
+  // to the pool at a time, which keeps FIFO order and lets other databases use the remaining threads
+  bool isScheduled;
+
+  // Set between pause and resume, isParked once the paused task has returned
+  bool isPaused;
+  bool isParked;
+
+  // MUST be called with workQueueMutex held and a task queued
+  void schedule();
+  // MUST be called with workQueueMutex held
+  void dropQueuedTasks();
+  void runNext();
+};
+
+#endif /* SerialExecutor_h */
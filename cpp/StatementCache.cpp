@@ -0,0 +1,122 @@
+//
+//  StatementCache.cpp
+//  react-native-quick-sqlite
+//
+
+#include "StatementCache.h"
+#include <cctype>
+
+using namespace std;
+
+StatementCache::StatementCache(sqlite3 *db, size_t capacity) : db(db), capacity(capacity), generation(0)
+{
+}
+
+StatementCache::~StatementCache()
+{
+  clear();
+}
+
+int StatementCache::acquire(const string &sql, sqlite3_stmt **statement)
+{
+  {
+    lock_guard<mutex> g(cacheMutex);
+    auto hit = index.find(sql);
+    if (hit != index.end())
+    {
+      *statement = hit->second->second;
+      entries.erase(hit->second);
+      index.erase(hit);
+      acquired[*statement] = generation;
+      return SQLITE_OK;
+    }
+  }
+
+  // Preparing is the expensive part, do it outside of the lock
+  int status = sqlite3_prepare_v2(db, sql.c_str(), -1, statement, NULL);
+  if (status == SQLITE_OK && *statement != NULL)
+  {
+    lock_guard<mutex> g(cacheMutex);
+    acquired[*statement] = generation;
+  }
+  return status;
+}
+
+void StatementCache::release(const string &sql, sqlite3_stmt *statement)
+{
+  if (statement == NULL)
+  {
+    return;
+  }
+
+  sqlite3_reset(statement);
+  sqlite3_clear_bindings(statement);
+
+  lock_guard<mutex> g(cacheMutex);
+  auto owner = acquired.find(statement);
+  bool isStale = owner == acquired.end() || owner->second != generation;
+  if (owner != acquired.end())
+  {
+    acquired.erase(owner);
+  }
+
+  // A statement for the same SQL may have been released by another thread in the meantime
+  if (capacity == 0 || isStale || index.count(sql) > 0)
+  {
+    sqlite3_finalize(statement);
+    return;
+  }
+
+  entries.emplace_front(sql, statement);
+  index[sql] = entries.begin();
+
+  while (entries.size() > capacity)
+  {
+    auto &oldest = entries.back();
+    index.erase(oldest.first);
+    sqlite3_finalize(oldest.second);
+    entries.pop_back();
+  }
+}
+
+void StatementCache::clear()
+{
+  lock_guard<mutex> g(cacheMutex);
+  for (auto &entry : entries)
+  {
+    sqlite3_finalize(entry.second);
+  }
+  entries.clear();
+  index.clear();
+  generation++;
+}
+
+static bool startsWithKeyword(const char *sql, const char *const *keywords, size_t keywordCount)
+{
+  while (*sql != '\0' && (isspace((unsigned char)*sql) || *sql == ';'))
+  {
+    sql++;
+  }
+
+  for (size_t i = 0; i < keywordCount; i++)
+  {
+    size_t length = strlen(keywords[i]);
+    if (sqlite3_strnicmp(sql, keywords[i], (int)length) == 0 && !isalnum((unsigned char)sql[length]) && sql[length] != '_')
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool isSchemaStatement(const char *sql)
+{
+  static const char *keywords[] = {"CREATE", "DROP", "ALTER", "ATTACH", "DETACH"};
+  return startsWithKeyword(sql, keywords, sizeof(keywords) / sizeof(keywords[0]));
+}
+
+bool isTransactionStatement(const char *sql)
+{
+  static const char *keywords[] = {"BEGIN", "COMMIT", "END", "ROLLBACK", "SAVEPOINT", "RELEASE"};
+  return startsWithKeyword(sql, keywords, sizeof(keywords) / sizeof(keywords[0]));
+}
@@ -0,0 +1,69 @@
+//
+//  StatementCache.h
+//  react-native-quick-sqlite
+//
+//  Bounded LRU cache of prepared statements for a single connection
+//
+
+#ifndef StatementCache_h
+#define StatementCache_h
+
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <sqlite3.h>
+
+using namespace std;
+
+class StatementCache {
+public:
+  StatementCache(sqlite3 *db, size_t capacity);
+  ~StatementCache();
+
+  /**
+   * Takes a prepared statement for the given SQL out of the cache, preparing a new one on a miss.
+   * The statement is owned by the caller until it is handed back with release, so two threads
+   * running the same SQL never share a statement.
+   * Returns the sqlite3_prepare_v2 status code.
+   */
+  int acquire(const string &sql, sqlite3_stmt **statement);
+
+  /**
+   * Resets the statement, clears its bindings and puts it back in the cache,
+   * evicting (finalizing) the least recently used statement if the cache is full.
+   */
+  void release(const string &sql, sqlite3_stmt *statement);
+
+  /**
+   * Finalizes every cached statement. Statements currently acquired are finalized on release.
+   */
+  void clear();
+
+private:
+  sqlite3 *db;
+  size_t capacity;
+  // Used to detect statements acquired before the last clear, those must not return to the cache
+  unsigned long generation;
+  unordered_map<sqlite3_stmt *, unsigned long> acquired;
+
+  mutex cacheMutex;
+  // Most recently used statements live at the front
+  list<pair<string, sqlite3_stmt *>> entries;
+  unordered_map<string, list<pair<string, sqlite3_stmt *>>::iterator> index;
+};
+
+/**
+ * Whether the SQL modifies the schema (CREATE, DROP, ALTER, ATTACH, DETACH),
+ * after running such a statement the cache of the connection must be flushed
+ */
+bool isSchemaStatement(const char *sql);
+
+/**
+ * Whether the SQL controls a transaction (BEGIN, COMMIT, END, ROLLBACK,
+ * SAVEPOINT, RELEASE), such statements must always run on the writer
+ */
+bool isTransactionStatement(const char *sql);
+
+#endif /* StatementCache_h */
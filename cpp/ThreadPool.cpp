@@ -6,92 +6,382 @@
 //
 
 #include "ThreadPool.h"
+#include <algorithm>
 
-ThreadPool::ThreadPool() : done(false)
+// Set in a worker that destroyed its own pool, it must not touch the pool anymore
+thread_local bool isPoolDestroyed = false;
+
+PoolTask::PoolTask(std::function<void(void)> work, TaskPriority priority) : work(std::move(work)), priority(priority), state(TASK_QUEUED)
 {
-  // This returns the number of threads supported by the system. If the
-  // function can't figure out this information, it returns 0. 0 is not good,
-  // so we create at least 1
-  auto numberOfThreads = std::thread::hardware_concurrency();
-  if (numberOfThreads == 0)
+}
+
+bool PoolTask::start()
+{
+  int expected = TASK_QUEUED;
+  return state.compare_exchange_strong(expected, TASK_RUNNING);
+}
+
+bool PoolTask::cancel()
+{
+  int expected = TASK_QUEUED;
+  if (!state.compare_exchange_strong(expected, TASK_CANCELLED))
   {
-    numberOfThreads = 1;
+    return false;
   }
+  // No worker touches the function of a task that never started
+  work = nullptr;
+  return true;
+}
+
+bool PoolTask::isCancelled() const
+{
+  return state == TASK_CANCELLED;
+}
+
+bool PoolTask::isQueued() const
+{
+  return state == TASK_QUEUED;
+}
+
+TaskPriority PoolTask::getPriority() const
+{
+  return priority;
+}
 
-  for (unsigned i = 0; i < numberOfThreads; ++i)
+ThreadPool::ThreadPool(unsigned int threads) : workerCount(0), wakeSequence(0), idleWorkers(0), pendingTasks(0), runningBackgroundTasks(0), done(false)
+{
+  inboxes[PRIORITY_INTERACTIVE] = nullptr;
+  inboxes[PRIORITY_BACKGROUND] = nullptr;
+
+  if (threads == 0)
   {
-    // The threads will execute the private member `doWork`. Note that we need
-    // to pass a reference to the function (namespaced with the class name) as
-    // the first argument, and the current object as second argument
-    threads.push_back(std::thread(&ThreadPool::doWork, this));
+    // hardware_concurrency counts the efficiency cores too and returns 0 when it
+    // can't tell, it only lowers the default. Two workers keep one free for interactive tasks
+    threads = DEFAULT_POOL_WORKERS;
+    unsigned int cores = std::thread::hardware_concurrency();
+    if (cores > 0 && cores < threads)
+    {
+      threads = std::max(2u, cores);
+    }
   }
+  setWorkerCount(threads);
 }
 
 // The destructor joins all the threads so the program can exit gracefully.
-// This will be executed if there is any exception (e.g. creating the threads)
+// Tasks that did not start are dropped
 ThreadPool::~ThreadPool()
 {
   // So threads know it's time to shut down
   done = true;
 
   // Wake up all the threads, so they can finish and be joined
-  workQueueConditionVariable.notify_all();
-  for (auto &thread : threads)
+  wakeSequence++;
+  {
+    std::lock_guard<std::mutex> g(sleepMutex);
+    sleepConditionVariable.notify_all();
+  }
+  for (auto &worker : workers)
+  {
+    if (worker.thread.get_id() == std::this_thread::get_id())
+    {
+      // A thread can't join itself
+      worker.thread.detach();
+      isPoolDestroyed = true;
+    }
+    else if (worker.thread.joinable())
+    {
+      worker.thread.join();
+    }
+  }
+
+  for (auto &inbox : inboxes)
   {
-    if (thread.joinable())
+    InboxNode *node = inbox.exchange(nullptr);
+    while (node != nullptr)
     {
-      thread.join();
+      InboxNode *next = node->next;
+      delete node;
+      node = next;
     }
   }
 }
 
-// This function will be called by the server every time there is a request
-// that needs to be processed by the thread pool
-void ThreadPool::queueWork(std::function<void(void)> task)
+TaskHandle ThreadPool::queueWork(std::function<void(void)> task, TaskPriority priority)
 {
-  // Grab the mutex
-  std::lock_guard<std::mutex> g(workQueueMutex);
+  auto handle = std::make_shared<PoolTask>(std::move(task), priority);
+  pendingTasks++;
 
-  // Push the request to the queue
-  workQueue.push(task);
+  // Treiber stack push, the worker taking the inbox restores the submission order
+  InboxNode *node = new InboxNode{handle, inboxes[priority].load()};
+  while (!inboxes[priority].compare_exchange_weak(node->next, node))
+  {
+  }
 
-  // Notify one thread that there are requests to process
-  workQueueConditionVariable.notify_one();
+  wakeWorker();
+  return handle;
 }
 
-// Function used by the threads to grab work from the queue
-void ThreadPool::doWork()
+void ThreadPool::waitFinished()
 {
-  // Loop while the queue is not destructing
-  while (!done)
+  std::unique_lock<std::mutex> g(sleepMutex);
+  finishedConditionVariable.wait(g, [&]
+                                 { return pendingTasks == 0; });
+}
+
+void ThreadPool::setWorkerCount(unsigned int threads)
+{
+  threads = std::min(std::max(threads, 1u), (unsigned int)MAX_POOL_WORKERS);
+
+  std::lock_guard<std::mutex> g(resizeMutex);
+  unsigned int previousCount = workerCount;
+  workerCount = threads;
+  for (unsigned int i = 0; i < threads; i++)
+  {
+    // A worker told to retire earlier keeps going if it is still running
+    if (!workers[i].isRunning)
+    {
+      startWorker(i);
+    }
+  }
+
+  if (threads < previousCount)
+  {
+    // Idle workers above the new count retire right away
+    wakeSequence++;
+    std::lock_guard<std::mutex> sleepGuard(sleepMutex);
+    sleepConditionVariable.notify_all();
+  }
+}
+
+unsigned int ThreadPool::getWorkerCount() const
+{
+  return workerCount;
+}
+
+// MUST be called with resizeMutex held
+void ThreadPool::startWorker(unsigned int index)
+{
+  Worker &worker = workers[index];
+  // A retired thread has already handed over its tasks, it only has to return
+  if (worker.thread.joinable())
+  {
+    worker.thread.join();
+  }
+  worker.isRunning = true;
+  worker.thread = std::thread(&ThreadPool::doWork, this, index);
+}
+
+// Function used by the threads to grab work from the queues
+void ThreadPool::doWork(unsigned int index)
+{
+  TaskHandle task;
+  while (nextTask(index, &task))
   {
-    std::function<void(void)> task;
+    if (task->start())
+    {
+      try
+      {
+        task->work();
+      }
+      catch (...)
+      {
+        // Tasks report their own errors, a failing one must not take the worker down
+      }
+      if (isPoolDestroyed)
+      {
+        return;
+      }
+    }
+
+    if (task->priority == PRIORITY_BACKGROUND)
+    {
+      runningBackgroundTasks--;
+      // A background task might be waiting for the slot that was just freed
+      wakeWorker();
+    }
+    // Releasing the function can release the last reference to the pool
+    task.reset();
+    if (isPoolDestroyed)
+    {
+      return;
+    }
+    finishTask();
+  }
+}
 
-    // Create a scope, so we don't lock the queue for longer than necessary
+bool ThreadPool::nextTask(unsigned int index, TaskHandle *task)
+{
+  while (!done)
+  {
+    if (index >= workerCount)
     {
-      std::unique_lock<std::mutex> g(workQueueMutex);
-      workQueueConditionVariable.wait(g, [&]
-                                      {
-        // Only wake up if there are elements in the queue or the program is
-        // shutting down
-        return !workQueue.empty() || done; });
+      std::lock_guard<std::mutex> g(resizeMutex);
+      if (index >= workerCount)
+      {
+        // Retiring, the queued tasks go back to the inboxes for the other workers
+        Worker &worker = workers[index];
+        std::lock_guard<std::mutex> dequeGuard(worker.dequeMutex);
+        for (auto &deque : worker.deques)
+        {
+          for (auto &queued : deque)
+          {
+            TaskPriority priority = queued->priority;
+            InboxNode *node = new InboxNode{queued, inboxes[priority].load()};
+            while (!inboxes[priority].compare_exchange_weak(node->next, node))
+            {
+            }
+          }
+          deque.clear();
+        }
+        worker.isRunning = false;
+        wakeWorker();
+        return false;
+      }
+    }
 
-      // If we are shutting down exit witout trying to process more work
-      if (done)
+    // Read before looking for work, a task queued afterwards changes it and prevents sleeping
+    unsigned long long seenSequence = wakeSequence;
+
+    if (findTask(index, PRIORITY_INTERACTIVE, task))
+    {
+      return true;
+    }
+    if (reserveBackgroundWorker())
+    {
+      if (findTask(index, PRIORITY_BACKGROUND, task))
       {
-        break;
+        return true;
       }
+      runningBackgroundTasks--;
+    }
 
-      task = workQueue.front();
-      workQueue.pop();
+    std::unique_lock<std::mutex> g(sleepMutex);
+    idleWorkers++;
+    sleepConditionVariable.wait(g, [&]
+                                { return wakeSequence != seenSequence || done || index >= workerCount; });
+    idleWorkers--;
+  }
+  return false;
+}
+
+/**
+ * The worker's own tasks first, then the ones submitted since, then the oldest task of another worker
+ */
+bool ThreadPool::findTask(unsigned int index, TaskPriority priority, TaskHandle *task)
+{
+  {
+    Worker &worker = workers[index];
+    std::lock_guard<std::mutex> g(worker.dequeMutex);
+    auto &deque = worker.deques[priority];
+    if (!deque.empty())
+    {
+      *task = std::move(deque.front());
+      deque.pop_front();
+      return true;
     }
-    ++busy;
-    task();
-    --busy;
   }
+
+  return takeInbox(index, priority, task) || steal(index, priority, task);
 }
 
-void ThreadPool::waitFinished() {
-  std::unique_lock<std::mutex> g(workQueueMutex);
-  workQueueConditionVariable.wait(g, [&]{ return workQueue.empty() && (busy == 0); });
-}
\ No newline at end of file
+bool ThreadPool::takeInbox(unsigned int index, TaskPriority priority, TaskHandle *task)
+{
+  InboxNode *node = inboxes[priority].exchange(nullptr);
+  if (node == nullptr)
+  {
+    return false;
+  }
+
+  // The stack holds the newest task first
+  InboxNode *oldest = nullptr;
+  while (node != nullptr)
+  {
+    InboxNode *next = node->next;
+    node->next = oldest;
+    oldest = node;
+    node = next;
+  }
+
+  *task = std::move(oldest->task);
+  InboxNode *rest = oldest->next;
+  delete oldest;
+  if (rest == nullptr)
+  {
+    return true;
+  }
+
+  {
+    Worker &worker = workers[index];
+    std::lock_guard<std::mutex> g(worker.dequeMutex);
+    while (rest != nullptr)
+    {
+      InboxNode *next = rest->next;
+      worker.deques[priority].push_back(std::move(rest->task));
+      delete rest;
+      rest = next;
+    }
+  }
+  // Idle workers steal what this one can't run right away
+  wakeWorker();
+  return true;
+}
+
+bool ThreadPool::steal(unsigned int index, TaskPriority priority, TaskHandle *task)
+{
+  for (unsigned int offset = 1; offset < MAX_POOL_WORKERS; offset++)
+  {
+    Worker &victim = workers[(index + offset) % MAX_POOL_WORKERS];
+    std::lock_guard<std::mutex> g(victim.dequeMutex);
+    auto &deque = victim.deques[priority];
+    if (deque.empty())
+    {
+      continue;
+    }
+
+    *task = std::move(deque.front());
+    deque.pop_front();
+    if (!deque.empty())
+    {
+      wakeWorker();
+    }
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Background tasks may use every worker but one, so interactive tasks never wait for them
+ */
+bool ThreadPool::reserveBackgroundWorker()
+{
+  unsigned int limit = std::max(1u, workerCount.load() - 1);
+  unsigned int running = runningBackgroundTasks;
+  while (running < limit)
+  {
+    if (runningBackgroundTasks.compare_exchange_weak(running, running + 1))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::wakeWorker()
+{
+  wakeSequence++;
+  // Only idle workers wait on the condition variable, busy ones see the new sequence when they look for work
+  if (idleWorkers > 0)
+  {
+    std::lock_guard<std::mutex> g(sleepMutex);
+    sleepConditionVariable.notify_one();
+  }
+}
+
+void ThreadPool::finishTask()
+{
+  if (--pendingTasks == 0)
+  {
+    std::lock_guard<std::mutex> g(sleepMutex);
+    finishedConditionVariable.notify_all();
+  }
+}
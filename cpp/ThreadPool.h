@@ -8,42 +8,141 @@
 #ifndef ThreadPool_hpp
 #define ThreadPool_hpp
 
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <exception>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <stdio.h>
 #include <thread>
 #include <vector>
 
+// Workers used when none are configured, more only add contention on the efficiency cores of big.LITTLE phones
+#define DEFAULT_POOL_WORKERS 4
+#define MAX_POOL_WORKERS 16
+
+enum TaskPriority
+{
+  // Queries the user waits for, always run before the background tasks
+  PRIORITY_INTERACTIVE,
+  // Long running work like imports and backups, never takes the last free worker
+  PRIORITY_BACKGROUND,
+};
+
+class ThreadPool;
+class SerialExecutor;
+
+/**
+ * A queued function, cancelling it before a worker started it drops it without running it
+ */
+class PoolTask {
+public:
+  PoolTask(std::function<void(void)> work, TaskPriority priority);
+
+  // Returns true when the task had not started, its function is then released in the calling thread
+  bool cancel();
+  bool isCancelled() const;
+  // Neither started nor cancelled yet
+  bool isQueued() const;
+  TaskPriority getPriority() const;
+
+private:
+  friend class ThreadPool;
+  friend class SerialExecutor;
+
+  enum State
+  {
+    TASK_QUEUED,
+    TASK_RUNNING,
+    TASK_CANCELLED,
+  };
+
+  std::function<void(void)> work;
+  const TaskPriority priority;
+  std::atomic<int> state;
+
+  // Moves the task from queued to running, false when it was cancelled first
+  bool start();
+};
+
+typedef std::shared_ptr<PoolTask> TaskHandle;
+
 class ThreadPool {
 public:
-  ThreadPool();
+  // 0 workers picks DEFAULT_POOL_WORKERS, fewer when the device has less cores
+  ThreadPool(unsigned int threads = 0);
+  /**
+   * Joins the workers. When a task released the last reference to the pool its worker is detached instead,
+   * it returns as soon as the task did
+   */
   ~ThreadPool();
-  void queueWork(std::function<void(void)> task);
+
+  /**
+   * Lock-free when no worker is idle, MAY be called from any thread.
+   * The returned handle cancels the task as long as it has not started
+   */
+  TaskHandle queueWork(std::function<void(void)> task, TaskPriority priority = PRIORITY_INTERACTIVE);
   void waitFinished();
 
+  /**
+   * Starts or retires workers, the tasks of a retired worker are handed to the others.
+   * A worker running a task retires once the task returned
+   */
+  void setWorkerCount(unsigned int threads);
+  unsigned int getWorkerCount() const;
+
 private:
-  unsigned int busy;
-  // This condition variable is used for the threads to wait until there is work
-  // to do
-  std::condition_variable_any workQueueConditionVariable;
+  struct InboxNode
+  {
+    TaskHandle task;
+    InboxNode *next;
+  };
+
+  struct Worker
+  {
+    // Guards the deques, taken by the owner and by the workers stealing from it
+    std::mutex dequeMutex;
+    std::deque<TaskHandle> deques[2];
+    std::thread thread;
+    bool isRunning = false;
+  };
+
+  // Tasks submitted from outside of the workers, pushed with a CAS and taken all at once by a worker
+  std::atomic<InboxNode *> inboxes[2];
+  Worker workers[MAX_POOL_WORKERS];
+  std::atomic<unsigned int> workerCount;
+
+  // Guards starting and retiring workers
+  std::mutex resizeMutex;
 
-  // We store the threads in a vector, so we can later stop them gracefully
-  std::vector<std::thread> threads;
+  // Idle workers sleep until wakeSequence changes, submissions only take sleepMutex when one is idle
+  std::mutex sleepMutex;
+  std::condition_variable sleepConditionVariable;
+  std::atomic<unsigned long long> wakeSequence;
+  std::atomic<unsigned int> idleWorkers;
 
-  // Mutex to protect workQueue
-  std::mutex workQueueMutex;
+  // Queued and running tasks, waitFinished returns once it drops to 0
+  std::atomic<unsigned long long> pendingTasks;
+  std::condition_variable finishedConditionVariable;
 
-  // Queue of requests waiting to be processed
-  std::queue<std::function<void(void)>> workQueue;
+  std::atomic<unsigned int> runningBackgroundTasks;
 
   // This will be set to true when the thread pool is shutting down. This tells
   // the threads to stop looping and finish
-  bool done;
+  std::atomic<bool> done;
 
-  // Function used by the threads to grab work from the queue
-  void doWork();
+  void startWorker(unsigned int index);
+  void doWork(unsigned int index);
+  // Returns false when the worker has to retire
+  bool nextTask(unsigned int index, TaskHandle *task);
+  bool findTask(unsigned int index, TaskPriority priority, TaskHandle *task);
+  bool takeInbox(unsigned int index, TaskPriority priority, TaskHandle *task);
+  bool steal(unsigned int index, TaskPriority priority, TaskHandle *task);
+  bool reserveBackgroundWorker();
+  void wakeWorker();
+  void finishTask();
 };
 
 #endif /* ThreadPool_hpp */
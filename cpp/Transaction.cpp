@@ -0,0 +1,331 @@
+//
+//  Transaction.cpp
+//  react-native-quick-sqlite
+//
+
+#include "Transaction.h"
+#include <future>
+#include "macros.h"
+#include "JSThreadDispatcher.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  string jsiTransactionOptionsToBeginStatement(jsi::Runtime &rt, jsi::Value const &options)
+  {
+    if (!options.isObject())
+    {
+      return "BEGIN DEFERRED TRANSACTION";
+    }
+
+    jsi::Value mode = options.asObject(rt).getProperty(rt, "mode");
+    if (mode.isUndefined() || mode.isNull())
+    {
+      return "BEGIN DEFERRED TRANSACTION";
+    }
+
+    string modeName = mode.isString() ? mode.asString(rt).utf8(rt) : "";
+    if (modeName == "deferred")
+    {
+      return "BEGIN DEFERRED TRANSACTION";
+    }
+    if (modeName == "immediate")
+    {
+      return "BEGIN IMMEDIATE TRANSACTION";
+    }
+    if (modeName == "exclusive")
+    {
+      return "BEGIN EXCLUSIVE TRANSACTION";
+    }
+    throw jsi::JSError(rt, "[react-native-quick-sqlite][transaction] mode must be 'deferred', 'immediate' or 'exclusive'");
+  }
+
+  string quoteSavepointName(string const &name)
+  {
+    string quoted = "\"";
+    for (char c : name)
+    {
+      quoted += c;
+      if (c == '"')
+      {
+        quoted += c;
+      }
+    }
+    return quoted + "\"";
+  }
+
+  /**
+   * Runs a statement of the transaction, MUST be called from a task of the transaction executor
+   */
+  SQLiteOPResult runTransactionStatement(shared_ptr<TransactionState> state, string const &query, QuickParams *params, QuickResultSet *results, vector<QuickColumnMetadata> *metadata)
+  {
+    if (!state->queuedError.empty())
+    {
+      return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite] Transaction failed: " + state->queuedError};
+    }
+    return sqliteExecute(state->dbName, query, params, results, metadata);
+  }
+
+  /**
+   * Commits or rolls back and hands the database back to its executor,
+   * MUST be called from a task of the transaction executor
+   */
+  SQLiteOPResult finishTransaction(shared_ptr<TransactionState> state, bool isCommit)
+  {
+    QuickParams params;
+    QuickResultSet results;
+    SQLiteOPResult status = SQLiteOPResult{.type = SQLiteOk};
+
+    if (isCommit && !state->queuedError.empty())
+    {
+      status = SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite] Transaction rolled back, a queued statement failed: " + state->queuedError};
+      isCommit = false;
+    }
+
+    if (isCommit)
+    {
+      status = sqliteExecute(state->dbName, "COMMIT", &params, &results, NULL);
+    }
+
+    // A failed COMMIT leaves the transaction open
+    if (!isCommit || status.type == SQLiteError)
+    {
+      auto rollbackStatus = sqliteExecute(state->dbName, "ROLLBACK", &params, &results, NULL);
+      if (status.type == SQLiteOk)
+      {
+        status = rollbackStatus;
+      }
+    }
+
+    state->databaseExecutor->resume();
+    return status;
+  }
+
+  /**
+   * Queues the work behind the statements already queued and blocks the calling thread until it ran
+   */
+  SQLiteOPResult runAndWait(shared_ptr<TransactionState> state, function<SQLiteOPResult(void)> work)
+  {
+    auto done = make_shared<promise<SQLiteOPResult>>();
+    auto result = done->get_future();
+    state->executor->queueWork([done, work]()
+                               {
+      try
+      {
+        done->set_value(work());
+      }
+      catch (std::exception &exc)
+      {
+        done->set_value(SQLiteOPResult{.type = SQLiteError, .errorMessage = exc.what()});
+      }
+      JSThreadDispatcher::wake(); });
+    // The statement might call custom functions, they need the JS thread that is waiting here
+    JSThreadDispatcher::runPendingCallsUntil([&result]()
+                                             { return result.wait_for(chrono::seconds(0)) == future_status::ready; });
+    return result.get();
+  }
+
+  /**
+   * Queues the work behind the statements already queued, the returned Promise resolves with its results
+   */
+  jsi::Value runWithPromise(jsi::Runtime &rt, shared_ptr<TransactionState> state, shared_ptr<react::CallInvoker> invoker, QuickResultFormat format, function<SQLiteOPResult(QuickResultSet *, vector<QuickColumnMetadata> *)> work)
+  {
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    return promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task =
+      [&rt, invoker, format, work, resolve, reject]()
+      {
+        auto results = make_shared<QuickResultSet>();
+        auto metadata = make_shared<vector<QuickColumnMetadata>>();
+        auto status = work(results.get(), metadata.get());
+        invoker->invokeAsync([&rt, results, metadata, status_copy = move(status), format, resolve, reject]
+                             {
+          if(status_copy.type == SQLiteOk) {
+            auto jsiResult = createSequelQueryExecutionResult(rt, status_copy, results.get(), metadata.get(), format);
+            resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResult));
+          } else {
+            auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+            auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+            reject->asObject(rt).asFunction(rt).call(rt, error);
+          }
+        });
+      };
+
+      state->executor->queueWork(task);
+
+      return {};
+    }));
+  }
+
+  Transaction::Transaction(
+                           shared_ptr<TransactionState> state,
+                           shared_ptr<react::CallInvoker> invoker,
+                           function<void(void)> onFinalize
+                           ) :
+  state(state),
+  invoker(invoker),
+  onFinalize(onFinalize)
+  {
+  }
+
+  Transaction::~Transaction()
+  {
+    // Never committed, do not keep the database locked
+    if (!state->isFinalized.exchange(true))
+    {
+      onFinalize();
+      auto state = this->state;
+      state->executor->queueWork([state]()
+                                 { finishTransaction(state, false); });
+    }
+  }
+
+  vector<jsi::PropNameID> Transaction::getPropertyNames(jsi::Runtime &rt)
+  {
+    vector<jsi::PropNameID> names;
+    names.push_back(jsi::PropNameID::forAscii(rt, "execute"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "executeAsync"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "queue"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "savepoint"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "release"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "rollbackTo"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "commit"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "commitAsync"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "rollback"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "rollbackAsync"));
+    names.push_back(jsi::PropNameID::forAscii(rt, "finalized"));
+    return names;
+  }
+
+  jsi::Value Transaction::get(jsi::Runtime &rt, const jsi::PropNameID &propNameId)
+  {
+    auto name = propNameId.utf8(rt);
+    // The returned functions can outlive this object, they only hold on to the shared state
+    auto state = this->state;
+    auto invoker = this->invoker;
+    auto onFinalize = this->onFinalize;
+
+    if (name == "finalized")
+    {
+      return jsi::Value(state->isFinalized.load());
+    }
+
+    if (name == "execute" || name == "executeAsync" || name == "queue")
+    {
+      const bool isAsync = name == "executeAsync";
+      const bool isQueued = name == "queue";
+      return HOSTFN(name.c_str(), 3) {
+        if (count == 0 || !args[0].isString())
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][" + name + "] query must be a string");
+        }
+        if (state->isFinalized)
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][" + name + "] Cannot execute query on finalized transaction");
+        }
+
+        const string query = args[0].asString(rt).utf8(rt);
+        auto params = make_shared<QuickParams>();
+        if (count > 1)
+        {
+          jsiQueryArgumentsToSequelParam(rt, args[1], params.get());
+        }
+        const QuickResultFormat format = count > 2 ? jsiQueryOptionsToResultFormat(rt, args[2]) : RESULT_OBJECTS;
+
+        if (isQueued)
+        {
+          // Nothing is sent back to JS, a failure is reported by the commit
+          state->executor->queueWork([state, query, params]()
+                                     {
+            QuickResultSet results;
+            auto status = runTransactionStatement(state, query, params.get(), &results, NULL);
+            if (status.type == SQLiteError && state->queuedError.empty())
+            {
+              state->queuedError = status.errorMessage;
+            } });
+          return {};
+        }
+
+        if (isAsync)
+        {
+          return runWithPromise(rt, state, invoker, format, [state, query, params](QuickResultSet *results, vector<QuickColumnMetadata> *metadata)
+                                { return runTransactionStatement(state, query, params.get(), results, metadata); });
+        }
+
+        QuickResultSet results;
+        vector<QuickColumnMetadata> metadata;
+        auto status = runAndWait(state, [state, query, params, &results, &metadata]()
+                                 { return runTransactionStatement(state, query, params.get(), &results, &metadata); });
+        if (status.type == SQLiteError)
+        {
+          throw jsi::JSError(rt, status.errorMessage);
+        }
+        return createSequelQueryExecutionResult(rt, status, &results, &metadata, format);
+      });
+    }
+
+    if (name == "savepoint" || name == "release" || name == "rollbackTo")
+    {
+      const string statement = name == "savepoint" ? "SAVEPOINT " : name == "release" ? "RELEASE SAVEPOINT " : "ROLLBACK TO SAVEPOINT ";
+      return HOSTFN(name.c_str(), 1) {
+        if (count == 0 || !args[0].isString())
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][" + name + "] savepoint name must be a string");
+        }
+        if (state->isFinalized)
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][" + name + "] Cannot execute query on finalized transaction");
+        }
+
+        const string query = statement + quoteSavepointName(args[0].asString(rt).utf8(rt));
+        QuickResultSet results;
+        QuickParams params;
+        auto status = runAndWait(state, [state, query, &params, &results]()
+                                 { return runTransactionStatement(state, query, &params, &results, NULL); });
+        if (status.type == SQLiteError)
+        {
+          throw jsi::JSError(rt, status.errorMessage);
+        }
+        return {};
+      });
+    }
+
+    if (name == "commit" || name == "rollback" || name == "commitAsync" || name == "rollbackAsync")
+    {
+      const bool isCommit = name == "commit" || name == "commitAsync";
+      const bool isAsync = name == "commitAsync" || name == "rollbackAsync";
+      return HOSTFN(name.c_str(), 0) {
+        if (state->isFinalized.exchange(true))
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][" + name + "] Transaction is already finalized");
+        }
+        onFinalize();
+
+        if (isAsync)
+        {
+          return runWithPromise(rt, state, invoker, RESULT_OBJECTS, [state, isCommit](QuickResultSet *results, vector<QuickColumnMetadata> *metadata)
+                                { return finishTransaction(state, isCommit); });
+        }
+
+        auto status = runAndWait(state, [state, isCommit]()
+                                 { return finishTransaction(state, isCommit); });
+        if (status.type == SQLiteError)
+        {
+          throw jsi::JSError(rt, status.errorMessage);
+        }
+        QuickResultSet results;
+        return createSequelQueryExecutionResult(rt, status, &results, NULL);
+      });
+    }
+
+    return jsi::Value::undefined();
+  }
+}
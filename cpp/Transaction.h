@@ -0,0 +1,63 @@
+//
+//  Transaction.h
+//  react-native-quick-sqlite
+//
+//  JSI HostObject owning a database from BEGIN until COMMIT or ROLLBACK
+//
+
+#ifndef Transaction_h
+#define Transaction_h
+
+#include <atomic>
+#include <functional>
+#include <jsi/jsi.h>
+#include <ReactCommon/CallInvoker.h>
+#include "sqliteBridge.h"
+#include "SerialExecutor.h"
+
+using namespace std;
+using namespace facebook;
+
+namespace osp {
+  /**
+   * State shared between the transaction and the tasks running its statements
+   */
+  struct TransactionState
+  {
+    string dbName;
+    // Paused by the BEGIN task, nothing else runs on the database until the transaction is finished
+    shared_ptr<SerialExecutor> databaseExecutor;
+    // Runs the statements of the transaction in the order they were queued
+    shared_ptr<SerialExecutor> executor;
+    atomic<bool> isFinalized;
+    // First failure of a statement nobody awaits, it turns the commit into a rollback.
+    // Only touched by the tasks of the executor
+    string queuedError;
+  };
+
+  class Transaction : public jsi::HostObject {
+  public:
+    Transaction(
+                shared_ptr<TransactionState> state,
+                shared_ptr<react::CallInvoker> invoker,
+                function<void(void)> onFinalize
+                );
+    ~Transaction();
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &propNameId) override;
+    vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override;
+
+  private:
+    shared_ptr<TransactionState> state;
+    shared_ptr<react::CallInvoker> invoker;
+    // Called on the JS thread once commit or rollback has been requested
+    function<void(void)> onFinalize;
+  };
+
+  /**
+   * BEGIN statement for the mode passed in the transaction options: deferred (default), immediate or exclusive
+   */
+  string jsiTransactionOptionsToBeginStatement(jsi::Runtime &rt, jsi::Value const &options);
+}
+
+#endif /* Transaction_h */
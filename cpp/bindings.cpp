@@ -3,8 +3,20 @@
 #include "logs.h"
 #include "JSIHelper.h"
 #include "ThreadPool.h"
+#include "SerialExecutor.h"
 #include "sqlfileloader.h"
 #include "sqlbatchexecutor.h"
+#include "PreparedStatement.h"
+#include "Cursor.h"
+#include "Transaction.h"
+#include "JSThreadDispatcher.h"
+#include "QuerySubscription.h"
+#include "CancelToken.h"
+#include "QueryInterrupt.h"
+#include "IncrementalBlob.h"
+#include "ChangesetSession.h"
+#include <atomic>
+#include <cmath>
 #include <vector>
 #include <string>
 #include "macros.h"
@@ -13,17 +25,319 @@
 using namespace std;
 using namespace facebook;
 
+// Pages copied per step of a backup when no pagesPerStep is given
+#define DEFAULT_BACKUP_PAGES_PER_STEP 64
+
 namespace osp {
 string docPathStr;
 std::shared_ptr<react::CallInvoker> invoker;
+map<string, shared_ptr<SerialExecutor>> executorMap;
+// Executors of the open transactions, the database executor is paused until they finish
+map<string, shared_ptr<SerialExecutor>> transactionExecutorMap;
+// Subscriptions of every database, created with the first one
+map<string, shared_ptr<QuerySubscriptions>> subscriptionMap;
+// Runs the work queued from outside of JS, like memory pressure
+shared_ptr<ThreadPool> workerPool;
+// Soft heap limit applied on critical memory pressure, 0 leaves the limit alone
+atomic<long long> criticalHeapLimit(0);
+
+/**
+ * A query of executeManyAsync, the worker thread running it stores its results until all of them are converted
+ */
+struct FanOutQuery
+{
+  string query;
+  QuickParams params;
+  QuickResultFormat format = RESULT_OBJECTS;
+  TaskPriority priority = PRIORITY_INTERACTIVE;
+  QueryInterruptOptions interruptOptions;
+  bool isRead = false;
+  SQLiteOPResult status;
+  QuickResultSet results;
+  vector<QuickColumnMetadata> metadata;
+};
+
+/**
+ * Async tasks of a database run one at a time in the order they were queued,
+ * different databases share the threads of the pool
+ * MUST be called in the JavaScript Thread
+ */
+shared_ptr<SerialExecutor> getDatabaseExecutor(shared_ptr<ThreadPool> pool, string const &dbName)
+{
+  auto executor = executorMap.find(dbName);
+  if (executor != executorMap.end())
+  {
+    return executor->second;
+  }
+
+  auto newExecutor = make_shared<SerialExecutor>(pool);
+  executorMap[dbName] = newExecutor;
+  return newExecutor;
+}
+
+/**
+ * Same as getDatabaseExecutor, but while a transaction is open its tasks run inside of it
+ * MUST be called in the JavaScript Thread
+ */
+shared_ptr<SerialExecutor> getExecutor(shared_ptr<ThreadPool> pool, string const &dbName)
+{
+  auto transactionExecutor = transactionExecutorMap.find(dbName);
+  if (transactionExecutor != transactionExecutorMap.end())
+  {
+    return transactionExecutor->second;
+  }
+  return getDatabaseExecutor(pool, dbName);
+}
+
+/**
+ * Looks the executor up again for every task, for the objects outliving the call that created them
+ */
+ExecutorProvider getExecutorProvider(shared_ptr<ThreadPool> pool, string const &dbName)
+{
+  weak_ptr<ThreadPool> weakPool = pool;
+  return [weakPool, dbName]()
+  { return getExecutor(weakPool.lock(), dbName); };
+}
+
+/**
+ * A read can skip the queue of the database and run on a reader connection only outside of a transaction
+ * and when nothing is queued before it, otherwise it would miss the writes it has to see
+ * MUST be called in the JavaScript Thread
+ */
+bool canReadInParallel(string const &dbName)
+{
+  if (transactionExecutorMap.count(dbName) > 0)
+  {
+    return false;
+  }
+  auto executor = executorMap.find(dbName);
+  return executor == executorMap.end() || executor->second->isIdle();
+}
+
+/**
+ * Subscriptions of a closed database must not run anymore
+ * MUST be called in the JavaScript Thread
+ */
+void cancelSubscriptions(string const &dbName)
+{
+  auto subscriptions = subscriptionMap.find(dbName);
+  if (subscriptions != subscriptionMap.end())
+  {
+    subscriptions->second->cancelAll();
+    subscriptionMap.erase(subscriptions);
+  }
+}
+
+void handleMemoryPressure(bool isCritical)
+{
+  if (invoker == nullptr)
+  {
+    return;
+  }
+
+  // The databases are only known on the JS thread, the connections are then waited for on a worker
+  invoker->invokeAsync([isCritical]()
+                       {
+    long long limit = criticalHeapLimit;
+    if (isCritical && limit > 0)
+    {
+      sqliteSetSoftHeapLimit(limit);
+    }
+    for (auto &dbName : sqliteOpenDatabases())
+    {
+      workerPool->queueWork([dbName]()
+                            { sqliteReleaseMemory(dbName); }, PRIORITY_BACKGROUND);
+    } });
+}
+
+jsi::Object createDbStatusObject(jsi::Runtime &rt, SQLiteDbStatus const &status)
+{
+  jsi::Object object = jsi::Object(rt);
+  object.setProperty(rt, "cacheUsed", jsi::Value((double)status.cacheUsed));
+  object.setProperty(rt, "cacheHit", jsi::Value((double)status.cacheHit));
+  object.setProperty(rt, "cacheMiss", jsi::Value((double)status.cacheMiss));
+  object.setProperty(rt, "cacheWrite", jsi::Value((double)status.cacheWrite));
+  object.setProperty(rt, "cacheSpill", jsi::Value((double)status.cacheSpill));
+  object.setProperty(rt, "schemaUsed", jsi::Value((double)status.schemaUsed));
+  object.setProperty(rt, "statementUsed", jsi::Value((double)status.statementUsed));
+  object.setProperty(rt, "lookasideUsed", jsi::Value((double)status.lookasideUsed));
+  return object;
+}
+
+/**
+ * Reads a boolean property of an optional options object
+ */
+bool getBoolOption(jsi::Runtime &rt, const jsi::Value *args, size_t count, size_t index, const char *name)
+{
+  if (count <= index || !args[index].isObject())
+  {
+    return false;
+  }
+  auto value = args[index].asObject(rt).getProperty(rt, name);
+  return value.isBool() && value.getBool();
+}
+
+/**
+ * Reads the priority of an optional options object, interactive unless 'background' is given
+ */
+TaskPriority getPriorityOption(jsi::Runtime &rt, jsi::Value const &options)
+{
+  if (!options.isObject())
+  {
+    return PRIORITY_INTERACTIVE;
+  }
+  auto value = options.asObject(rt).getProperty(rt, "priority");
+  if (value.isUndefined())
+  {
+    return PRIORITY_INTERACTIVE;
+  }
+
+  const string priority = value.isString() ? value.asString(rt).utf8(rt) : "";
+  if (priority == "interactive")
+  {
+    return PRIORITY_INTERACTIVE;
+  }
+  if (priority == "background")
+  {
+    return PRIORITY_BACKGROUND;
+  }
+  throw jsi::JSError(rt, "[react-native-quick-sqlite] priority must be 'interactive' or 'background'");
+}
+
+/**
+ * Reads the timeout and cancelToken of an optional options object
+ * MUST be called in the JavaScript Thread, the timeout starts with the call
+ */
+QueryInterruptOptions getInterruptOptions(jsi::Runtime &rt, jsi::Value const &options)
+{
+  QueryInterruptOptions interruptOptions;
+  if (!options.isObject())
+  {
+    return interruptOptions;
+  }
+  jsi::Object object = options.asObject(rt);
+
+  auto timeout = object.getProperty(rt, "timeout");
+  if (!timeout.isUndefined())
+  {
+    if (!timeout.isNumber() || !(timeout.getNumber() > 0))
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite] timeout must be a number of milliseconds greater than 0");
+    }
+    auto now = chrono::steady_clock::now();
+    chrono::duration<double, milli> timeoutMs(timeout.getNumber());
+    // Infinity, or any timeout past the end of the clock, never expires
+    if (isfinite(timeoutMs.count()) && timeoutMs < chrono::duration<double, milli>(QueryDeadline::max() - now))
+    {
+      interruptOptions.deadline = now + chrono::duration_cast<chrono::steady_clock::duration>(timeoutMs);
+    }
+  }
+
+  auto cancelToken = object.getProperty(rt, "cancelToken");
+  if (!cancelToken.isUndefined() && !cancelToken.isNull())
+  {
+    if (!cancelToken.isObject() || !cancelToken.asObject(rt).isHostObject<CancelToken>(rt))
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite] cancelToken must be created with createCancelToken");
+    }
+    interruptOptions.cancellation = cancelToken.asObject(rt).getHostObject<CancelToken>(rt)->getCancellation();
+  }
+  return interruptOptions;
+}
+
+/**
+ * One object per profiled query, slowest first
+ */
+jsi::Array createQueryStatsArray(jsi::Runtime &rt, vector<pair<string, QueryStats>> const &stats)
+{
+  jsi::Array array = jsi::Array(rt, stats.size());
+  for (size_t i = 0; i < stats.size(); i++)
+  {
+    QueryStats const &s = stats[i].second;
+    jsi::Object entry = jsi::Object(rt);
+    entry.setProperty(rt, "sql", jsi::String::createFromUtf8(rt, stats[i].first));
+    entry.setProperty(rt, "calls", jsi::Value((double)s.calls));
+    entry.setProperty(rt, "errors", jsi::Value((double)s.errors));
+    entry.setProperty(rt, "prepareMs", jsi::Value(s.prepareMs));
+    entry.setProperty(rt, "stepMs", jsi::Value(s.stepMs));
+    entry.setProperty(rt, "marshalMs", jsi::Value(s.marshalMs));
+    entry.setProperty(rt, "queueWaitMs", jsi::Value(s.queueWaitMs));
+    entry.setProperty(rt, "maxMs", jsi::Value(s.maxMs));
+    entry.setProperty(rt, "rows", jsi::Value((double)s.rows));
+    entry.setProperty(rt, "bytes", jsi::Value((double)s.bytes));
+    entry.setProperty(rt, "fullscanSteps", jsi::Value((double)s.fullscanSteps));
+    entry.setProperty(rt, "sorts", jsi::Value((double)s.sorts));
+    entry.setProperty(rt, "autoindexes", jsi::Value((double)s.autoindexes));
+    array.setValueAtIndex(rt, i, move(entry));
+  }
+  return array;
+}
+
+/**
+ * Copies the next pages of a backup and queues itself again behind whatever was queued meanwhile,
+ * so the backup never holds the connection for more than a step
+ */
+void queueBackupStep(
+                     jsi::Runtime *rt,
+                     shared_ptr<SerialExecutor> executor,
+                     shared_ptr<BackupHandle> handle,
+                     int pagesPerStep,
+                     shared_ptr<jsi::Value> progressCallback,
+                     shared_ptr<jsi::Value> resolve,
+                     shared_ptr<jsi::Value> reject)
+{
+  executor->queueWork([rt, executor, handle, pagesPerStep, progressCallback, resolve, reject]()
+                      {
+    bool isDone = false;
+    auto status = sqliteBackupStep(handle, pagesPerStep, &isDone);
+    if (status.type == SQLiteOk && !isDone)
+    {
+      if (progressCallback != nullptr)
+      {
+        int remainingPages = handle->remainingPages;
+        int totalPages = handle->totalPages;
+        invoker->invokeAsync([rt, progressCallback, remainingPages, totalPages]
+                             {
+          auto res = jsi::Object(*rt);
+          res.setProperty(*rt, "remainingPages", jsi::Value(remainingPages));
+          res.setProperty(*rt, "totalPages", jsi::Value(totalPages));
+          progressCallback->asObject(*rt).asFunction(*rt).call(*rt, move(res)); });
+      }
+      queueBackupStep(rt, executor, handle, pagesPerStep, progressCallback, resolve, reject);
+      return;
+    }
+
+    auto finishStatus = sqliteBackupFinish(handle);
+    if (status.type == SQLiteOk)
+    {
+      status = finishStatus;
+    }
+    int totalPages = handle->totalPages;
+    invoker->invokeAsync([rt, status_copy = move(status), totalPages, resolve, reject]
+                         {
+      if (status_copy.type == SQLiteOk)
+      {
+        auto res = jsi::Object(*rt);
+        res.setProperty(*rt, "totalPages", jsi::Value(totalPages));
+        resolve->asObject(*rt).asFunction(*rt).call(*rt, move(res));
+      } else {
+        auto errorCtr = rt->global().getPropertyAsFunction(*rt, "Error");
+        auto error = errorCtr.callAsConstructor(*rt, jsi::String::createFromUtf8(*rt, status_copy.errorMessage));
+        reject->asObject(*rt).asFunction(*rt).call(*rt, error);
+      } }); }, PRIORITY_BACKGROUND);
+}
 
 void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker, const char *docPath)
 {
   docPathStr = std::string(docPath);
   auto pool = std::make_shared<ThreadPool>();
+  workerPool = pool;
   invoker = jsCallInvoker;
+  JSThreadDispatcher::install(jsCallInvoker);
+  executorMap.clear();
+  transactionExecutorMap.clear();
 
-  auto open = HOSTFN("open", 2) {
+  auto open = HOSTFN("open", 3) {
     if (count == 0)
     {
       throw jsi::JSError(rt, "[react-native-quick-sqlite][open] database name is required");
@@ -46,7 +360,18 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
       tempDocPath = tempDocPath + "/" + args[1].asString(rt).utf8(rt);
     }
 
-    SQLiteOPResult result = sqliteOpenDb(dbName, tempDocPath);
+    SQLiteOpenOptions options;
+    if (count > 2 && !args[2].isUndefined() && !args[2].isNull())
+    {
+      if (!args[2].isObject())
+      {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite][open] options must be an object");
+      }
+
+      jsiOpenOptionsToSQLiteOpenOptions(rt, args[2], &options);
+    }
+
+    SQLiteOPResult result = sqliteOpenDb(dbName, tempDocPath, options);
 
     if (result.type == SQLiteError)
     {
@@ -112,6 +437,18 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
     return {};
   });
 
+  // Compile-time options of the SQLite build, to check which SQLITE_FLAGS are active
+  auto getCompileOptions = HOSTFN("getCompileOptions", 0)
+  {
+    auto compileOptions = sqliteCompileOptions();
+    auto res = jsi::Array(rt, compileOptions.size());
+    for (size_t i = 0; i < compileOptions.size(); i++)
+    {
+      res.setValueAtIndex(rt, i, jsi::String::createFromUtf8(rt, compileOptions[i]));
+    }
+    return move(res);
+  });
+
   auto close = HOSTFN("close", 1)
   {
     if (count == 0)
@@ -126,7 +463,10 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
 
     string dbName = args[0].asString(rt).utf8(rt);
 
+    cancelSubscriptions(dbName);
     SQLiteOPResult result = sqliteCloseDb(dbName);
+    executorMap.erase(dbName);
+    transactionExecutorMap.erase(dbName);
 
     if (result.type == SQLiteError)
     {
@@ -162,7 +502,10 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
     }
 
 
+    cancelSubscriptions(dbName);
     SQLiteOPResult result = sqliteRemoveDb(dbName, tempDocPath);
+    executorMap.erase(dbName);
+    transactionExecutorMap.erase(dbName);
 
     if (result.type == SQLiteError)
     {
@@ -172,22 +515,26 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
     return {};
   });
 
-  auto execute = HOSTFN("execute", 3)
+  auto execute = HOSTFN("execute", 4)
   {
     const string dbName = args[0].asString(rt).utf8(rt);
     const string query = args[1].asString(rt).utf8(rt);
-    vector<QuickValue> params;
-    if(count == 3) {
+    QuickParams params;
+    if(count >= 3) {
       const jsi::Value &originalParams = args[2];
-      jsiQueryArgumentsToSequelParam(rt, originalParams, &params);
+      // Runs before returning to JS, blobs can be bound straight from the ArrayBuffers
+      jsiQueryArgumentsToSequelParam(rt, originalParams, &params, true);
     }
+    const QuickResultFormat format = count > 3 ? jsiQueryOptionsToResultFormat(rt, args[3]) : RESULT_OBJECTS;
+    const QueryInterruptOptions interruptOptions = count > 3 ? getInterruptOptions(rt, args[3]) : QueryInterruptOptions();
 
-    vector<map<string, QuickValue>> results;
+    QuickResultSet results;
     vector<QuickColumnMetadata> metadata;
 
     // Converting results into a JSI Response
     try {
-      auto status = sqliteExecute(dbName, query, &params, &results, &metadata);
+      auto status = runInterruptible(interruptOptions, [&]()
+                                     { return sqliteExecute(dbName, query, &params, &results, &metadata); });
 
       if(status.type == SQLiteError) {
 //        throw std::runtime_error(status.errorMessage);
@@ -195,14 +542,20 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
 //        return {};
       }
 
-      auto jsiResult = createSequelQueryExecutionResult(rt, status, &results, &metadata);
+      auto profiler = sqliteGetProfiler(dbName);
+      ProfilerTime marshalStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+      auto jsiResult = createSequelQueryExecutionResult(rt, status, &results, &metadata, format);
+      if (profiler != nullptr)
+      {
+        profiler->recordMarshal(query, elapsedMs(marshalStart, profilerNow()));
+      }
       return jsiResult;
     } catch(std::exception &e) {
       throw jsi::JSError(rt, e.what());
     }
   });
 
-  auto executeAsync = HOSTFN("executeAsync", 3)
+  auto executeAsync = HOSTFN("executeAsync", 4)
   {
     if (count < 3)
     {
@@ -212,28 +565,48 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
     const string dbName = args[0].asString(rt).utf8(rt);
     const string query = args[1].asString(rt).utf8(rt);
     const jsi::Value &originalParams = args[2];
+    const QuickResultFormat format = count > 3 ? jsiQueryOptionsToResultFormat(rt, args[3]) : RESULT_OBJECTS;
+    const TaskPriority priority = count > 3 ? getPriorityOption(rt, args[3]) : PRIORITY_INTERACTIVE;
+    const QueryInterruptOptions interruptOptions = count > 3 ? getInterruptOptions(rt, args[3]) : QueryInterruptOptions();
 
     // Converting query parameters inside the javascript caller thread
-    vector<QuickValue> params;
+    QuickParams params;
     jsiQueryArgumentsToSequelParam(rt, originalParams, &params);
 
+    // Reads already seen on the writer can skip its queue and run in parallel on a reader connection
+    const bool isRead = sqliteIsReadQuery(dbName, query) && canReadInParallel(dbName);
+    auto profiler = sqliteGetProfiler(dbName);
+
     auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
     auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
       auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
       auto reject = std::make_shared<jsi::Value>(rt, args[1]);
 
+      ProfilerTime queuedAt = profiler != nullptr ? profilerNow() : ProfilerTime();
       auto task =
-      [&rt, dbName, query, params = make_shared<vector<QuickValue>>(params), resolve, reject]()
+      [&rt, dbName, query, params = make_shared<QuickParams>(params), format, isRead, interruptOptions, profiler, queuedAt, resolve, reject]()
       {
         try
         {
-          vector<map<string, QuickValue>> results;
+          if (profiler != nullptr)
+          {
+            profiler->recordQueueWait(query, elapsedMs(queuedAt, profilerNow()));
+          }
+          QuickResultSet results;
           vector<QuickColumnMetadata> metadata;
-          auto status = sqliteExecute(dbName, query, params.get(), &results, &metadata);
-          invoker->invokeAsync([&rt, results = make_shared<vector<map<string, QuickValue>>>(results), metadata = make_shared<vector<QuickColumnMetadata>>(metadata), status_copy = move(status), resolve, reject]
+          auto status = runInterruptible(interruptOptions, [&]()
+                                         { return isRead
+                                             ? sqliteExecuteRead(dbName, query, params.get(), &results, &metadata)
+                                             : sqliteExecute(dbName, query, params.get(), &results, &metadata); });
+          invoker->invokeAsync([&rt, query, results = make_shared<QuickResultSet>(move(results)), metadata = make_shared<vector<QuickColumnMetadata>>(move(metadata)), status_copy = move(status), format, profiler, resolve, reject]
                                {
             if(status_copy.type == SQLiteOk) {
-              auto jsiResult = createSequelQueryExecutionResult(rt, status_copy, results.get(), metadata.get());
+              ProfilerTime marshalStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+              auto jsiResult = createSequelQueryExecutionResult(rt, status_copy, results.get(), metadata.get(), format);
+              if (profiler != nullptr)
+              {
+                profiler->recordMarshal(query, elapsedMs(marshalStart, profilerNow()));
+              }
               resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResult));
             } else {
               auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
@@ -251,7 +624,381 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
         }
       };
 
-      pool->queueWork(task);
+      TaskHandle handle = isRead
+        ? pool->queueWork(task, priority)
+        : getExecutor(pool, dbName)->queueWork(task, priority);
+
+      if (interruptOptions.cancellation != nullptr)
+      {
+        // Runs in the JS thread, tokens are only cancelled from JS
+        interruptOptions.cancellation->addTask(handle, [&rt, reject]()
+                                               {
+          auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+          auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, QUERY_CANCELLED_MESSAGE));
+          reject->asObject(rt).asFunction(rt).call(rt, error); });
+      }
+
+      return {};
+    }));
+
+    return promise;
+  });
+
+  // Runs independent queries at once, reads in parallel on the reader connections, and resolves with every result together
+  auto executeManyAsync = HOSTFN("executeManyAsync", 2)
+  {
+    if (count < 2 || !args[0].isString() || !args[1].isObject() || !args[1].asObject(rt).isArray(rt))
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][executeManyAsync] dbName and an array of queries are required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const jsi::Array commands = args[1].asObject(rt).asArray(rt);
+    const size_t commandCount = commands.length(rt);
+
+    // Converting queries and parameters inside the javascript caller thread
+    auto queries = make_shared<vector<FanOutQuery>>(commandCount);
+    for (size_t i = 0; i < commandCount; i++)
+    {
+      jsi::Value command = commands.getValueAtIndex(rt, i);
+      if (!command.isObject() || !command.asObject(rt).isArray(rt))
+      {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite][executeManyAsync] Every query must be an array of [query, params?, options?]");
+      }
+      jsi::Array queryArgs = command.asObject(rt).asArray(rt);
+      const size_t argCount = queryArgs.length(rt);
+      jsi::Value query = argCount > 0 ? queryArgs.getValueAtIndex(rt, 0) : jsi::Value::undefined();
+      if (!query.isString())
+      {
+        throw jsi::JSError(rt, "[react-native-quick-sqlite][executeManyAsync] The query must be a string");
+      }
+
+      FanOutQuery &fanOutQuery = (*queries)[i];
+      fanOutQuery.query = query.asString(rt).utf8(rt);
+      if (argCount > 1)
+      {
+        jsiQueryArgumentsToSequelParam(rt, queryArgs.getValueAtIndex(rt, 1), &fanOutQuery.params);
+      }
+      if (argCount > 2)
+      {
+        jsi::Value options = queryArgs.getValueAtIndex(rt, 2);
+        fanOutQuery.format = jsiQueryOptionsToResultFormat(rt, options);
+        fanOutQuery.priority = getPriorityOption(rt, options);
+        fanOutQuery.interruptOptions = getInterruptOptions(rt, options);
+      }
+      fanOutQuery.isRead = sqliteIsReadQuery(dbName, fanOutQuery.query);
+    }
+    auto profiler = sqliteGetProfiler(dbName);
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      // Every result is converted in a single turn of the JS thread, once the last query finished
+      auto settle = [&rt, queries, profiler, resolve, reject]()
+      {
+        for (auto &query : *queries)
+        {
+          if (query.status.type == SQLiteError)
+          {
+            auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+            auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, query.status.errorMessage));
+            reject->asObject(rt).asFunction(rt).call(rt, error);
+            return;
+          }
+        }
+
+        jsi::Array jsiResults = jsi::Array(rt, queries->size());
+        for (size_t i = 0; i < queries->size(); i++)
+        {
+          FanOutQuery &query = (*queries)[i];
+          ProfilerTime marshalStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+          jsiResults.setValueAtIndex(rt, i, createSequelQueryExecutionResult(rt, query.status, &query.results, &query.metadata, query.format));
+          if (profiler != nullptr)
+          {
+            profiler->recordMarshal(query.query, elapsedMs(marshalStart, profilerNow()));
+          }
+        }
+        resolve->asObject(rt).asFunction(rt).call(rt, move(jsiResults));
+      };
+
+      if (queries->empty())
+      {
+        settle();
+        return {};
+      }
+
+      auto remaining = make_shared<atomic<size_t>>(queries->size());
+      ProfilerTime queuedAt = profiler != nullptr ? profilerNow() : ProfilerTime();
+      for (size_t i = 0; i < queries->size(); i++)
+      {
+        auto task = [dbName, queries, i, remaining, profiler, queuedAt, settle]()
+        {
+          FanOutQuery &query = (*queries)[i];
+          if (profiler != nullptr)
+          {
+            profiler->recordQueueWait(query.query, elapsedMs(queuedAt, profilerNow()));
+          }
+          query.status = runInterruptible(query.interruptOptions, [&]()
+                                          { return query.isRead
+                                              ? sqliteExecuteRead(dbName, query.query, &query.params, &query.results, &query.metadata)
+                                              : sqliteExecute(dbName, query.query, &query.params, &query.results, &query.metadata); });
+          if (--*remaining == 0)
+          {
+            invoker->invokeAsync(settle);
+          }
+        };
+
+        // Writes keep their order behind the other writes of the database, and so do the reads queued after them
+        FanOutQuery &query = (*queries)[i];
+        query.isRead = query.isRead && canReadInParallel(dbName);
+        TaskHandle handle = query.isRead
+          ? pool->queueWork(task, query.priority)
+          : getExecutor(pool, dbName)->queueWork(task, query.priority);
+
+        if (query.interruptOptions.cancellation != nullptr)
+        {
+          // A query that never ran counts as failed, the promise settles once the others finished
+          query.interruptOptions.cancellation->addTask(handle, [queries, i, remaining, settle]()
+                                                       {
+            (*queries)[i].status = SQLiteOPResult{
+              .type = SQLiteError,
+              .errorMessage = QUERY_CANCELLED_MESSAGE,
+            };
+            if (--*remaining == 0)
+            {
+              invoker->invokeAsync(settle);
+            }
+          });
+        }
+      }
+
+      return {};
+    }));
+
+    return promise;
+  });
+
+  // Prepare a statement once, the returned object can bind and execute it many times
+  auto prepare = HOSTFN("prepare", 2)
+  {
+    if (count < 2)
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][prepare] Incorrect number of arguments");
+    }
+
+    if (!args[0].isString() || !args[1].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][prepare] dbName and query must be strings");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string query = args[1].asString(rt).utf8(rt);
+
+    shared_ptr<PreparedStatementHandle> handle;
+    auto status = sqlitePrepareStatement(dbName, query, &handle);
+    if (status.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, status.errorMessage);
+    }
+
+    auto preparedStatement = make_shared<PreparedStatement>(handle, getExecutorProvider(pool, dbName), invoker);
+    return jsi::Object::createFromHostObject(rt, preparedStatement);
+  });
+
+  // Open a cursor over a query, rows are read in batches by calling next on the returned object
+  auto openCursor = HOSTFN("openCursor", 4)
+  {
+    if (count < 2)
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][openCursor] Incorrect number of arguments");
+    }
+
+    if (!args[0].isString() || !args[1].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][openCursor] dbName and query must be strings");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string query = args[1].asString(rt).utf8(rt);
+    QuickParams params;
+    if (count > 2)
+    {
+      jsiQueryArgumentsToSequelParam(rt, args[2], &params);
+    }
+    const QuickResultFormat format = count > 3 ? jsiQueryOptionsToResultFormat(rt, args[3]) : RESULT_OBJECTS;
+
+    shared_ptr<PreparedStatementHandle> handle;
+    auto status = sqlitePrepareStatement(dbName, query, &handle);
+    if (status.type == SQLiteOk)
+    {
+      status = sqliteBindPreparedStatement(handle, &params);
+    }
+    if (status.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, status.errorMessage);
+    }
+
+    auto cursor = make_shared<Cursor>(handle, format, getExecutorProvider(pool, dbName), invoker);
+    return jsi::Object::createFromHostObject(rt, cursor);
+  });
+
+  // Open a blob of one row for reading and writing in ranges, without loading all of it
+  auto openBlob = HOSTFN("openBlob", 5)
+  {
+    if (count < 4)
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][openBlob] Incorrect number of arguments");
+    }
+
+    if (!args[0].isString() || !args[1].isString() || !args[2].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][openBlob] dbName, table and column must be strings");
+    }
+
+    if (!args[3].isNumber())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][openBlob] rowId must be a number");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string table = args[1].asString(rt).utf8(rt);
+    const string column = args[2].asString(rt).utf8(rt);
+    const long long rowId = (long long)args[3].getNumber();
+    const bool readOnly = getBoolOption(rt, args, count, 4, "readOnly");
+    string database = "main";
+    if (count > 4 && args[4].isObject())
+    {
+      auto value = args[4].asObject(rt).getProperty(rt, "database");
+      if (value.isString())
+      {
+        database = value.asString(rt).utf8(rt);
+      }
+    }
+
+    shared_ptr<BlobHandle> handle;
+    auto status = sqliteBlobOpen(dbName, database, table, column, rowId, readOnly, &handle);
+    if (status.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, status.errorMessage);
+    }
+
+    auto blob = make_shared<IncrementalBlob>(handle, getExecutorProvider(pool, dbName), invoker);
+    return jsi::Object::createFromHostObject(rt, blob);
+  });
+
+  // Start recording the changes of the database, read back as a changeset from the returned object
+  auto createSession = HOSTFN("createSession", 2)
+  {
+    if (count == 0 || !args[0].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][createSession] dbName must be a string");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    string database = "main";
+    vector<string> tables;
+    if (count > 1 && args[1].isObject())
+    {
+      auto options = args[1].asObject(rt);
+      auto databaseValue = options.getProperty(rt, "database");
+      if (databaseValue.isString())
+      {
+        database = databaseValue.asString(rt).utf8(rt);
+      }
+      auto tablesValue = options.getProperty(rt, "tables");
+      if (!tablesValue.isUndefined())
+      {
+        if (!tablesValue.isObject() || !tablesValue.asObject(rt).isArray(rt))
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][createSession] tables must be an array of strings");
+        }
+        auto tablesArray = tablesValue.asObject(rt).asArray(rt);
+        for (size_t i = 0; i < tablesArray.length(rt); i++)
+        {
+          auto table = tablesArray.getValueAtIndex(rt, i);
+          if (!table.isString())
+          {
+            throw jsi::JSError(rt, "[react-native-quick-sqlite][createSession] tables must be an array of strings");
+          }
+          tables.push_back(table.asString(rt).utf8(rt));
+        }
+      }
+    }
+
+    shared_ptr<SessionHandle> handle;
+    auto status = sqliteSessionCreate(dbName, database, tables, &handle);
+    if (status.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, status.errorMessage);
+    }
+
+    auto session = make_shared<ChangesetSession>(handle, getExecutorProvider(pool, dbName), invoker);
+    return jsi::Object::createFromHostObject(rt, session);
+  });
+
+  // Begin a transaction owning the database, resolves once BEGIN ran on the worker thread
+  auto beginTransaction = HOSTFN("beginTransaction", 2)
+  {
+    if (count == 0 || !args[0].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][beginTransaction] dbName must be a string");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    string beginStatement = "BEGIN DEFERRED TRANSACTION";
+    if (count > 1)
+    {
+      beginStatement = jsiTransactionOptionsToBeginStatement(rt, args[1]);
+    }
+    // Transactions always wait for the database, a transaction in progress pauses it until it is finished
+    auto databaseExecutor = getDatabaseExecutor(pool, dbName);
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task =
+      [&rt, pool, dbName, beginStatement, databaseExecutor, resolve, reject]()
+      {
+        QuickParams params;
+        QuickResultSet results;
+        auto status = sqliteExecute(dbName, beginStatement, &params, &results, NULL);
+        if (status.type == SQLiteOk)
+        {
+          databaseExecutor->pause();
+        }
+
+        invoker->invokeAsync([&rt, pool, dbName, databaseExecutor, status_copy = move(status), resolve, reject]
+                             {
+          if(status_copy.type == SQLiteOk) {
+            auto state = make_shared<TransactionState>();
+            state->dbName = dbName;
+            state->databaseExecutor = databaseExecutor;
+            state->executor = make_shared<SerialExecutor>(pool);
+            state->isFinalized = false;
+
+            transactionExecutorMap[dbName] = state->executor;
+            auto transactionExecutor = state->executor;
+            auto transaction = make_shared<Transaction>(state, invoker, [dbName, transactionExecutor]()
+                                                        {
+              auto active = transactionExecutorMap.find(dbName);
+              if (active != transactionExecutorMap.end() && active->second == transactionExecutor)
+              {
+                transactionExecutorMap.erase(active);
+              } });
+            resolve->asObject(rt).asFunction(rt).call(rt, jsi::Object::createFromHostObject(rt, transaction));
+          } else {
+            auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+            auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+            reject->asObject(rt).asFunction(rt).call(rt, error);
+          }
+        });
+      };
+
+      databaseExecutor->queueWork(task);
 
       return {};
     }));
@@ -281,9 +1028,7 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
     auto batchResult = sqliteExecuteBatch(dbName, &commands);
     if (batchResult.type == SQLiteOk)
     {
-      auto res = jsi::Object(rt);
-      res.setProperty(rt, "rowsAffected", jsi::Value(batchResult.affectedRows));
-      return move(res);
+      return createSequelBatchOperationResult(rt, batchResult);
     }
     else
     {
@@ -329,12 +1074,12 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
                                {
             if(batchResult.type == SQLiteOk)
             {
-              auto res = jsi::Object(rt);
-              res.setProperty(rt, "rowsAffected", jsi::Value(batchResult.affectedRows));
-              resolve->asObject(rt).asFunction(rt).call(rt, move(res));
+              resolve->asObject(rt).asFunction(rt).call(rt, createSequelBatchOperationResult(rt, batchResult));
             } else
             {
-              throw jsi::JSError(rt, batchResult.message);
+              auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+              auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, batchResult.message));
+              reject->asObject(rt).asFunction(rt).call(rt, error);
             } });
         }
         catch (std::exception &exc)
@@ -345,7 +1090,84 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
           });
         }
       };
-      pool->queueWork(task);
+      getExecutor(pool, dbName)->queueWork(task);
+
+      return {};
+    }));
+
+    return promise;
+  });
+
+  // Apply a changeset created by a session, on a worker thread
+  auto applyChangesetAsync = HOSTFN("applyChangesetAsync", 3)
+  {
+    if (count < 2 || !args[0].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][applyChangesetAsync] dbName must be a string");
+    }
+
+    if (!args[1].isObject() || !args[1].asObject(rt).isArrayBuffer(rt))
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][applyChangesetAsync] changeset must be an ArrayBuffer");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    // Copied, the ArrayBuffer can't be used outside of the JS thread
+    auto buffer = args[1].asObject(rt).getArrayBuffer(rt);
+    auto changeset = make_shared<QuickBlob>(buffer.data(rt), buffer.size(rt));
+
+    ChangesetConflictPolicy policy = CONFLICT_ABORT;
+    if (count > 2 && args[2].isObject())
+    {
+      auto onConflict = args[2].asObject(rt).getProperty(rt, "onConflict");
+      if (!onConflict.isUndefined())
+      {
+        const string value = onConflict.isString() ? onConflict.asString(rt).utf8(rt) : "";
+        if (value == "abort")
+        {
+          policy = CONFLICT_ABORT;
+        }
+        else if (value == "omit")
+        {
+          policy = CONFLICT_OMIT;
+        }
+        else if (value == "replace")
+        {
+          policy = CONFLICT_REPLACE;
+        }
+        else
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][applyChangesetAsync] onConflict must be 'abort', 'omit' or 'replace'");
+        }
+      }
+    }
+
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+
+      auto task =
+      [&rt, dbName, changeset, policy, resolve, reject]()
+      {
+        int conflicts = 0;
+        auto status = sqliteApplyChangeset(dbName, changeset, policy, &conflicts);
+        invoker->invokeAsync([&rt, status_copy = move(status), conflicts, resolve, reject]
+                             {
+          if(status_copy.type == SQLiteOk)
+          {
+            auto res = jsi::Object(rt);
+            res.setProperty(rt, "rowsAffected", jsi::Value(status_copy.rowsAffected));
+            res.setProperty(rt, "conflicts", jsi::Value(conflicts));
+            resolve->asObject(rt).asFunction(rt).call(rt, move(res));
+          } else
+          {
+            auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+            auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, status_copy.errorMessage));
+            reject->asObject(rt).asFunction(rt).call(rt, error);
+          } });
+      };
+      getExecutor(pool, dbName)->queueWork(task);
 
       return {};
     }));
@@ -368,12 +1190,12 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
     }
     else
     {
-      throw jsi::JSError(rt, "[react-native-quick-sqlite][loadFile] Could not open file");
+      throw jsi::JSError(rt, importResult.message);
     }
   });
 
-  // Load SQL File from disk in another thread
-  auto loadFileAsync = HOSTFN("loadFileAsync", 2)
+  // Load SQL File from disk in another thread, the optional callback receives the progress of the import
+  auto loadFileAsync = HOSTFN("loadFileAsync", 3)
   {
     if (sizeof(args) < 2)
     {
@@ -383,6 +1205,11 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
 
     const string dbName = args[0].asString(rt).utf8(rt);
     const string sqlFileName = args[1].asString(rt).utf8(rt);
+    shared_ptr<jsi::Value> progressCallback;
+    if (count > 2 && args[2].isObject() && args[2].asObject(rt).isFunction(rt))
+    {
+      progressCallback = make_shared<jsi::Value>(rt, args[2]);
+    }
 
     auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
     auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
@@ -390,11 +1217,26 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
       auto reject = std::make_shared<jsi::Value>(rt, args[1]);
 
       auto task =
-      [&rt, dbName, sqlFileName, resolve, reject]()
+      [&rt, dbName, sqlFileName, progressCallback, resolve, reject]()
       {
         try
         {
-          const auto importResult = importSQLFile(dbName, sqlFileName);
+          function<void(SQLFileProgress)> onProgress = nullptr;
+          if (progressCallback != nullptr)
+          {
+            onProgress = [&rt, progressCallback](SQLFileProgress progress)
+            {
+              invoker->invokeAsync([&rt, progressCallback, progress]
+                                   {
+                auto res = jsi::Object(rt);
+                res.setProperty(rt, "bytesRead", jsi::Value((double)progress.bytesRead));
+                res.setProperty(rt, "totalBytes", jsi::Value((double)progress.totalBytes));
+                res.setProperty(rt, "commands", jsi::Value(progress.commands));
+                progressCallback->asObject(rt).asFunction(rt).call(rt, move(res)); });
+            };
+          }
+
+          const auto importResult = importSQLFile(dbName, sqlFileName, onProgress);
 
           invoker->invokeAsync([&rt, result = move(importResult), resolve, reject]
                                {
@@ -405,7 +1247,9 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
               res.setProperty(rt, "commands", jsi::Value(result.commands));
               resolve->asObject(rt).asFunction(rt).call(rt, move(res));
             } else {
-              throw jsi::JSError(rt, result.message);
+              auto errorCtr = rt.global().getPropertyAsFunction(rt, "Error");
+              auto error = errorCtr.callAsConstructor(rt, jsi::String::createFromUtf8(rt, result.message));
+              reject->asObject(rt).asFunction(rt).call(rt, error);
             } });
         }
         catch (std::exception &exc)
@@ -417,13 +1261,310 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
           });
         }
       };
-      pool->queueWork(task);
+      getExecutor(pool, dbName)->queueWork(task, PRIORITY_BACKGROUND);
       return {};
     }));
 
     return promise;
   });
 
+  // Copy the database into another file while it stays usable, the optional callback receives the progress
+  auto backupAsync = HOSTFN("backupAsync", 3)
+  {
+    if (count < 2 || !args[0].isString() || !args[1].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][backupAsync] database name and destination path are required");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string destinationPath = args[1].asString(rt).utf8(rt);
+    int pagesPerStep = DEFAULT_BACKUP_PAGES_PER_STEP;
+    shared_ptr<jsi::Value> progressCallback;
+    if (count > 2 && args[2].isObject())
+    {
+      auto options = args[2].asObject(rt);
+      auto pages = options.getProperty(rt, "pagesPerStep");
+      if (pages.isNumber())
+      {
+        pagesPerStep = (int)pages.asNumber();
+        if (pagesPerStep == 0 || pagesPerStep < -1)
+        {
+          throw jsi::JSError(rt, "[react-native-quick-sqlite][backupAsync] pagesPerStep must be positive or -1");
+        }
+      }
+      auto onProgress = options.getProperty(rt, "onProgress");
+      if (onProgress.isObject() && onProgress.asObject(rt).isFunction(rt))
+      {
+        progressCallback = make_shared<jsi::Value>(rt, onProgress);
+      }
+    }
+
+    shared_ptr<BackupHandle> handle;
+    auto status = sqliteBackupInit(dbName, destinationPath, &handle);
+    if (status.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, status.errorMessage);
+    }
+
+    // An open transaction is not part of the backup, the steps run once it is over
+    auto executor = getDatabaseExecutor(pool, dbName);
+    auto promiseCtr = rt.global().getPropertyAsFunction(rt, "Promise");
+    auto promise = promiseCtr.callAsConstructor(rt, HOSTFN("executor", 2) {
+      auto resolve = std::make_shared<jsi::Value>(rt, args[0]);
+      auto reject = std::make_shared<jsi::Value>(rt, args[1]);
+      queueBackupStep(&rt, executor, handle, pagesPerStep, progressCallback, resolve, reject);
+      return {};
+    }));
+
+    return promise;
+  });
+
+  auto getDbStatus = HOSTFN("getDbStatus", 2)
+  {
+    if (count == 0 || !args[0].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][getDbStatus] database name must be a string");
+    }
+
+    SQLiteDbStatus status;
+    auto result = sqliteDbStatus(args[0].asString(rt).utf8(rt), getBoolOption(rt, args, count, 1, "resetCounters"), &status);
+    if (result.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, result.errorMessage);
+    }
+    return createDbStatusObject(rt, status);
+  });
+
+  auto getMemoryStatus = HOSTFN("getMemoryStatus", 1)
+  {
+    auto status = sqliteMemoryStatus(getBoolOption(rt, args, count, 0, "resetHighwater"));
+    jsi::Object object = jsi::Object(rt);
+    object.setProperty(rt, "memoryUsed", jsi::Value((double)status.memoryUsed));
+    object.setProperty(rt, "memoryHighwater", jsi::Value((double)status.memoryHighwater));
+    object.setProperty(rt, "softHeapLimit", jsi::Value((double)status.softHeapLimit));
+    return object;
+  });
+
+  // Shrinks the caches of one database, or of all of them without a name, returns the bytes freed
+  auto releaseMemory = HOSTFN("releaseMemory", 1)
+  {
+    vector<string> dbNames = count > 0 && args[0].isString() ? vector<string>{args[0].asString(rt).utf8(rt)} : sqliteOpenDatabases();
+    long long released = 0;
+    for (auto &dbName : dbNames)
+    {
+      released += sqliteReleaseMemory(dbName);
+    }
+    return jsi::Value((double)released);
+  });
+
+  auto setMemoryLimits = HOSTFN("setMemoryLimits", 1)
+  {
+    if (count == 0 || !args[0].isObject())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][setMemoryLimits] limits must be an object");
+    }
+
+    auto limits = args[0].asObject(rt);
+    auto softHeapLimit = limits.getProperty(rt, "softHeapLimit");
+    if (softHeapLimit.isNumber())
+    {
+      sqliteSetSoftHeapLimit(max(0LL, (long long)softHeapLimit.asNumber()));
+    }
+    auto criticalLimit = limits.getProperty(rt, "criticalHeapLimit");
+    if (criticalLimit.isNumber())
+    {
+      criticalHeapLimit = max(0LL, (long long)criticalLimit.asNumber());
+    }
+    return {};
+  });
+
+  // Worker threads shared by every database, returns the count applied after clamping
+  auto setWorkerThreads = HOSTFN("setWorkerThreads", 1)
+  {
+    if (count == 0 || !args[0].isNumber() || args[0].asNumber() < 1)
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][setWorkerThreads] count must be a number greater than 0");
+    }
+
+    pool->setWorkerCount((unsigned int)args[0].asNumber());
+    return jsi::Value((int)pool->getWorkerCount());
+  });
+
+  // Token passed as the cancelToken option of async queries, cancelling it abandons all of them
+  auto createCancelToken = HOSTFN("createCancelToken", 0)
+  {
+    return jsi::Object::createFromHostObject(rt, make_shared<CancelToken>());
+  });
+
+  // Stops the statements running on the database right now, the queued queries still run
+  auto interrupt = HOSTFN("interrupt", 1)
+  {
+    if (count == 0 || !args[0].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][interrupt] database name must be a string");
+    }
+
+    auto result = sqliteInterrupt(args[0].asString(rt).utf8(rt));
+    if (result.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, result.errorMessage);
+    }
+    return {};
+  });
+
+  auto getStats = HOSTFN("getStats", 1)
+  {
+    if (count == 0 || !args[0].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][getStats] database name must be a string");
+    }
+
+    auto profiler = sqliteGetProfiler(args[0].asString(rt).utf8(rt));
+    if (profiler == nullptr)
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][getStats] Profiling is disabled, open the database with profile: true");
+    }
+    return createQueryStatsArray(rt, profiler->getStats());
+  });
+
+  auto resetStats = HOSTFN("resetStats", 1)
+  {
+    if (count == 0 || !args[0].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][resetStats] database name must be a string");
+    }
+
+    auto profiler = sqliteGetProfiler(args[0].asString(rt).utf8(rt));
+    if (profiler != nullptr)
+    {
+      profiler->reset();
+    }
+    return {};
+  });
+
+  // Streams the statements run on the connections, they are sent to JS in batches
+  auto trace = HOSTFN("trace", 2)
+  {
+    if (count == 0 || !args[0].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][trace] database name must be a string");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    function<void(string const &, double)> listener;
+    if (count > 1 && args[1].isObject() && args[1].asObject(rt).isFunction(rt))
+    {
+      auto callback = make_shared<jsi::Function>(args[1].asObject(rt).asFunction(rt));
+      auto buffer = make_shared<TraceBuffer>();
+      listener = [&rt, callback, buffer](string const &sql, double durationMs)
+      {
+        if (!buffer->push(TraceEvent{.sql = sql, .durationMs = durationMs}))
+        {
+          return;
+        }
+        invoker->invokeAsync([&rt, callback, buffer]
+                             {
+          auto events = buffer->take();
+          jsi::Array array = jsi::Array(rt, events.size());
+          for (size_t i = 0; i < events.size(); i++)
+          {
+            jsi::Object event = jsi::Object(rt);
+            event.setProperty(rt, "sql", jsi::String::createFromUtf8(rt, events[i].sql));
+            event.setProperty(rt, "durationMs", jsi::Value(events[i].durationMs));
+            array.setValueAtIndex(rt, i, move(event));
+          }
+          callback->call(rt, move(array)); });
+      };
+    }
+
+    auto status = sqliteSetTraceListener(dbName, listener);
+    if (status.type == SQLiteError)
+    {
+      throw jsi::JSError(rt, status.errorMessage);
+    }
+    return {};
+  });
+
+  auto subscribe = HOSTFN("subscribe", 6)
+  {
+    if (count < 5 || !args[0].isString() || !args[1].isString())
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][subscribe] database name and query are required");
+    }
+    if (!args[4].isObject() || !args[4].asObject(rt).isFunction(rt))
+    {
+      throw jsi::JSError(rt, "[react-native-quick-sqlite][subscribe] callback must be a function");
+    }
+
+    const string dbName = args[0].asString(rt).utf8(rt);
+    const string query = args[1].asString(rt).utf8(rt);
+    QuickParams params;
+    jsiQueryArgumentsToSequelParam(rt, args[2], &params);
+
+    set<string> tables;
+    if (args[3].isObject() && args[3].asObject(rt).isArray(rt))
+    {
+      jsi::Array tableNames = args[3].asObject(rt).asArray(rt);
+      for (size_t i = 0; i < tableNames.length(rt); i++)
+      {
+        tables.insert(lowercaseTableName(tableNames.getValueAtIndex(rt, i).asString(rt).utf8(rt).c_str()));
+      }
+    }
+    else
+    {
+      auto status = sqliteReadTables(dbName, query, &tables);
+      if (status.type == SQLiteError)
+      {
+        throw jsi::JSError(rt, status.errorMessage);
+      }
+    }
+
+    const QuickResultFormat format = count > 5 ? jsiQueryOptionsToResultFormat(rt, args[5]) : RESULT_OBJECTS;
+    shared_ptr<jsi::Function> onError;
+    if (count > 5 && args[5].isObject())
+    {
+      auto errorCallback = args[5].asObject(rt).getProperty(rt, "onError");
+      if (errorCallback.isObject() && errorCallback.asObject(rt).isFunction(rt))
+      {
+        onError = make_shared<jsi::Function>(errorCallback.asObject(rt).asFunction(rt));
+      }
+    }
+
+    auto subscriptions = subscriptionMap[dbName];
+    if (subscriptions == nullptr)
+    {
+      subscriptions = make_shared<QuerySubscriptions>();
+      auto status = sqliteSetChangeListener(dbName, [subscriptions](ChangeSet const &changes)
+                                            { subscriptions->notify(changes); });
+      if (status.type == SQLiteError)
+      {
+        subscriptionMap.erase(dbName);
+        throw jsi::JSError(rt, status.errorMessage);
+      }
+      subscriptionMap[dbName] = subscriptions;
+    }
+
+    // Runs behind the writes already queued, so every run sees committed data
+    auto subscription = make_shared<QuerySubscription>(
+                                                       rt,
+                                                       dbName,
+                                                       query,
+                                                       move(params),
+                                                       tables,
+                                                       format,
+                                                       make_shared<jsi::Function>(args[4].asObject(rt).asFunction(rt)),
+                                                       onError,
+                                                       getDatabaseExecutor(pool, dbName),
+                                                       invoker);
+    subscriptions->add(subscription);
+    subscription->start();
+
+    return HOSTFN("unsubscribe", 0) {
+      subscriptions->remove(subscription);
+      subscription->cancel();
+      return {};
+    });
+  });
 
   auto function = HOSTFN("function", 8)
   {
@@ -470,7 +1611,7 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
             throw jsi::JSError(rt, "[react-native-quick-sqlite][aggregate] Too less arguments passed");
         }
 
-        if (count > 14)
+        if (count > 15)
         {
             throw jsi::JSError(rt, "[react-native-quick-sqlite][aggregate] Too many arguments passed");
         }
@@ -489,6 +1630,17 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
         const std::shared_ptr<jsi::Function> start = std::make_shared<jsi::Function>(getFunction(rt, &args[11]));
         const std::shared_ptr<jsi::Function> inverse = std::make_shared<jsi::Function>(getFunction(rt, &args[12]));
         const std::shared_ptr<jsi::Function> result = std::make_shared<jsi::Function>(getFunction(rt, &args[13]));
+        // With a batch size step is stepBatch, it receives the arguments of many rows at once
+        const int batchSize = count > 14 && args[14].isNumber() ? (int)args[14].asNumber() : 0;
+        if (batchSize < 0)
+        {
+            throw jsi::JSError(rt, "[react-native-quick-sqlite][aggregate] batchSize must be positive");
+        }
+        if (batchSize > 0 && nArgs < 0)
+        {
+            // The rows of a batch are buffered as one column per argument
+            throw jsi::JSError(rt, "[react-native-quick-sqlite][aggregate] stepBatch needs a fixed number of arguments");
+        }
 
         const SQLiteFunctionResult r
             = sqliteCustomAggregate(
@@ -506,7 +1658,8 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
                                     resultIsFunction,
                                     start,
                                     inverse,
-                                    result
+                                    result,
+                                    batchSize
                                     );
 
         if (r.type == SQLiteOk) {
@@ -521,15 +1674,35 @@ void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker
 
   module.setProperty(rt, "open", move(open));
   module.setProperty(rt, "close", move(close));
+  module.setProperty(rt, "getCompileOptions", move(getCompileOptions));
   module.setProperty(rt, "attach", move(attach));
   module.setProperty(rt, "detach", move(detach));
   module.setProperty(rt, "delete", move(remove));
   module.setProperty(rt, "execute", move(execute));
   module.setProperty(rt, "executeAsync", move(executeAsync));
+  module.setProperty(rt, "executeManyAsync", move(executeManyAsync));
+  module.setProperty(rt, "prepare", move(prepare));
+  module.setProperty(rt, "openCursor", move(openCursor));
+  module.setProperty(rt, "openBlob", move(openBlob));
+  module.setProperty(rt, "createSession", move(createSession));
+  module.setProperty(rt, "beginTransaction", move(beginTransaction));
   module.setProperty(rt, "executeBatch", move(executeBatch));
   module.setProperty(rt, "executeBatchAsync", move(executeBatchAsync));
+  module.setProperty(rt, "applyChangesetAsync", move(applyChangesetAsync));
   module.setProperty(rt, "loadFile", move(loadFile));
   module.setProperty(rt, "loadFileAsync", move(loadFileAsync));
+  module.setProperty(rt, "backupAsync", move(backupAsync));
+  module.setProperty(rt, "getDbStatus", move(getDbStatus));
+  module.setProperty(rt, "getMemoryStatus", move(getMemoryStatus));
+  module.setProperty(rt, "releaseMemory", move(releaseMemory));
+  module.setProperty(rt, "setMemoryLimits", move(setMemoryLimits));
+  module.setProperty(rt, "setWorkerThreads", move(setWorkerThreads));
+  module.setProperty(rt, "createCancelToken", move(createCancelToken));
+  module.setProperty(rt, "interrupt", move(interrupt));
+  module.setProperty(rt, "getStats", move(getStats));
+  module.setProperty(rt, "resetStats", move(resetStats));
+  module.setProperty(rt, "trace", move(trace));
+  module.setProperty(rt, "subscribe", move(subscribe));
   module.setProperty(rt, "function", move(function));
   module.setProperty(rt, "aggregate", move(aggregate));
 
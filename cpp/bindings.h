@@ -6,5 +6,11 @@ using namespace facebook;
 
 namespace osp {
 void install(jsi::Runtime &rt, std::shared_ptr<react::CallInvoker> jsCallInvoker, const char *docPath);
+
+/**
+ * Called by the platform when the system runs low on memory, MAY be called from any thread.
+ * The caches of every open database are shrunk, critical pressure also applies the criticalHeapLimit set from JS
+ */
+void handleMemoryPressure(bool isCritical);
 }
 
@@ -2,6 +2,7 @@
  * Batch execution implementation
 */
 #include "sqlbatchexecutor.h"
+#include <chrono>
 
 void jsiBatchParametersToQuickArguments(jsi::Runtime &rt, jsi::Array const &batchParams, vector<QuickQueryArguments> *commands)
 {
@@ -19,25 +20,22 @@ void jsiBatchParametersToQuickArguments(jsi::Runtime &rt, jsi::Array const &batc
     {
       // This arguments is an array of arrays, like a batch update of a single sql command.
       const jsi::Array &batchUpdateParams = commandParams.asObject(rt).asArray(rt);
-      for (int x = 0; x < batchUpdateParams.length(rt); x++)
+      size_t paramSetCount = batchUpdateParams.length(rt);
+      QuickQueryArguments arguments{.sql = query};
+      arguments.params.resize(paramSetCount);
+      for (size_t x = 0; x < paramSetCount; x++)
       {
         const jsi::Value &p = batchUpdateParams.getValueAtIndex(rt, x);
-        vector<QuickValue> params;
-        jsiQueryArgumentsToSequelParam(rt, p, &params);
-        commands->push_back(QuickQueryArguments{
-          query,
-          make_shared<vector<QuickValue>>(params)
-        });
+        jsiQueryArgumentsToSequelParam(rt, p, &arguments.params[x]);
       }
+      commands->push_back(move(arguments));
     }
     else
     {
-      vector<QuickValue> params;
-      jsiQueryArgumentsToSequelParam(rt, commandParams, &params);
-      commands->push_back(QuickQueryArguments{
-        query,
-        make_shared<vector<QuickValue>>(params)
-      });
+      QuickQueryArguments arguments{.sql = query};
+      arguments.params.resize(1);
+      jsiQueryArgumentsToSequelParam(rt, commandParams, &arguments.params[0]);
+      commands->push_back(move(arguments));
     }
   }
 }
@@ -53,14 +51,30 @@ SequelBatchOperationResult sqliteExecuteBatch(std::string dbName, vector<QuickQu
     };
   }
 
+  auto connectionMutex = sqliteGetConnectionMutex(dbName);
+  if (connectionMutex == nullptr)
+  {
+    return SequelBatchOperationResult {
+      .type = SQLiteError,
+      .message = "[react-native-quick-sqlite] Database not opened: " + dbName,
+    };
+  }
+  // Nothing else may run on the connection until the transaction is over
+  lock_guard<ConnectionMutex> g(*connectionMutex);
+
   try 
   {
     int affectedRows = 0;
+    int executedCount = 0;
+    vector<double> commandTimings;
+    commandTimings.reserve(commandCount);
     sqliteExecuteLiteral(dbName, "BEGIN EXCLUSIVE TRANSACTION");
     for(int i = 0; i<commandCount; i++) {
-      auto command = commands->at(i);
-      // We do not provide a datastructure to receive query data because we don't need/want to handle this results in a batch execution
-      auto result = sqliteExecute(dbName, command.sql, command.params.get(), NULL, NULL);
+      auto &command = commands->at(i);
+      auto start = chrono::steady_clock::now();
+      // Rows are not read back, a batch only reports how many rows it changed
+      auto result = sqliteExecuteMany(dbName, command.sql, &command.params);
+      commandTimings.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
       if(result.type == SQLiteError)
       {
         sqliteExecuteLiteral(dbName, "ROLLBACK");
@@ -71,13 +85,15 @@ SequelBatchOperationResult sqliteExecuteBatch(std::string dbName, vector<QuickQu
       } else 
       {
         affectedRows += result.rowsAffected;
+        executedCount += (int) command.params.size();
       }
     }
     sqliteExecuteLiteral(dbName, "COMMIT");
     return SequelBatchOperationResult {
       .type = SQLiteOk,
       .affectedRows = affectedRows,
-      .commands = (int) commandCount,
+      .commands = executedCount,
+      .commandTimings = move(commandTimings),
     };
   } catch(std::exception &exc)
   {
@@ -88,3 +104,17 @@ SequelBatchOperationResult sqliteExecuteBatch(std::string dbName, vector<QuickQu
     };
   }
 }
+
+jsi::Object createSequelBatchOperationResult(jsi::Runtime &rt, SequelBatchOperationResult const &result)
+{
+  auto res = jsi::Object(rt);
+  res.setProperty(rt, "rowsAffected", jsi::Value(result.affectedRows));
+
+  auto timings = jsi::Array(rt, result.commandTimings.size());
+  for (size_t i = 0; i < result.commandTimings.size(); i++)
+  {
+    timings.setValueAtIndex(rt, i, jsi::Value(result.commandTimings[i]));
+  }
+  res.setProperty(rt, "commandTimings", move(timings));
+  return res;
+}
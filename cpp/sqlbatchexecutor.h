@@ -7,9 +7,12 @@
 using namespace std;
 using namespace facebook;
 
+/**
+ * A command of the batch, its statement is prepared once and run for every parameter set
+ */
 struct QuickQueryArguments {
   string sql;
-  shared_ptr<vector<QuickValue>> params;
+  vector<QuickParams> params;
 };
 
 /**
@@ -22,3 +25,9 @@ void jsiBatchParametersToQuickArguments(jsi::Runtime &rt, jsi::Array const &batc
  * Execute a batch of commands in a exclusive transaction 
 */
 SequelBatchOperationResult sqliteExecuteBatch(std::string dbName, vector<QuickQueryArguments> *commands);
+
+/**
+ * Converts a successful batch result into the object returned to JS
+ * MUST be called in the JavaScript Thread
+*/
+jsi::Object createSequelBatchOperationResult(jsi::Runtime &rt, SequelBatchOperationResult const &result);
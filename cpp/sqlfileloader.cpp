@@ -2,53 +2,395 @@
  * SQL File Loader implementation
 */
 #include "sqlfileloader.h"
-#include <iostream>
-#include <fstream>
+#include "SQLFileReader.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 
 using namespace std;
 
-SequelBatchOperationResult importSQLFile(string dbName, string fileLocation)
+// Bytes read from the file at once, progress is reported after each chunk
+#define SQL_FILE_CHUNK_SIZE (1024 * 1024)
+// Lowest SQLITE_MAX_VARIABLE_NUMBER of the supported SQLite versions, larger INSERTs run as they are
+#define MAX_IMPORT_PARAMETERS 999
+
+bool isIdentifierCharacter(char c)
+{
+  return isalnum((unsigned char)c) || c == '_' || c == '$' || (unsigned char)c >= 0x80;
+}
+
+bool startsWithKeyword(string const &sql, size_t position, const char *keyword)
+{
+  size_t length = strlen(keyword);
+  return sql.size() >= position + length
+    && sqlite3_strnicmp(sql.c_str() + position, keyword, (int)length) == 0
+    && (sql.size() == position + length || !isIdentifierCharacter(sql[position + length]));
+}
+
+size_t skipWhitespaceAndComments(string const &sql, size_t position)
+{
+  while (position < sql.size())
+  {
+    if (isspace((unsigned char)sql[position]))
+    {
+      position++;
+    }
+    else if (sql.compare(position, 2, "--") == 0)
+    {
+      size_t end = sql.find('\n', position);
+      position = end == string::npos ? sql.size() : end + 1;
+    }
+    else if (sql.compare(position, 2, "/*") == 0)
+    {
+      size_t end = sql.find("*/", position + 2);
+      position = end == string::npos ? sql.size() : end + 2;
+    }
+    else
+    {
+      break;
+    }
+  }
+  return position;
+}
+
+/**
+ * Copies a quoted token (string, identifier or comment) starting at position into target, returns the position after it
+ */
+size_t copyQuoted(string const &sql, size_t position, char close, string *target)
+{
+  size_t end = position + 1;
+  while (end < sql.size())
+  {
+    if (sql[end] == close)
+    {
+      // Doubled quotes are escaped quotes
+      if (close != ']' && end + 1 < sql.size() && sql[end + 1] == close)
+      {
+        end += 2;
+        continue;
+      }
+      break;
+    }
+    end++;
+  }
+  end = end < sql.size() ? end + 1 : end;
+  target->append(sql, position, end - position);
+  return end;
+}
+
+bool decodeHexBlob(string const &hex, vector<uint8_t> *bytes)
+{
+  if (hex.size() % 2 != 0)
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < hex.size(); i += 2)
+  {
+    if (!isxdigit((unsigned char)hex[i]) || !isxdigit((unsigned char)hex[i + 1]))
+    {
+      return false;
+    }
+    bytes->push_back((uint8_t)strtoul(hex.substr(i, 2).c_str(), NULL, 16));
+  }
+  return true;
+}
+
+/**
+ * Replaces the literal values of an INSERT statement with parameters, so statements only differing
+ * by their values share the same prepared statement. Returns false if the statement should run as is
+ */
+bool parametrizeInsert(string const &sql, string *shape, QuickParams *params)
 {
-  string line;
-  ifstream sqFile(fileLocation);
-  if (sqFile.is_open())
+  size_t i = skipWhitespaceAndComments(sql, 0);
+  if (!startsWithKeyword(sql, i, "INSERT") && !startsWithKeyword(sql, i, "REPLACE"))
+  {
+    return false;
+  }
+
+  bool isInValues = false;
+  shape->reserve(sql.size());
+  while (i < sql.size())
   {
-    try
+    char c = sql[i];
+    char next = i + 1 < sql.size() ? sql[i + 1] : '\0';
+
+    if (c == '-' && next == '-')
+    {
+      size_t end = sql.find('\n', i);
+      end = end == string::npos ? sql.size() : end;
+      shape->append(sql, i, end - i);
+      i = end;
+    }
+    else if (c == '/' && next == '*')
     {
-      int affectedRows = 0;
-      int commands = 0;
-      sqliteExecuteLiteral(dbName, "BEGIN EXCLUSIVE TRANSACTION");
-      while (std::getline(sqFile, line, '\n'))
+      size_t end = sql.find("*/", i + 2);
+      end = end == string::npos ? sql.size() : end + 2;
+      shape->append(sql, i, end - i);
+      i = end;
+    }
+    else if (c == '"' || c == '`')
+    {
+      i = copyQuoted(sql, i, c, shape);
+    }
+    else if (c == '[')
+    {
+      i = copyQuoted(sql, i, ']', shape);
+    }
+    else if (c == '\'')
+    {
+      string quoted;
+      i = copyQuoted(sql, i, '\'', &quoted);
+      if (!isInValues)
+      {
+        shape->append(quoted);
+        continue;
+      }
+      if (quoted.size() < 2 || quoted.back() != '\'')
       {
-        if (!line.empty())
+        return false;
+      }
+
+      string text;
+      text.reserve(quoted.size() - 2);
+      for (size_t q = 1; q + 1 < quoted.size(); q++)
+      {
+        text += quoted[q];
+        if (quoted[q] == '\'')
         {
-          SequelLiteralUpdateResult result = sqliteExecuteLiteral(dbName, line);
-          if (result.type == SQLiteError)
-          {
-            sqliteExecuteLiteral(dbName, "ROLLBACK");
-            sqFile.close();
-            return {SQLiteError, result.message, 0, commands};
-          }
-          else
+          q++;
+        }
+      }
+      params->addText(text);
+      shape->append("?");
+    }
+    else if ((c == 'x' || c == 'X') && next == '\'' && isInValues && (i == 0 || !isIdentifierCharacter(sql[i - 1])))
+    {
+      size_t end = sql.find('\'', i + 2);
+      vector<uint8_t> bytes;
+      if (end == string::npos || !decodeHexBlob(sql.substr(i + 2, end - i - 2), &bytes))
+      {
+        return false;
+      }
+      params->addBlob(make_shared<QuickBlob>(bytes.data(), bytes.size()));
+      shape->append("?");
+      i = end + 1;
+    }
+    else if (c == '$')
+    {
+      // A $name parameter, SQLite only allows the $ inside identifiers which are copied whole below
+      return false;
+    }
+    else if (isIdentifierCharacter(c) && !isdigit((unsigned char)c))
+    {
+      size_t end = i;
+      while (end < sql.size() && isIdentifierCharacter(sql[end]))
+      {
+        end++;
+      }
+      if (startsWithKeyword(sql, i, "VALUES"))
+      {
+        isInValues = true;
+      }
+      shape->append(sql, i, end - i);
+      i = end;
+    }
+    else if (isInValues && (isdigit((unsigned char)c) || (c == '.' && isdigit((unsigned char)next))))
+    {
+      size_t end = i;
+      bool isInteger = true;
+      while (end < sql.size())
+      {
+        char d = sql[end];
+        if (isdigit((unsigned char)d))
+        {
+          end++;
+        }
+        else if (d == '.' || d == 'e' || d == 'E')
+        {
+          isInteger = false;
+          end++;
+          if ((d == 'e' || d == 'E') && end < sql.size() && (sql[end] == '+' || sql[end] == '-'))
           {
-            affectedRows += result.affectedRows;
-            commands++;
+            end++;
           }
         }
+        else
+        {
+          break;
+        }
+      }
+
+      // Hexadecimal integers and malformed numbers are left to SQLite
+      if (end < sql.size() && isIdentifierCharacter(sql[end]))
+      {
+        return false;
+      }
+
+      string number = sql.substr(i, end - i);
+      char *parsedEnd;
+      errno = 0;
+      if (isInteger)
+      {
+        long long value = strtoll(number.c_str(), &parsedEnd, 10);
+        if (errno == ERANGE)
+        {
+          return false;
+        }
+        params->addInt64(value);
+      }
+      else
+      {
+        double value = strtod(number.c_str(), &parsedEnd);
+        if (*parsedEnd != '\0')
+        {
+          return false;
+        }
+        params->addDouble(value);
+      }
+      shape->append("?");
+      i = end;
+    }
+    else
+    {
+      if (c == '?' || c == ':' || c == '@')
+      {
+        // A statement with its own parameters cannot be mixed with ours
+        return false;
+      }
+      shape->push_back(c);
+      i++;
+    }
+  }
+
+  return isInValues && !params->empty() && params->size() <= MAX_IMPORT_PARAMETERS;
+}
+
+/**
+ * The import runs in a transaction of its own, the ones of the file (like in a .dump) are skipped
+ */
+bool isTransactionControlStatement(string const &sql)
+{
+  size_t i = skipWhitespaceAndComments(sql, 0);
+  return startsWithKeyword(sql, i, "BEGIN") || startsWithKeyword(sql, i, "COMMIT") || startsWithKeyword(sql, i, "END");
+}
+
+SQLiteOPResult importStatement(string const &dbName, string const &sql)
+{
+  vector<QuickParams> paramSets(1);
+  string shape;
+  if (parametrizeInsert(sql, &shape, &paramSets[0]))
+  {
+    return sqliteExecuteMany(dbName, shape, &paramSets);
+  }
+
+  paramSets[0].clear();
+  return sqliteExecuteMany(dbName, sql, &paramSets);
+}
+
+SequelBatchOperationResult importSQLFile(string dbName, string fileLocation, function<void(SQLFileProgress)> onProgress)
+{
+  auto connectionMutex = sqliteGetConnectionMutex(dbName);
+  if (connectionMutex == nullptr)
+  {
+    return {SQLiteError, "[react-native-quick-sqlite][loadSQLFile] Database not opened: " + dbName, 0, 0};
+  }
+  // Nothing else may run on the connection until the transaction is over
+  lock_guard<ConnectionMutex> g(*connectionMutex);
+
+  string openError;
+  auto sqFile = SQLFileReader::open(fileLocation, &openError);
+  if (sqFile == nullptr)
+  {
+    return {SQLiteError, openError, 0, 0};
+  }
+
+  try
+  {
+    int affectedRows = 0;
+    int commands = 0;
+    string pending;
+    string errorMessage;
+    vector<char> chunk(SQL_FILE_CHUNK_SIZE);
+
+    auto runStatement = [&](string const &sql) -> bool
+    {
+      if (isTransactionControlStatement(sql))
+      {
+        return true;
+      }
+
+      auto result = importStatement(dbName, sql);
+      if (result.type == SQLiteError)
+      {
+        sqliteExecuteLiteral(dbName, "ROLLBACK");
+        errorMessage = result.errorMessage;
+        return false;
+      }
+      affectedRows += result.rowsAffected;
+      commands++;
+      return true;
+    };
+
+    sqliteExecuteLiteral(dbName, "BEGIN EXCLUSIVE TRANSACTION");
+    // Compressed files are decompressed chunk by chunk, the SQL never has to fit in memory or on disk
+    while (true)
+    {
+      size_t chunkSize = sqFile->read(chunk.data(), chunk.size());
+      if (chunkSize == 0)
+      {
+        break;
+      }
+
+      // Statements do not end at the chunk boundary, the incomplete tail waits for the next chunk
+      size_t start = 0;
+      size_t scanFrom = pending.size();
+      pending.append(chunk.data(), chunkSize);
+      for (size_t end = pending.find(';', scanFrom); end != string::npos; end = pending.find(';', end + 1))
+      {
+        // A semicolon inside a string, comment or trigger body does not end the statement
+        char saved = pending[end + 1];
+        pending[end + 1] = '\0';
+        bool isComplete = sqlite3_complete(pending.c_str() + start) != 0;
+        pending[end + 1] = saved;
+        if (!isComplete)
+        {
+          continue;
+        }
+
+        if (!runStatement(pending.substr(start, end + 1 - start)))
+        {
+          return {SQLiteError, errorMessage, 0, commands};
+        }
+        start = end + 1;
+      }
+      pending.erase(0, start);
+
+      if (onProgress != nullptr)
+      {
+        onProgress(SQLFileProgress{.bytesRead = sqFile->bytesRead(), .totalBytes = sqFile->totalBytes(), .commands = commands});
       }
-      sqFile.close();
-      sqliteExecuteLiteral(dbName, "COMMIT");
-      return {SQLiteOk, "", affectedRows, commands};
     }
-    catch (...)
+
+    if (!sqFile->error().empty())
     {
-      sqFile.close();
       sqliteExecuteLiteral(dbName, "ROLLBACK");
-      return {SQLiteError, "[react-native-quick-sqlite][loadSQLFile] Unexpected error, transaction was rolledback", 0, 0};
+      return {SQLiteError, sqFile->error(), 0, commands};
     }
+
+    // The last statement does not need a semicolon
+    bool isBlank = skipWhitespaceAndComments(pending, 0) == pending.size();
+    if (!isBlank && !runStatement(pending))
+    {
+      return {SQLiteError, errorMessage, 0, commands};
+    }
+
+    sqliteExecuteLiteral(dbName, "COMMIT");
+    return {SQLiteOk, "", affectedRows, commands};
   }
-  else
+  catch (...)
   {
-    return {SQLiteError, "[react-native-quick-sqlite][loadSQLFile] Could not open file", 0, 0};
+    sqliteExecuteLiteral(dbName, "ROLLBACK");
+    return {SQLiteError, "[react-native-quick-sqlite][loadSQLFile] Unexpected error, transaction was rolledback", 0, 0};
   }
 }
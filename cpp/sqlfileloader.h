@@ -5,6 +5,24 @@
  *
 */
 
+#include <functional>
 #include "JSIHelper.h"
 #include "sqliteBridge.h"
-SequelBatchOperationResult importSQLFile(std::string dbName, std::string fileLocation);
\ No newline at end of file
+
+/**
+ * Progress of an import, bytesRead grows up to totalBytes
+*/
+struct SQLFileProgress
+{
+  size_t bytesRead;
+  size_t totalBytes;
+  int commands;
+};
+
+/**
+ * Streams the file in chunks and executes it statement by statement, statements may span several lines.
+ * gzip files (and zstd ones with QUICK_SQLITE_USE_ZSTD) are decompressed while reading.
+ * The values of INSERT statements are bound as parameters so every distinct shape is prepared only once.
+ * onProgress is called from the importing thread after every chunk
+*/
+SequelBatchOperationResult importSQLFile(std::string dbName, std::string fileLocation, std::function<void(SQLFileProgress)> onProgress = nullptr);
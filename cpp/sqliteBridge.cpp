@@ -15,14 +15,47 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <map>
+#include <algorithm>
 #include "logs.h"
 #include "CustomAggregate.h"
+#include "StatementCache.h"
+#include "ReaderPool.h"
+#include "NativeAggregates.h"
+#include "QueryInterrupt.h"
+#include "FullTextSearch.h"
 
 using namespace std;
 using namespace facebook;
 using namespace osp;
 
+// Bundled databases are mostly read at random, mapping them avoids copying every page into the page cache
+#define DEFAULT_ASSET_MMAP_SIZE (256LL * 1024 * 1024)
+// Largest integer a double represents exactly, Number.MAX_SAFE_INTEGER
+#define MAX_SAFE_INTEGER 9007199254740991LL
+// Wait before retrying a backup step when the source is locked
+#define BACKUP_BUSY_SLEEP_MS 10
+
 map<string, sqlite3 *> dbMap = map<string, sqlite3 *>();
+map<string, shared_ptr<StatementCache>> statementCacheMap = map<string, shared_ptr<StatementCache>>();
+// Connections are opened with SQLITE_OPEN_NOMUTEX, every use of a connection has to hold its mutex.
+// It is recursive because custom functions run JS which can execute queries on the same connection,
+// and it keeps the JS thread serving custom function calls while it waits for a worker
+map<string, shared_ptr<ConnectionMutex>> connectionMutexMap = map<string, shared_ptr<ConnectionMutex>>();
+map<string, shared_ptr<ReaderPool>> readerPoolMap = map<string, shared_ptr<ReaderPool>>();
+map<string, vector<weak_ptr<PreparedStatementHandle>>> preparedStatementMap = map<string, vector<weak_ptr<PreparedStatementHandle>>>();
+// Open blobs keep the connection busy like statements, they are closed with their database
+map<string, vector<weak_ptr<BlobHandle>>> blobMap = map<string, vector<weak_ptr<BlobHandle>>>();
+map<string, vector<weak_ptr<SessionHandle>>> sessionMap = map<string, vector<weak_ptr<SessionHandle>>>();
+// Databases opened from a bundled file, attaching them uses the same URI and mmap size
+map<string, SQLiteAsset> assetMap = map<string, SQLiteAsset>();
+// Databases opened with the bigInt option
+map<string, bool> bigIntMap = map<string, bool>();
+// Changes of the writer connections, only the writer modifies the database
+map<string, shared_ptr<ChangeTracker>> changeTrackerMap = map<string, shared_ptr<ChangeTracker>>();
+// Databases opened with the profile option
+map<string, shared_ptr<QueryProfiler>> profilerMap = map<string, shared_ptr<QueryProfiler>>();
+// Listeners installed with sqlite3_trace_v2 on every connection of a database
+map<string, shared_ptr<function<void(string const &, double)>>> traceListenerMap = map<string, shared_ptr<function<void(string const &, double)>>>();
 
 bool folder_exists(const std::string &foldername)
 {
@@ -37,11 +70,7 @@ bool folder_exists(const std::string &foldername)
  */
 int _mkdir(const char *path)
 {
-#if _POSIX_C_SOURCE
-  return mkdir(path);
-#else
-  return mkdir(path, 0755); // not sure if this works on mac
-#endif
+  return mkdir(path, 0755);
 }
 
 /**
@@ -82,69 +111,1498 @@ string get_db_path(string const dbName, string const docPath)
   return docPath + "/" + dbName;
 }
 
-SQLiteOPResult sqliteOpenDb(string const dbName, string const docPath)
+/**
+ * immutable=1 tells SQLite the file cannot change, it is read without any locking or journal
+ */
+string get_asset_uri(string const &assetPath)
+{
+  string uri = "file:";
+  for (char c : assetPath)
+  {
+    if (c == '%' || c == '?' || c == '#')
+    {
+      char escaped[4];
+      snprintf(escaped, sizeof(escaped), "%%%02X", (unsigned char)c);
+      uri += escaped;
+    }
+    else
+    {
+      uri += c;
+    }
+  }
+  return uri + "?mode=ro&immutable=1";
+}
+
+string quote_literal(string const &value)
+{
+  string quoted = "'";
+  for (char c : value)
+  {
+    quoted += c;
+    if (c == '\'')
+    {
+      quoted += c;
+    }
+  }
+  return quoted + "'";
+}
+
+int exec_setting(sqlite3 *db, string const &statement, string *errorMessage)
+{
+  char *message = NULL;
+  int exit = sqlite3_exec(db, statement.c_str(), NULL, NULL, &message);
+  if (exit != SQLITE_OK)
+  {
+    *errorMessage = statement + ": " + (message != NULL ? message : sqlite3_errmsg(db));
+  }
+  sqlite3_free(message);
+  return exit;
+}
+
+/**
+ * Applies the tuning of the open options, the settings persisted in the file or shared by all the
+ * connections (page size, journal mode, synchronous) are only set through the writer
+ */
+int configure_connection(sqlite3 *db, SQLiteOpenOptions const &options, long long mmapSize, bool isWriter, string *errorMessage)
+{
+  int exit = registerNativeAggregates(db);
+  if (exit != SQLITE_OK)
+  {
+    *errorMessage = string("Could not register the native aggregates: ") + sqlite3_errmsg(db);
+    return exit;
+  }
+  exit = registerFullTextSearch(db);
+  if (exit != SQLITE_OK)
+  {
+    *errorMessage = string("Could not register the full-text search extensions: ") + sqlite3_errmsg(db);
+    return exit;
+  }
+  installQueryInterruptHandler(db);
+
+  vector<string> statements;
+  if (isWriter)
+  {
+    // The page size of an existing database only changes with a VACUUM, it has to come before WAL
+    if (options.pageSize > 0)
+    {
+      statements.push_back("PRAGMA page_size = " + to_string(options.pageSize));
+    }
+    // Readers can only run next to the writer in WAL mode, the setting is persisted in the file
+    string journalMode = !options.journalMode.empty() ? options.journalMode : options.readerConnections > 0 ? "WAL" : "";
+    if (!journalMode.empty())
+    {
+      statements.push_back("PRAGMA journal_mode = " + journalMode);
+    }
+    if (!options.synchronous.empty())
+    {
+      statements.push_back("PRAGMA synchronous = " + options.synchronous);
+    }
+  }
+  if (options.cacheSize != 0)
+  {
+    statements.push_back("PRAGMA cache_size = " + to_string(options.cacheSize));
+  }
+  if (mmapSize >= 0)
+  {
+    statements.push_back("PRAGMA mmap_size = " + to_string(mmapSize));
+  }
+  if (!options.tempStore.empty())
+  {
+    statements.push_back("PRAGMA temp_store = " + options.tempStore);
+  }
+
+  for (auto &statement : statements)
+  {
+    exit = exec_setting(db, statement, errorMessage);
+    if (exit != SQLITE_OK)
+    {
+      return exit;
+    }
+  }
+
+  if (options.busyTimeout >= 0)
+  {
+    return sqlite3_busy_timeout(db, options.busyTimeout);
+  }
+  return SQLITE_OK;
+}
+
+SQLiteOPResult sqliteOpenDb(string const dbName, string const docPath, SQLiteOpenOptions const &options)
+{
+  const bool isAsset = !options.assetPath.empty();
+  string dbPath = isAsset ? get_asset_uri(options.assetPath) : get_db_path(dbName, docPath);
+
+  // URI filenames are also needed to attach bundled databases
+  int sqlOpenFlags = isAsset
+    ? SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI
+    : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI;
+
+  sqlite3 *db;
+  int exit = 0;
+  exit = sqlite3_open_v2(dbPath.c_str(), &db, sqlOpenFlags, nullptr);
+
+  if (exit != SQLITE_OK)
+  {
+    string message = sqlite3_errmsg(db);
+    sqlite3_close_v2(db);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = message
+    };
+  }
+
+  const long long mmapSize = options.mmapSize >= 0 ? options.mmapSize : isAsset ? DEFAULT_ASSET_MMAP_SIZE : -1;
+  string configureError;
+  exit = configure_connection(db, options, mmapSize, !isAsset, &configureError);
+  if (exit != SQLITE_OK)
+  {
+    sqlite3_close_v2(db);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Could not configure the connection: " + configureError
+    };
+  }
+
+  if (options.readerConnections > 0)
+  {
+    string readerError;
+    auto readerPool = make_shared<ReaderPool>();
+    exit = readerPool->open(dbPath, options.readerConnections, options.statementCacheSize, [&](sqlite3 *reader, string *errorMessage)
+                            { return configure_connection(reader, options, mmapSize, false, errorMessage); }, &readerError);
+
+    if (exit != SQLITE_OK)
+    {
+      sqlite3_close_v2(db);
+      return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite] Could not open reader connections: " + readerError
+      };
+    }
+
+    readerPoolMap[dbName] = readerPool;
+  }
+
+  if (isAsset)
+  {
+    assetMap[dbName] = SQLiteAsset{.uri = dbPath, .mmapSize = mmapSize};
+  }
+
+  dbMap[dbName] = db;
+  bigIntMap[dbName] = options.bigInt;
+  changeTrackerMap[dbName] = make_shared<ChangeTracker>(db);
+  if (options.profile)
+  {
+    profilerMap[dbName] = make_shared<QueryProfiler>();
+  }
+  connectionMutexMap[dbName] = make_shared<ConnectionMutex>();
+  statementCacheMap[dbName] = make_shared<StatementCache>(db, options.statementCacheSize);
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+    .rowsAffected = 0
+  };
+}
+
+vector<string> sqliteCompileOptions()
+{
+  vector<string> compileOptions;
+  for (int i = 0; sqlite3_compileoption_get(i) != NULL; i++)
+  {
+    compileOptions.push_back(sqlite3_compileoption_get(i));
+  }
+  return compileOptions;
+}
+
+SQLiteOPResult sqliteCloseDb(string const dbName)
+{
+
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = dbName + " is not open",
+    };
+  }
+
+  sqlite3 *db = dbMap[dbName];
+  auto connectionMutex = connectionMutexMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutex);
+
+  // Cached and prepared statements would keep the connection busy, they have to be finalized before closing
+  statementCacheMap[dbName]->clear();
+  statementCacheMap.erase(dbName);
+
+  for (auto &preparedStatement : preparedStatementMap[dbName])
+  {
+    if (auto handle = preparedStatement.lock())
+    {
+      sqliteFinalizePreparedStatement(handle);
+    }
+  }
+  preparedStatementMap.erase(dbName);
+  for (auto &blob : blobMap[dbName])
+  {
+    if (auto handle = blob.lock())
+    {
+      sqliteBlobClose(handle);
+    }
+  }
+  blobMap.erase(dbName);
+  // Sessions MUST be deleted before their connection is closed
+  for (auto &session : sessionMap[dbName])
+  {
+    if (auto handle = session.lock())
+    {
+      sqliteSessionClose(handle);
+    }
+  }
+  sessionMap.erase(dbName);
+  changeTrackerMap.erase(dbName);
+
+  sqlite3_close_v2(db);
+
+  if (readerPoolMap.count(dbName) > 0)
+  {
+    readerPoolMap[dbName]->close();
+    readerPoolMap.erase(dbName);
+  }
+
+  dbMap.erase(dbName);
+  connectionMutexMap.erase(dbName);
+  assetMap.erase(dbName);
+  bigIntMap.erase(dbName);
+  profilerMap.erase(dbName);
+  traceListenerMap.erase(dbName);
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteInterrupt(string const dbName)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+    };
+  }
+
+  // sqlite3_interrupt is safe while another thread uses the connection, the mutex is not taken
+  sqlite3_interrupt(dbMap[dbName]);
+  if (readerPoolMap.count(dbName) > 0)
+  {
+    readerPoolMap[dbName]->interrupt();
+  }
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+shared_ptr<ConnectionMutex> sqliteGetConnectionMutex(string const dbName)
+{
+  if (connectionMutexMap.count(dbName) == 0)
+  {
+    return nullptr;
+  }
+  return connectionMutexMap[dbName];
+}
+
+SQLiteOPResult sqliteSetChangeListener(string const dbName, function<void(ChangeSet const &)> listener)
+{
+  if (changeTrackerMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+    };
+  }
+
+  changeTrackerMap[dbName]->setListener(listener);
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+int trace_statement(unsigned type, void *context, void *statement, void *duration)
+{
+  auto listener = static_cast<function<void(string const &, double)> *>(context);
+  const char *sql = sqlite3_sql(static_cast<sqlite3_stmt *>(statement));
+  (*listener)(sql != NULL ? sql : "", (double)*static_cast<sqlite3_int64 *>(duration) / 1e6);
+  return 0;
+}
+
+SQLiteOPResult sqliteSetTraceListener(string const dbName, function<void(string const &, double)> listener)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+    };
+  }
+
+  auto context = listener != nullptr ? make_shared<function<void(string const &, double)>>(listener) : nullptr;
+  unsigned mask = context != nullptr ? SQLITE_TRACE_PROFILE : 0;
+  {
+    lock_guard<ConnectionMutex> g(*connectionMutexMap[dbName]);
+    sqlite3_trace_v2(dbMap[dbName], mask, context != nullptr ? trace_statement : NULL, context.get());
+  }
+  if (readerPoolMap.count(dbName) > 0)
+  {
+    readerPoolMap[dbName]->forEachConnection([mask, &context](ReaderConnection *reader)
+                                             { sqlite3_trace_v2(reader->db, mask, context != nullptr ? trace_statement : NULL, context.get()); });
+  }
+
+  // No connection uses the previous listener anymore
+  if (context != nullptr)
+  {
+    traceListenerMap[dbName] = context;
+  }
+  else
+  {
+    traceListenerMap.erase(dbName);
+  }
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+int collect_read_tables(void *context, int action, const char *table, const char *column, const char *database, const char *trigger)
+{
+  if (action == SQLITE_READ && table != NULL)
+  {
+    static_cast<set<string> *>(context)->insert(lowercaseTableName(table));
+  }
+  return SQLITE_OK;
+}
+
+SQLiteOPResult sqliteReadTables(string const dbName, string const &query, set<string> *tables)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+    };
+  }
+
+  sqlite3 *db = dbMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutexMap[dbName]);
+
+  // The authorizer sees every table the compiled statement reads, including the ones behind views.
+  // Setting it expires the cached statements, they are recompiled transparently on their next use
+  sqlite3_stmt *statement = NULL;
+  sqlite3_set_authorizer(db, collect_read_tables, tables);
+  int statementStatus = sqlite3_prepare_v2(db, query.c_str(), -1, &statement, NULL);
+  sqlite3_set_authorizer(db, NULL, NULL);
+  sqlite3_finalize(statement);
+
+  if (statementStatus != SQLITE_OK)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] SQL execution error: " + string(sqlite3_errmsg(db)),
+    };
+  }
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteBackupInit(string const dbName, string const &destinationPath, shared_ptr<BackupHandle> *handle)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+    };
+  }
+
+  sqlite3 *destination;
+  int exit = sqlite3_open_v2(destinationPath.c_str(), &destination, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, nullptr);
+  if (exit != SQLITE_OK)
+  {
+    string message = sqlite3_errmsg(destination);
+    sqlite3_close_v2(destination);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Could not open backup destination: " + message,
+    };
+  }
+
+  auto connectionMutex = connectionMutexMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutex);
+  sqlite3_backup *backup = sqlite3_backup_init(destination, "main", dbMap[dbName], "main");
+  if (backup == NULL)
+  {
+    string message = sqlite3_errmsg(destination);
+    sqlite3_close_v2(destination);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Could not start backup: " + message,
+    };
+  }
+
+  *handle = make_shared<BackupHandle>();
+  (*handle)->connectionMutex = connectionMutex;
+  (*handle)->destination = destination;
+  (*handle)->backup = backup;
+  (*handle)->remainingPages = 0;
+  (*handle)->totalPages = 0;
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteBackupStep(shared_ptr<BackupHandle> handle, int pages, bool *done)
+{
+  *done = false;
+  int status;
+  {
+    lock_guard<ConnectionMutex> g(*handle->connectionMutex);
+    if (handle->backup == NULL)
+    {
+      return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite] Backup already finished",
+      };
+    }
+
+    status = sqlite3_backup_step(handle->backup, pages);
+    handle->remainingPages = sqlite3_backup_remaining(handle->backup);
+    handle->totalPages = sqlite3_backup_pagecount(handle->backup);
+  }
+
+  // Busy and locked are temporary, the step is retried a bit later without holding the connection
+  if (status == SQLITE_BUSY || status == SQLITE_LOCKED)
+  {
+    sqlite3_sleep(BACKUP_BUSY_SLEEP_MS);
+  }
+
+  if (status == SQLITE_OK || status == SQLITE_BUSY || status == SQLITE_LOCKED)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteOk,
+    };
+  }
+
+  if (status == SQLITE_DONE)
+  {
+    *done = true;
+    return SQLiteOPResult{
+      .type = SQLiteOk,
+    };
+  }
+
+  return SQLiteOPResult{
+    .type = SQLiteError,
+    .errorMessage = "[react-native-quick-sqlite] Backup failed: " + string(sqlite3_errstr(status)),
+  };
+}
+
+SQLiteOPResult sqliteBackupFinish(shared_ptr<BackupHandle> handle)
+{
+  lock_guard<ConnectionMutex> g(*handle->connectionMutex);
+  if (handle->backup == NULL)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteOk,
+    };
+  }
+
+  int status = sqlite3_backup_finish(handle->backup);
+  handle->backup = NULL;
+  string message = status != SQLITE_OK ? sqlite3_errmsg(handle->destination) : "";
+  sqlite3_close_v2(handle->destination);
+  handle->destination = NULL;
+
+  if (status != SQLITE_OK)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Backup failed: " + message,
+    };
+  }
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+/**
+ * Run a statement on every reader connection so they see the same databases as the writer
+ */
+void sqliteExecuteOnReaders(string const dbName, string const &statement)
+{
+  if (readerPoolMap.count(dbName) == 0)
+  {
+    return;
+  }
+
+  readerPoolMap[dbName]->forEachConnection([&](ReaderConnection *connection)
+                                           {
+    connection->statementCache->clear();
+    sqlite3_exec(connection->db, statement.c_str(), NULL, NULL, NULL); });
+}
+
+SQLiteOPResult sqliteAttachDb(string const mainDBName, string const docPath, string const databaseToAttach, string const alias)
+{
+  /**
+   * There is no need to check if mainDBName is opened because sqliteExecuteLiteral will do that.
+   * */
+  // A bundled database that was opened before is attached in place, read-only
+  auto asset = assetMap.find(databaseToAttach);
+  string dbPath = asset != assetMap.end() ? asset->second.uri : get_db_path(databaseToAttach, docPath);
+  string statement = "ATTACH DATABASE " + quote_literal(dbPath) + " AS " + alias;
+  SequelLiteralUpdateResult result = sqliteExecuteLiteral(mainDBName, statement);
+  if (result.type == SQLiteError)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = mainDBName + " was unable to attach another database: " + string(result.message),
+    };
+  }
+  sqliteExecuteOnReaders(mainDBName, statement);
+
+  if (asset != assetMap.end() && asset->second.mmapSize >= 0)
+  {
+    string mmapStatement = "PRAGMA " + alias + ".mmap_size = " + to_string(asset->second.mmapSize);
+    sqliteExecuteLiteral(mainDBName, mmapStatement);
+    sqliteExecuteOnReaders(mainDBName, mmapStatement);
+  }
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteDetachDb(string const mainDBName, string const alias)
+{
+  /**
+   * There is no need to check if mainDBName is opened because sqliteExecuteLiteral will do that.
+   * */
+  string statement = "DETACH DATABASE " + alias;
+  SequelLiteralUpdateResult result = sqliteExecuteLiteral(mainDBName, statement);
+  if (result.type == SQLiteError)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = mainDBName + "was unable to detach database: " + string(result.message),
+    };
+  }
+  sqliteExecuteOnReaders(mainDBName, statement);
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+SQLiteOPResult sqliteRemoveDb(string const dbName, string const docPath)
+{
+  if (dbMap.count(dbName) == 1)
+  {
+    SQLiteOPResult closeResult = sqliteCloseDb(dbName);
+    if (closeResult.type == SQLiteError)
+    {
+      return closeResult;
+    }
+  }
+
+  string dbPath = get_db_path(dbName, docPath);
+
+  if (!file_exists(dbPath))
+  {
+    return SQLiteOPResult{
+      .type = SQLiteOk,
+      .errorMessage = "[react-native-quick-sqlite]: Database file not found" + dbPath
+    };
+  }
+
+  remove(dbPath.c_str());
+  // Left over by connections in WAL mode
+  remove((dbPath + "-wal").c_str());
+  remove((dbPath + "-shm").c_str());
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+/**
+ * Adds the current value of op on the connection to target, the highwater is not needed for these counters
+ */
+void add_db_status(sqlite3 *db, int op, bool reset, long long *target)
+{
+  int current = 0;
+  int highwater = 0;
+  sqlite3_db_status(db, op, &current, &highwater, reset ? 1 : 0);
+  *target += current;
+}
+
+void add_connection_status(sqlite3 *db, bool resetCounters, SQLiteDbStatus *status)
+{
+  add_db_status(db, SQLITE_DBSTATUS_CACHE_USED, false, &status->cacheUsed);
+  add_db_status(db, SQLITE_DBSTATUS_CACHE_HIT, resetCounters, &status->cacheHit);
+  add_db_status(db, SQLITE_DBSTATUS_CACHE_MISS, resetCounters, &status->cacheMiss);
+  add_db_status(db, SQLITE_DBSTATUS_CACHE_WRITE, resetCounters, &status->cacheWrite);
+  add_db_status(db, SQLITE_DBSTATUS_CACHE_SPILL, resetCounters, &status->cacheSpill);
+  add_db_status(db, SQLITE_DBSTATUS_SCHEMA_USED, false, &status->schemaUsed);
+  add_db_status(db, SQLITE_DBSTATUS_STMT_USED, false, &status->statementUsed);
+  add_db_status(db, SQLITE_DBSTATUS_LOOKASIDE_USED, false, &status->lookasideUsed);
+}
+
+SQLiteOPResult sqliteDbStatus(string const dbName, bool resetCounters, SQLiteDbStatus *status)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+    };
+  }
+
+  *status = SQLiteDbStatus{};
+  {
+    lock_guard<ConnectionMutex> g(*connectionMutexMap[dbName]);
+    add_connection_status(dbMap[dbName], resetCounters, status);
+  }
+  if (readerPoolMap.count(dbName) > 0)
+  {
+    readerPoolMap[dbName]->forEachConnection([resetCounters, status](ReaderConnection *reader)
+                                             { add_connection_status(reader->db, resetCounters, status); });
+  }
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+SQLiteMemoryStatus sqliteMemoryStatus(bool resetHighwater)
+{
+  sqlite3_int64 current = 0;
+  sqlite3_int64 highwater = 0;
+  sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &current, &highwater, resetHighwater ? 1 : 0);
+  return SQLiteMemoryStatus{
+    .memoryUsed = current,
+    .memoryHighwater = highwater,
+    // A negative limit only reads the current one
+    .softHeapLimit = sqlite3_soft_heap_limit64(-1),
+  };
+}
+
+long long sqliteReleaseMemory(string const dbName)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return 0;
+  }
+
+  // sqlite3_db_release_memory does not report what it freed, the difference of the cache sizes does
+  SQLiteDbStatus before;
+  SQLiteDbStatus after;
+  sqliteDbStatus(dbName, false, &before);
+  {
+    lock_guard<ConnectionMutex> g(*connectionMutexMap[dbName]);
+    sqlite3_db_release_memory(dbMap[dbName]);
+  }
+  if (readerPoolMap.count(dbName) > 0)
+  {
+    readerPoolMap[dbName]->forEachConnection([](ReaderConnection *reader)
+                                             { sqlite3_db_release_memory(reader->db); });
+  }
+  sqliteDbStatus(dbName, false, &after);
+  return max(0LL, before.cacheUsed - after.cacheUsed);
+}
+
+vector<string> sqliteOpenDatabases()
+{
+  vector<string> names;
+  for (auto &db : dbMap)
+  {
+    names.push_back(db.first);
+  }
+  return names;
+}
+
+long long sqliteSetSoftHeapLimit(long long limit)
+{
+  return sqlite3_soft_heap_limit64(limit);
+}
+
+shared_ptr<QueryProfiler> sqliteGetProfiler(string const dbName)
+{
+  auto profiler = profilerMap.find(dbName);
+  return profiler != profilerMap.end() ? profiler->second : nullptr;
+}
+
+/**
+ * Adds an execution of the statement to the stats of the query, MUST be called before the statement is released.
+ * The SQLite counters are reset so every execution only reports its own work
+ */
+void record_execution(shared_ptr<QueryProfiler> profiler, string const &query, sqlite3_stmt *statement, ProfilerTime prepareStart, ProfilerTime stepStart, SQLiteOPResult const &result, QuickResultSet *results, int runs)
+{
+  QueryExecution execution;
+  execution.prepareMs = elapsedMs(prepareStart, stepStart);
+  execution.stepMs = elapsedMs(stepStart, profilerNow());
+  execution.runs = runs;
+  execution.isFailed = result.type == SQLiteError;
+  if (statement != NULL)
+  {
+    execution.fullscanSteps = sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    execution.sorts = sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_SORT, 1);
+    execution.autoindexes = sqlite3_stmt_status(statement, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+  }
+  if (results != NULL)
+  {
+    execution.rows = (long long)results->rowCount;
+    for (auto &cell : results->cells)
+    {
+      if (cell.dataType == TEXT)
+      {
+        execution.bytes += cell.textValue.size();
+      }
+      else if (cell.dataType == ARRAY_BUFFER)
+      {
+        execution.bytes += cell.arrayBufferValue->size();
+      }
+      else if (cell.dataType != NULL_VALUE)
+      {
+        execution.bytes += sizeof(double);
+      }
+    }
+  }
+  profiler->recordExecution(query, execution);
+}
+
+/**
+ * Finds the index of a named parameter, the name can be given with or without its prefix
+ */
+int bindParameterIndex(sqlite3_stmt *statement, string const &name)
+{
+  int index = sqlite3_bind_parameter_index(statement, name.c_str());
+  if (index != 0 || name[0] == ':' || name[0] == '@' || name[0] == '$')
+  {
+    return index;
+  }
+
+  for (const char *prefix : {":", "@", "$"})
+  {
+    index = sqlite3_bind_parameter_index(statement, (prefix + name).c_str());
+    if (index != 0)
+    {
+      return index;
+    }
+  }
+  return 0;
+}
+
+SQLiteOPResult bindStatement(sqlite3_stmt *statement, QuickParams const *params)
+{
+  // Text and blobs are bound without copies, nothing bound by a previous call may outlive its values
+  sqlite3_clear_bindings(statement);
+
+  int position = 0;
+  for (QuickParam const &param : params->values)
+  {
+    int sqIndex = ++position;
+    if (param.nameLength > 0)
+    {
+      string name = params->arena.substr(param.nameOffset, param.nameLength);
+      sqIndex = bindParameterIndex(statement, name);
+      if (sqIndex == 0)
+      {
+        return SQLiteOPResult{
+          .type = SQLiteError,
+          .errorMessage = "[react-native-quick-sqlite] Unknown named parameter: " + name,
+        };
+      }
+    }
+
+    int status = SQLITE_OK;
+    switch (param.type)
+    {
+    case PARAM_NULL:
+      status = sqlite3_bind_null(statement, sqIndex);
+      break;
+    case PARAM_INT64:
+      status = sqlite3_bind_int64(statement, sqIndex, param.int64Value);
+      break;
+    case PARAM_DOUBLE:
+      status = sqlite3_bind_double(statement, sqIndex, param.doubleValue);
+      break;
+    case PARAM_TEXT:
+      // The params outlive the execution of the statement, SQLite can use the arena directly
+      status = sqlite3_bind_text(statement, sqIndex, params->arena.data() + param.text.offset, (int)param.text.length, SQLITE_STATIC);
+      break;
+    case PARAM_BLOB:
+    {
+      auto &blob = params->blobs[param.blobIndex];
+      // A NULL pointer would bind NULL, an empty ArrayBuffer is an empty blob
+      if (blob->size() == 0)
+      {
+        status = sqlite3_bind_zeroblob(statement, sqIndex, 0);
+      }
+      else
+      {
+        status = sqlite3_bind_blob(statement, sqIndex, blob->data(), (int)blob->size(), SQLITE_STATIC);
+      }
+      break;
+    }
+    }
+
+    if (status != SQLITE_OK)
+    {
+      return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite] Could not bind parameter " + to_string(sqIndex) + ": " + string(sqlite3_errstr(status)),
+      };
+    }
+  }
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+/**
+ * Statements compiled before a schema change would be recompiled on every step, drop them
+ */
+void flushStatementCaches(string const dbName)
+{
+  statementCacheMap[dbName]->clear();
+  if (readerPoolMap.count(dbName) > 0)
+  {
+    readerPoolMap[dbName]->clearStatementCaches();
+  }
+}
+
+/**
+ * Whether the statement can run on a reader connection, it must be a read-only
+ * query returning rows, transaction control and ATTACH/DETACH only look
+ * read-only to SQLite but change the state of the connection they run on
+ */
+bool is_parallel_read(string const &query, sqlite3_stmt *statement)
+{
+  return sqlite3_stmt_readonly(statement) && sqlite3_column_count(statement) > 0 && !isTransactionStatement(query.c_str()) && !isSchemaStatement(query.c_str());
+}
+
+/**
+ * Whether a transaction opened on the writer might still be running, the
+ * readers would not see its uncommitted changes. A writer busy on another
+ * thread counts as one, waiting for it would block the JS thread
+ */
+bool in_writer_transaction(string const &dbName)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return false;
+  }
+  shared_ptr<ConnectionMutex> connectionMutex = connectionMutexMap[dbName];
+  if (!connectionMutex->try_lock())
+  {
+    return true;
+  }
+  bool inTransaction = sqlite3_get_autocommit(dbMap[dbName]) == 0;
+  connectionMutex->unlock();
+  return inTransaction;
+}
+
+SQLiteOPResult sqliteExecute(string const dbName, string const &query, QuickParams *params, QuickResultSet *results, vector<QuickColumnMetadata> *metadata)
+{
+
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+      .rowsAffected = 0
+    };
+  }
+
+  sqlite3 *db = dbMap[dbName];
+  shared_ptr<StatementCache> statementCache = statementCacheMap[dbName];
+  auto connectionMutex = connectionMutexMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutex);
+
+  if (results != NULL)
+  {
+    results->bigInt = bigIntMap[dbName];
+  }
+
+  auto profiler = sqliteGetProfiler(dbName);
+  ProfilerTime prepareStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+  sqlite3_stmt *statement;
+
+  int statementStatus = statementCache->acquire(query, &statement);
+
+  if (statementStatus != SQLITE_OK)
+  {
+    const char *message = sqlite3_errmsg(db);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] SQL execution error: " + string(message),
+      .rowsAffected = 0};
+  }
+
+  // The statement is correct, bind the passed parameters
+  if (statement != NULL)
+  {
+    SQLiteOPResult bindResult = bindStatement(statement, params);
+    if (bindResult.type == SQLiteError)
+    {
+      statementCache->release(query, statement);
+      return bindResult;
+    }
+  }
+
+  if (readerPoolMap.count(dbName) > 0 && statement != NULL)
+  {
+    readerPoolMap[dbName]->setReadOnly(query, is_parallel_read(query, statement));
+  }
+
+  ProfilerTime stepStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+  SQLiteOPResult result = sqliteExecuteStatement(db, statement, results, metadata);
+  if (profiler != nullptr)
+  {
+    record_execution(profiler, query, statement, prepareStart, stepStart, result, results, 1);
+  }
+  statementCache->release(query, statement);
+
+  if (result.type == SQLiteOk && isSchemaStatement(query.c_str()))
+  {
+    flushStatementCaches(dbName);
+  }
+
+  return result;
+}
+
+SQLiteOPResult sqliteExecuteMany(string const dbName, string const &query, vector<QuickParams> *paramSets)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+      .rowsAffected = 0
+    };
+  }
+
+  sqlite3 *db = dbMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutexMap[dbName]);
+  auto statementCache = statementCacheMap[dbName];
+
+  auto profiler = sqliteGetProfiler(dbName);
+  ProfilerTime prepareStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+  sqlite3_stmt *statement;
+  int statementStatus = statementCache->acquire(query, &statement);
+  if (statementStatus != SQLITE_OK)
+  {
+    const char *message = sqlite3_errmsg(db);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] SQL execution error: " + string(message),
+      .rowsAffected = 0};
+  }
+
+  // Blank SQL compiles to no statement, there is nothing to run
+  SQLiteOPResult result = SQLiteOPResult{.type = SQLiteOk, .rowsAffected = 0};
+  if (statement == NULL)
+  {
+    return result;
+  }
+
+  ProfilerTime stepStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+  int rowsAffected = 0;
+  for (auto &params : *paramSets)
+  {
+    // Parameter sets can differ in length, binding clears the values of the previous row
+    result = bindStatement(statement, &params);
+    if (result.type == SQLiteError)
+    {
+      break;
+    }
+    result = sqliteExecuteStatement(db, statement, NULL, NULL);
+    sqlite3_reset(statement);
+    if (result.type == SQLiteError)
+    {
+      break;
+    }
+    rowsAffected += result.rowsAffected;
+  }
+  if (profiler != nullptr)
+  {
+    record_execution(profiler, query, statement, prepareStart, stepStart, result, NULL, (int)paramSets->size());
+  }
+  statementCache->release(query, statement);
+
+  if (result.type == SQLiteOk && isSchemaStatement(query.c_str()))
+  {
+    flushStatementCaches(dbName);
+  }
+
+  result.rowsAffected = rowsAffected;
+  return result;
+}
+
+bool sqliteIsReadQuery(string const dbName, string const &query)
+{
+  if (readerPoolMap.count(dbName) == 0 || in_writer_transaction(dbName))
+  {
+    return false;
+  }
+  return readerPoolMap[dbName]->isReadOnly(query);
+}
+
+SQLiteOPResult sqliteExecuteRead(string const dbName, string const &query, QuickParams *params, QuickResultSet *results, vector<QuickColumnMetadata> *metadata)
+{
+  if (readerPoolMap.count(dbName) == 0)
+  {
+    return sqliteExecute(dbName, query, params, results, metadata);
+  }
+
+  shared_ptr<ReaderPool> readerPool = readerPoolMap[dbName];
+  ReaderConnection *reader = readerPool->acquire();
+  if (results != NULL)
+  {
+    results->bigInt = bigIntMap[dbName];
+  }
+
+  auto profiler = sqliteGetProfiler(dbName);
+  ProfilerTime prepareStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+  sqlite3_stmt *statement;
+  int statementStatus = reader->statementCache->acquire(query, &statement);
+  if (statementStatus != SQLITE_OK || statement == NULL)
+  {
+    // The query might use something only the writer knows about, like a temporary table
+    readerPool->release(reader);
+    readerPool->setReadOnly(query, false);
+    return sqliteExecute(dbName, query, params, results, metadata);
+  }
+
+  ProfilerTime stepStart = profiler != nullptr ? profilerNow() : ProfilerTime();
+  SQLiteOPResult result = bindStatement(statement, params);
+  if (result.type == SQLiteOk)
+  {
+    result = sqliteExecuteStatement(reader->db, statement, results, metadata);
+  }
+  if (profiler != nullptr)
+  {
+    record_execution(profiler, query, statement, prepareStart, stepStart, result, results, 1);
+  }
+  reader->statementCache->release(query, statement);
+  readerPool->release(reader);
+
+  return result;
+}
+
+/**
+ * Append the values of the current row of the statement to the result set
+ */
+void appendStatementRow(sqlite3_stmt *statement, int count, QuickResultSet *results)
+{
+  int i, column_type;
+
+  i = 0;
+  while (i < count)
+  {
+    column_type = sqlite3_column_type(statement, i);
+
+    switch (column_type)
+    {
+
+      case SQLITE_INTEGER:
+      {
+        /**
+         * A JS number can only represent integers up to 53 bits long, by default larger values lose precision.
+         * With the bigInt option they are kept as int64 and sent as a BigInt, smaller ones stay numbers.
+         *
+         * See https://github.com/ospfranco/react-native-quick-sqlite/issues/16 for more context.
+         */
+        sqlite3_int64 column_value = sqlite3_column_int64(statement, i);
+        if (results->bigInt && (column_value > MAX_SAFE_INTEGER || column_value < -MAX_SAFE_INTEGER))
+        {
+          results->cells.push_back(createInt64QuickValue(column_value));
+        }
+        else
+        {
+          results->cells.push_back(createIntegerQuickValue((double)column_value));
+        }
+        break;
+      }
+
+      case SQLITE_FLOAT:
+      {
+        double column_value = sqlite3_column_double(statement, i);
+        results->cells.push_back(createDoubleQuickValue(column_value));
+        break;
+      }
+
+      case SQLITE_TEXT:
+      {
+        const char *column_value = reinterpret_cast<const char *>(sqlite3_column_text(statement, i));
+        int byteLen = sqlite3_column_bytes(statement, i);
+        // Specify length too; in case string contains NULL in the middle (which SQLite supports!)
+        results->cells.push_back(createTextQuickValue(string(column_value, byteLen)));
+        break;
+      }
+
+      case SQLITE_BLOB:
+      {
+        int blob_size = sqlite3_column_bytes(statement, i);
+        const void *blob = sqlite3_column_blob(statement, i);
+        // The column is only valid until the next step, this is the single copy of the blob
+        results->cells.push_back(createArrayBufferQuickValue(make_shared<QuickBlob>(blob, blob_size)));
+        break;
+      }
+
+      case SQLITE_NULL:
+        // Intentionally left blank to switch to default case
+      default:
+        results->cells.push_back(createNullQuickValue());
+        break;
+    }
+    i++;
+  }
+  results->rowCount++;
+}
+
+/**
+ * Reset the column names of the result set to the ones of the statement
+ */
+void readStatementColumnNames(sqlite3_stmt *statement, QuickResultSet *results)
+{
+  int count = sqlite3_column_count(statement);
+  results->columnNames.clear();
+  for (int i = 0; i < count; i++)
+  {
+    results->columnNames.push_back(sqlite3_column_name(statement, i));
+  }
+}
+
+SQLiteOPResult sqliteExecuteStatement(sqlite3 *db, sqlite3_stmt *statement, QuickResultSet *results, vector<QuickColumnMetadata> *metadata)
+{
+  bool isConsuming = true;
+  bool isFailed = false;
+
+  int result, i, count;
+  string column_name, column_declared_type;
+
+  // Column names are stored once for the whole result set, rows only carry the values
+  count = sqlite3_column_count(statement);
+  if (results != NULL)
+  {
+    readStatementColumnNames(statement, results);
+  }
+
+  while (isConsuming)
+  {
+    result = sqlite3_step(statement);
+
+    switch (result)
+    {
+      case SQLITE_ROW:
+        if(results == NULL)
+        {
+          break;
+        }
+
+        appendStatementRow(statement, count, results);
+        break;
+      case SQLITE_DONE:
+        if(metadata != NULL)
+        {
+          i = 0;
+          count = sqlite3_column_count(statement);
+          while (i < count)
+          {
+            column_name = sqlite3_column_name(statement, i);
+            const char *tp = sqlite3_column_decltype(statement, i);
+            column_declared_type = tp != NULL ? tp : "UNKNOWN";
+            QuickColumnMetadata meta = {
+              .colunmName = column_name,
+              .columnIndex = i,
+              .columnDeclaredType = column_declared_type,
+            };
+            metadata->push_back(meta);
+            i++;
+          }
+        }
+        isConsuming = false;
+        break;
+
+      default:
+        isFailed = true;
+        isConsuming = false;
+    }
+  }
+
+  if (isFailed)
+  {
+    const char *message = sqlite3_errmsg(db);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] SQL execution error: " + string(message),
+      .rowsAffected = 0,
+      .insertId = 0
+    };
+  }
+
+  int changedRowCount = sqlite3_changes(db);
+  long long latestInsertRowId = sqlite3_last_insert_rowid(db);
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+    .rowsAffected = changedRowCount,
+    .insertId = static_cast<double>(latestInsertRowId)};
+}
+
+SQLiteOPResult sqlitePrepareStatement(string const dbName, string const &query, shared_ptr<PreparedStatementHandle> *handle)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+    };
+  }
+
+  sqlite3 *db = dbMap[dbName];
+  auto connectionMutex = connectionMutexMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutex);
+  sqlite3_stmt *statement;
+
+  // The statement is expected to be reused many times, let SQLite know to avoid its lookaside memory
+  int statementStatus = sqlite3_prepare_v3(db, query.c_str(), -1, SQLITE_PREPARE_PERSISTENT, &statement, NULL);
+
+  if (statementStatus != SQLITE_OK)
+  {
+    const char *message = sqlite3_errmsg(db);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] SQL execution error: " + string(message),
+    };
+  }
+
+  if (statement == NULL)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] SQL execution error: query does not contain a statement",
+    };
+  }
+
+  *handle = make_shared<PreparedStatementHandle>();
+  (*handle)->db = db;
+  (*handle)->connectionMutex = connectionMutex;
+  (*handle)->statement = statement;
+  (*handle)->bigInt = bigIntMap[dbName];
+
+  // Forget about the statements that were already finalized
+  auto &preparedStatements = preparedStatementMap[dbName];
+  preparedStatements.erase(remove_if(preparedStatements.begin(), preparedStatements.end(), [](weak_ptr<PreparedStatementHandle> &p)
+                                     { return p.expired(); }),
+                           preparedStatements.end());
+  preparedStatements.push_back(*handle);
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+/**
+ * Replace the bindings of the statement, the statement and connection locks must be held
+ */
+SQLiteOPResult bind_prepared_statement(shared_ptr<PreparedStatementHandle> handle, QuickParams *params)
+{
+  sqlite3_reset(handle->statement);
+  // The statement points into the params, they are kept for as long as they are bound
+  handle->params = move(*params);
+  return bindStatement(handle->statement, &handle->params);
+}
+
+SQLiteOPResult sqliteBindPreparedStatement(shared_ptr<PreparedStatementHandle> handle, QuickParams *params)
+{
+  lock_guard<ConnectionMutex> connectionGuard(*handle->connectionMutex);
+  lock_guard<mutex> g(handle->statementMutex);
+  if (handle->statement == NULL)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Statement has been finalized",
+    };
+  }
+
+  return bind_prepared_statement(handle, params);
+}
+
+SQLiteOPResult sqliteExecutePreparedStatement(shared_ptr<PreparedStatementHandle> handle, QuickParams *params, QuickResultSet *results, vector<QuickColumnMetadata> *metadata)
+{
+  lock_guard<ConnectionMutex> connectionGuard(*handle->connectionMutex);
+  lock_guard<mutex> g(handle->statementMutex);
+  if (handle->statement == NULL)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Statement has been finalized",
+    };
+  }
+
+  if (params != NULL)
+  {
+    SQLiteOPResult bindResult = bind_prepared_statement(handle, params);
+    if (bindResult.type == SQLiteError)
+    {
+      return bindResult;
+    }
+  }
+
+  if (results != NULL)
+  {
+    results->bigInt = handle->bigInt;
+  }
+  SQLiteOPResult result = sqliteExecuteStatement(handle->db, handle->statement, results, metadata);
+  // Bindings are kept so the statement can be executed again with the same values
+  sqlite3_reset(handle->statement);
+  return result;
+}
+
+SQLiteOPResult sqliteStepPreparedStatement(shared_ptr<PreparedStatementHandle> handle, size_t maxRows, QuickResultSet *results, bool *done)
+{
+  lock_guard<ConnectionMutex> connectionGuard(*handle->connectionMutex);
+  lock_guard<mutex> g(handle->statementMutex);
+  if (handle->statement == NULL)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Statement has been finalized",
+    };
+  }
+
+  results->bigInt = handle->bigInt;
+  readStatementColumnNames(handle->statement, results);
+  int count = sqlite3_column_count(handle->statement);
+  *done = false;
+
+  while (results->rowCount < maxRows)
+  {
+    int result = sqlite3_step(handle->statement);
+    if (result == SQLITE_ROW)
+    {
+      appendStatementRow(handle->statement, count, results);
+    }
+    else if (result == SQLITE_DONE)
+    {
+      *done = true;
+      // Resetting releases the read lock held by the statement while it was being stepped
+      sqlite3_reset(handle->statement);
+      break;
+    }
+    else
+    {
+      string message = sqlite3_errmsg(handle->db);
+      sqlite3_reset(handle->statement);
+      return SQLiteOPResult{
+        .type = SQLiteError,
+        .errorMessage = "[react-native-quick-sqlite] SQL execution error: " + message,
+      };
+    }
+  }
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
+
+void sqliteFinalizePreparedStatement(shared_ptr<PreparedStatementHandle> handle)
 {
-  string dbPath = get_db_path(dbName, docPath);
-
-  int sqlOpenFlags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX;
-
-  sqlite3 *db;
-  int exit = 0;
-  exit = sqlite3_open_v2(dbPath.c_str(), &db, sqlOpenFlags, nullptr);
-
-  if (exit != SQLITE_OK)
-  {
-    return SQLiteOPResult{
-      .type = SQLiteError,
-      .errorMessage = sqlite3_errmsg(db)
-    };
-  }
-  else
+  lock_guard<ConnectionMutex> connectionGuard(*handle->connectionMutex);
+  lock_guard<mutex> g(handle->statementMutex);
+  if (handle->statement != NULL)
   {
-    dbMap[dbName] = db;
+    sqlite3_finalize(handle->statement);
+    handle->statement = NULL;
+    handle->params.clear();
   }
+}
 
+SQLiteOPResult blob_error(BlobHandle const *handle, int status)
+{
+  // A blob is aborted once its row is changed or deleted by anything but the blob itself
+  string message = status == SQLITE_ABORT ? "the row was changed or deleted, reopen the blob" : sqlite3_errmsg(handle->db);
   return SQLiteOPResult{
-    .type = SQLiteOk,
-    .rowsAffected = 0
+    .type = SQLiteError,
+    .errorMessage = "[react-native-quick-sqlite] Blob error: " + message,
   };
 }
 
-SQLiteOPResult sqliteCloseDb(string const dbName)
+SQLiteOPResult blob_closed_error()
 {
+  return SQLiteOPResult{
+    .type = SQLiteError,
+    .errorMessage = "[react-native-quick-sqlite] Blob has been closed",
+  };
+}
 
+SQLiteOPResult sqliteBlobOpen(string const dbName, string const &database, string const &table, string const &column, long long rowId, bool readOnly, shared_ptr<BlobHandle> *handle)
+{
   if (dbMap.count(dbName) == 0)
   {
     return SQLiteOPResult{
       .type = SQLiteError,
-      .errorMessage = dbName + " is not open",
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
     };
   }
 
   sqlite3 *db = dbMap[dbName];
+  auto connectionMutex = connectionMutexMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutex);
 
-  sqlite3_close(db);
+  sqlite3_blob *blob = NULL;
+  int status = sqlite3_blob_open(db, database.c_str(), table.c_str(), column.c_str(), rowId, readOnly ? 0 : 1, &blob);
+  if (status != SQLITE_OK)
+  {
+    string message = sqlite3_errmsg(db);
+    sqlite3_blob_close(blob);
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Could not open blob: " + message,
+    };
+  }
 
-  dbMap.erase(dbName);
+  *handle = make_shared<BlobHandle>();
+  (*handle)->db = db;
+  (*handle)->connectionMutex = connectionMutex;
+  (*handle)->blob = blob;
+
+  // Forget about the blobs that were already closed
+  auto &blobs = blobMap[dbName];
+  blobs.erase(remove_if(blobs.begin(), blobs.end(), [](weak_ptr<BlobHandle> &b)
+                        { return b.expired(); }),
+              blobs.end());
+  blobs.push_back(*handle);
 
   return SQLiteOPResult{
     .type = SQLiteOk,
   };
 }
 
-SQLiteOPResult sqliteAttachDb(string const mainDBName, string const docPath, string const databaseToAttach, string const alias)
+SQLiteOPResult sqliteBlobReopen(shared_ptr<BlobHandle> handle, long long rowId)
 {
-  /**
-   * There is no need to check if mainDBName is opened because sqliteExecuteLiteral will do that.
-   * */
-  string dbPath = get_db_path(databaseToAttach, docPath);
-  string statement = "ATTACH DATABASE '" + dbPath + "' AS " + alias;
-  SequelLiteralUpdateResult result = sqliteExecuteLiteral(mainDBName, statement);
-  if (result.type == SQLiteError)
+  lock_guard<ConnectionMutex> connectionGuard(*handle->connectionMutex);
+  lock_guard<mutex> g(handle->blobMutex);
+  if (handle->blob == NULL)
+  {
+    return blob_closed_error();
+  }
+
+  int status = sqlite3_blob_reopen(handle->blob, rowId);
+  if (status != SQLITE_OK)
   {
     return SQLiteOPResult{
       .type = SQLiteError,
-      .errorMessage = mainDBName + " was unable to attach another database: " + string(result.message),
+      .errorMessage = "[react-native-quick-sqlite] Could not reopen blob: " + string(sqlite3_errmsg(handle->db)),
     };
   }
   return SQLiteOPResult{
@@ -152,258 +1610,304 @@ SQLiteOPResult sqliteAttachDb(string const mainDBName, string const docPath, str
   };
 }
 
-SQLiteOPResult sqliteDetachDb(string const mainDBName, string const alias)
+SQLiteOPResult sqliteBlobSize(shared_ptr<BlobHandle> handle, int *size)
 {
-  /**
-   * There is no need to check if mainDBName is opened because sqliteExecuteLiteral will do that.
-   * */
-  string statement = "DETACH DATABASE " + alias;
-  SequelLiteralUpdateResult result = sqliteExecuteLiteral(mainDBName, statement);
-  if (result.type == SQLiteError)
+  lock_guard<mutex> g(handle->blobMutex);
+  if (handle->blob == NULL)
   {
-    return SQLiteOPResult{
-      .type = SQLiteError,
-      .errorMessage = mainDBName + "was unable to detach database: " + string(result.message),
-    };
+    return blob_closed_error();
   }
+
+  *size = sqlite3_blob_bytes(handle->blob);
   return SQLiteOPResult{
     .type = SQLiteOk,
   };
 }
 
-SQLiteOPResult sqliteRemoveDb(string const dbName, string const docPath)
+SQLiteOPResult sqliteBlobRead(shared_ptr<BlobHandle> handle, uint8_t *target, int length, int offset)
 {
-  if (dbMap.count(dbName) == 1)
+  lock_guard<ConnectionMutex> connectionGuard(*handle->connectionMutex);
+  lock_guard<mutex> g(handle->blobMutex);
+  if (handle->blob == NULL)
   {
-    SQLiteOPResult closeResult = sqliteCloseDb(dbName);
-    if (closeResult.type == SQLiteError)
-    {
-      return closeResult;
-    }
+    return blob_closed_error();
   }
 
-  string dbPath = get_db_path(dbName, docPath);
-
-  if (!file_exists(dbPath))
+  int status = sqlite3_blob_read(handle->blob, target, length, offset);
+  if (status != SQLITE_OK)
   {
-    return SQLiteOPResult{
-      .type = SQLiteOk,
-      .errorMessage = "[react-native-quick-sqlite]: Database file not found" + dbPath
-    };
+    return blob_error(handle.get(), status);
   }
-
-  remove(dbPath.c_str());
-
   return SQLiteOPResult{
     .type = SQLiteOk,
+    .rowsAffected = length,
   };
 }
 
-void bindStatement(sqlite3_stmt *statement, vector<QuickValue> *values)
+SQLiteOPResult sqliteBlobWrite(shared_ptr<BlobHandle> handle, const uint8_t *source, int length, int offset)
 {
-  size_t size = values->size();
-  if (size <= 0)
+  lock_guard<ConnectionMutex> connectionGuard(*handle->connectionMutex);
+  lock_guard<mutex> g(handle->blobMutex);
+  if (handle->blob == NULL)
   {
-    return;
+    return blob_closed_error();
   }
 
-  for (int ii = 0; ii < size; ii++)
+  int status = sqlite3_blob_write(handle->blob, source, length, offset);
+  if (status != SQLITE_OK)
   {
-    int sqIndex = ii + 1;
-    QuickValue value = values->at(ii);
-    QuickDataType dataType = value.dataType;
-    if (dataType == NULL_VALUE)
-    {
-      sqlite3_bind_null(statement, sqIndex);
-    }
-    else if (dataType == BOOLEAN)
-    {
-      sqlite3_bind_int(statement, sqIndex, value.booleanValue);
-    }
-    else if (dataType == INTEGER)
-    {
-      sqlite3_bind_int(statement, sqIndex, (int)value.doubleOrIntValue);
-    }
-    else if (dataType == DOUBLE)
-    {
-      sqlite3_bind_double(statement, sqIndex, value.doubleOrIntValue);
-    }
-    else if (dataType == INT64)
-    {
-      sqlite3_bind_int64(statement, sqIndex, value.int64Value);
-    }
-    else if (dataType == TEXT)
-    {
-      sqlite3_bind_text(statement, sqIndex, value.textValue.c_str(), value.textValue.length(), SQLITE_TRANSIENT);
-    }
-    else if (dataType == ARRAY_BUFFER)
-    {
-      sqlite3_bind_blob(statement, sqIndex, value.arrayBufferValue.get(), value.arrayBufferSize, SQLITE_STATIC);
-    }
+    return blob_error(handle.get(), status);
+  }
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+    .rowsAffected = length,
+  };
+}
+
+void sqliteBlobClose(shared_ptr<BlobHandle> handle)
+{
+  lock_guard<ConnectionMutex> connectionGuard(*handle->connectionMutex);
+  lock_guard<mutex> g(handle->blobMutex);
+  if (handle->blob != NULL)
+  {
+    sqlite3_blob_close(handle->blob);
+    handle->blob = NULL;
   }
 }
 
-SQLiteOPResult sqliteExecute(string const dbName, string const &query, vector<QuickValue> *params, vector<map<string, QuickValue>> *results, vector<QuickColumnMetadata> *metadata)
+SQLiteOPResult session_closed_error()
 {
+  return SQLiteOPResult{
+    .type = SQLiteError,
+    .errorMessage = "[react-native-quick-sqlite] Session has been closed",
+  };
+}
 
+#ifdef SQLITE_ENABLE_SESSION
+
+SQLiteOPResult sqliteSessionCreate(string const dbName, string const &database, vector<string> const &tables, shared_ptr<SessionHandle> *handle)
+{
   if (dbMap.count(dbName) == 0)
   {
     return SQLiteOPResult{
       .type = SQLiteError,
       .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
-      .rowsAffected = 0
     };
   }
 
   sqlite3 *db = dbMap[dbName];
+  auto connectionMutex = connectionMutexMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutex);
 
-  sqlite3_stmt *statement;
+  sqlite3_session *session = NULL;
+  int status = sqlite3session_create(db, database.c_str(), &session);
+  if (status == SQLITE_OK)
+  {
+    if (tables.empty())
+    {
+      status = sqlite3session_attach(session, NULL);
+    }
+    for (auto &table : tables)
+    {
+      status = sqlite3session_attach(session, table.c_str());
+      if (status != SQLITE_OK)
+      {
+        break;
+      }
+    }
+  }
+  if (status != SQLITE_OK)
+  {
+    if (session != NULL)
+    {
+      sqlite3session_delete(session);
+    }
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite] Could not create session: " + string(sqlite3_errstr(status)),
+    };
+  }
 
-  int statementStatus = sqlite3_prepare_v2(db, query.c_str(), -1, &statement, NULL);
+  *handle = make_shared<SessionHandle>();
+  (*handle)->db = db;
+  (*handle)->connectionMutex = connectionMutex;
+  (*handle)->session = session;
+
+  // Forget about the sessions that were already closed
+  auto &sessions = sessionMap[dbName];
+  sessions.erase(remove_if(sessions.begin(), sessions.end(), [](weak_ptr<SessionHandle> &s)
+                           { return s.expired(); }),
+                 sessions.end());
+  sessions.push_back(*handle);
+
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
 
-  if (statementStatus == SQLITE_OK) // statemnet is correct, bind the passed parameters
+SQLiteOPResult sqliteSessionChangeset(shared_ptr<SessionHandle> handle, shared_ptr<QuickBlob> *changeset)
+{
+  lock_guard<ConnectionMutex> g(*handle->connectionMutex);
+  if (handle->session == NULL)
   {
-    bindStatement(statement, params);
+    return session_closed_error();
   }
-  else
+
+  int size = 0;
+  void *data = NULL;
+  int status = sqlite3session_changeset(handle->session, &size, &data);
+  if (status != SQLITE_OK)
   {
-    const char *message = sqlite3_errmsg(db);
+    sqlite3_free(data);
     return SQLiteOPResult{
       .type = SQLiteError,
-      .errorMessage = "[react-native-quick-sqlite] SQL execution error: " + string(message),
-      .rowsAffected = 0};
+      .errorMessage = "[react-native-quick-sqlite] Could not create changeset: " + string(sqlite3_errstr(status)),
+    };
   }
 
-  bool isConsuming = true;
-  bool isFailed = false;
-
-  int result, i, count, column_type;
-  string column_name, column_declared_type;
-  map<string, QuickValue> row;
+  *changeset = make_shared<QuickBlob>(data, (size_t)size);
+  sqlite3_free(data);
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
 
-  while (isConsuming)
+SQLiteOPResult sqliteSessionIsEmpty(shared_ptr<SessionHandle> handle, bool *isEmpty)
+{
+  lock_guard<ConnectionMutex> g(*handle->connectionMutex);
+  if (handle->session == NULL)
   {
-    result = sqlite3_step(statement);
+    return session_closed_error();
+  }
 
-    switch (result)
-    {
-      case SQLITE_ROW:
-        if(results == NULL)
-        {
-          break;
-        }
+  *isEmpty = sqlite3session_isempty(handle->session) != 0;
+  return SQLiteOPResult{
+    .type = SQLiteOk,
+  };
+}
 
-        i = 0;
-        row = map<string, QuickValue>();
-        count = sqlite3_column_count(statement);
+void sqliteSessionClose(shared_ptr<SessionHandle> handle)
+{
+  lock_guard<ConnectionMutex> g(*handle->connectionMutex);
+  if (handle->session != NULL)
+  {
+    sqlite3session_delete(handle->session);
+    handle->session = NULL;
+  }
+}
 
-        while (i < count)
-        {
-          column_type = sqlite3_column_type(statement, i);
-          column_name = sqlite3_column_name(statement, i);
+struct ChangesetConflictContext
+{
+  ChangesetConflictPolicy policy;
+  int conflicts;
+};
 
-          switch (column_type)
-          {
+int on_changeset_conflict(void *context, int conflict, sqlite3_changeset_iter *iterator)
+{
+  auto conflictContext = (ChangesetConflictContext *)context;
+  conflictContext->conflicts++;
+  switch (conflictContext->policy)
+  {
+  case CONFLICT_ABORT:
+    return SQLITE_CHANGESET_ABORT;
+  case CONFLICT_OMIT:
+    return SQLITE_CHANGESET_OMIT;
+  case CONFLICT_REPLACE:
+    // Only a row that exists with other values can be replaced
+    return conflict == SQLITE_CHANGESET_DATA || conflict == SQLITE_CHANGESET_CONFLICT ? SQLITE_CHANGESET_REPLACE : SQLITE_CHANGESET_OMIT;
+  }
+  return SQLITE_CHANGESET_ABORT;
+}
 
-            case SQLITE_INTEGER:
-            {
-              /**
-               * It's not possible to send a int64_t in a jsi::Value because JS cannot represent the whole number range.
-               * Instead, we're sending a double, which can represent all integers up to 53 bits long, which is more
-               * than what was there before (a 32-bit int).
-               *
-               * See https://github.com/ospfranco/react-native-quick-sqlite/issues/16 for more context.
-               */
-              double column_value = sqlite3_column_double(statement, i);
-              row[column_name] = createIntegerQuickValue(column_value);
-              break;
-            }
-
-            case SQLITE_FLOAT:
-            {
-              double column_value = sqlite3_column_double(statement, i);
-              row[column_name] = createDoubleQuickValue(column_value);
-              break;
-            }
-
-            case SQLITE_TEXT:
-            {
-              const char *column_value = reinterpret_cast<const char *>(sqlite3_column_text(statement, i));
-              int byteLen = sqlite3_column_bytes(statement, i);
-              // Specify length too; in case string contains NULL in the middle (which SQLite supports!)
-              row[column_name] = createTextQuickValue(string(column_value, byteLen));
-              break;
-            }
-
-            case SQLITE_BLOB:
-            {
-              int blob_size = sqlite3_column_bytes(statement, i);
-              const void *blob = sqlite3_column_blob(statement, i);
-              uint8_t *data;
-              memcpy(data, blob, blob_size);
-              row[column_name] = createArrayBufferQuickValue(data, blob_size);
-              break;
-            }
-
-            case SQLITE_NULL:
-              // Intentionally left blank to switch to default case
-            default:
-              row[column_name] = createNullQuickValue();
-              break;
-          }
-          i++;
-        }
-        results->push_back(move(row));
-        break;
-      case SQLITE_DONE:
-        if(metadata != NULL)
-        {
-          i = 0;
-          count = sqlite3_column_count(statement);
-          while (i < count)
-          {
-            column_name = sqlite3_column_name(statement, i);
-            const char *tp = sqlite3_column_decltype(statement, i);
-            column_declared_type = tp != NULL ? tp : "UNKNOWN";
-            QuickColumnMetadata meta = {
-              .colunmName = column_name,
-              .columnIndex = i,
-              .columnDeclaredType = column_declared_type,
-            };
-            metadata->push_back(meta);
-            i++;
-          }
-        }
-        isConsuming = false;
-        break;
+SQLiteOPResult sqliteApplyChangeset(string const dbName, shared_ptr<QuickBlob> changeset, ChangesetConflictPolicy policy, int *conflicts)
+{
+  if (dbMap.count(dbName) == 0)
+  {
+    return SQLiteOPResult{
+      .type = SQLiteError,
+      .errorMessage = "[react-native-quick-sqlite]: Database " + dbName + " is not open",
+    };
+  }
 
-      default:
-        isFailed = true;
-        isConsuming = false;
+  sqlite3 *db = dbMap[dbName];
+  auto connectionMutex = connectionMutexMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutex);
+
+  // Paused while the changeset is applied, as the sessions would record it
+  vector<sqlite3_session *> pausedSessions;
+  for (auto &session : sessionMap[dbName])
+  {
+    auto handle = session.lock();
+    if (handle != nullptr && handle->session != NULL && sqlite3session_enable(handle->session, -1))
+    {
+      sqlite3session_enable(handle->session, 0);
+      pausedSessions.push_back(handle->session);
     }
   }
 
-  sqlite3_finalize(statement);
+  ChangesetConflictContext context = {policy, 0};
+  const int changesBefore = sqlite3_total_changes(db);
+  int status = sqlite3changeset_apply(db, (int)changeset->size(), changeset->data(), NULL, on_changeset_conflict, &context);
+  const int rowsAffected = sqlite3_total_changes(db) - changesBefore;
 
-  if (isFailed)
+  for (auto session : pausedSessions)
   {
-    const char *message = sqlite3_errmsg(db);
+    sqlite3session_enable(session, 1);
+  }
+
+  *conflicts = context.conflicts;
+  if (status != SQLITE_OK)
+  {
+    string message = status == SQLITE_ABORT && context.conflicts > 0 ? "the changeset conflicts with the rows of the database" : sqlite3_errmsg(db);
     return SQLiteOPResult{
       .type = SQLiteError,
-      .errorMessage = "[react-native-quick-sqlite] SQL execution error: " + string(message),
-      .rowsAffected = 0,
-      .insertId = 0
+      .errorMessage = "[react-native-quick-sqlite] Could not apply changeset: " + message,
     };
   }
-
-  int changedRowCount = sqlite3_changes(db);
-  long long latestInsertRowId = sqlite3_last_insert_rowid(db);
   return SQLiteOPResult{
     .type = SQLiteOk,
-    .rowsAffected = changedRowCount,
-    .insertId = static_cast<double>(latestInsertRowId)};
+    .rowsAffected = rowsAffected,
+  };
+}
+
+#else
+
+// Built against a SQLite without the session extension, like the one of the OS
+
+SQLiteOPResult session_unavailable_error()
+{
+  return SQLiteOPResult{
+    .type = SQLiteError,
+    .errorMessage = "[react-native-quick-sqlite] Sessions need SQLite built with SQLITE_ENABLE_SESSION",
+  };
+}
+
+SQLiteOPResult sqliteSessionCreate(string const dbName, string const &database, vector<string> const &tables, shared_ptr<SessionHandle> *handle)
+{
+  return session_unavailable_error();
+}
+
+SQLiteOPResult sqliteSessionChangeset(shared_ptr<SessionHandle> handle, shared_ptr<QuickBlob> *changeset)
+{
+  return session_closed_error();
+}
+
+SQLiteOPResult sqliteSessionIsEmpty(shared_ptr<SessionHandle> handle, bool *isEmpty)
+{
+  return session_closed_error();
+}
+
+void sqliteSessionClose(shared_ptr<SessionHandle> handle)
+{
+}
+
+SQLiteOPResult sqliteApplyChangeset(string const dbName, shared_ptr<QuickBlob> changeset, ChangesetConflictPolicy policy, int *conflicts)
+{
+  return session_unavailable_error();
 }
 
+#endif
+
 SequelLiteralUpdateResult sqliteExecuteLiteral(string const dbName, string const &query)
 {
   // Check if db connection is opened
@@ -417,12 +1921,14 @@ SequelLiteralUpdateResult sqliteExecuteLiteral(string const dbName, string const
   }
 
   sqlite3 *db = dbMap[dbName];
+  shared_ptr<StatementCache> statementCache = statementCacheMap[dbName];
+  auto connectionMutex = connectionMutexMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutex);
 
-  // SQLite statements need to be compiled before executed
+  // SQLite statements need to be compiled before executed, reuse the cached one if any
   sqlite3_stmt *statement;
 
-  // Compile and move result into statement memory spot
-  int statementStatus = sqlite3_prepare_v2(db, query.c_str(), -1, &statement, NULL);
+  int statementStatus = statementCache->acquire(query, &statement);
 
   if (statementStatus != SQLITE_OK) // statemnet is correct, bind the passed parameters
   {
@@ -459,11 +1965,10 @@ SequelLiteralUpdateResult sqliteExecuteLiteral(string const dbName, string const
     }
   }
 
-  sqlite3_finalize(statement);
-
   if (isFailed)
   {
-    const char *message = sqlite3_errmsg(db);
+    string message = sqlite3_errmsg(db);
+    statementCache->release(query, statement);
     return {
       SQLiteError,
       "[react-native-quick-sqlite] SQL execution error: " + string(message),
@@ -471,6 +1976,11 @@ SequelLiteralUpdateResult sqliteExecuteLiteral(string const dbName, string const
   }
 
   int changedRowCount = sqlite3_changes(db);
+  statementCache->release(query, statement);
+  if (isSchemaStatement(query.c_str()))
+  {
+    flushStatementCaches(dbName);
+  }
   return {
     SQLiteOk,
     "",
@@ -500,10 +2010,18 @@ SQLiteFunctionResult sqliteCustomFunction(
     }
 
     sqlite3 *db = dbMap[dbName];
+    lock_guard<ConnectionMutex> g(*connectionMutexMap[dbName]);
     const char *cstr = name.c_str();
 
     exit = sqlite3_create_function_v2(db, cstr, nArgs, createSQLiteFunctionOptions(DETERMINISTIC, DIRECTONLY, INNOCUOUS, SUBTYPE), new CustomFunction(rt, name, callback), CustomFunction::xFunc, NULL, NULL, CustomFunction::xDestroy);
 
+    if (exit == SQLITE_OK && readerPoolMap.count(dbName) > 0)
+    {
+      readerPoolMap[dbName]->forEachConnection([&](ReaderConnection *connection)
+                                               {
+        sqlite3_create_function_v2(connection->db, cstr, nArgs, createSQLiteFunctionOptions(DETERMINISTIC, DIRECTONLY, INNOCUOUS, SUBTYPE), new CustomFunction(rt, name, callback), CustomFunction::xFunc, NULL, NULL, CustomFunction::xDestroy); });
+    }
+
     if (exit != SQLITE_OK)
     {
         return SQLiteFunctionResult{
@@ -532,7 +2050,8 @@ SQLiteFunctionResult sqliteCustomAggregate(
                                         const bool resultIsFunction,
                                         const std::shared_ptr<jsi::Function> start,
                                         const std::shared_ptr<jsi::Function> inverse,
-                                        const std::shared_ptr<jsi::Function> result
+                                        const std::shared_ptr<jsi::Function> result,
+                                        const int batchSize
                                         )
 {
   int exit = 0;
@@ -546,12 +2065,20 @@ SQLiteFunctionResult sqliteCustomAggregate(
   }
 
   sqlite3 *db = dbMap[dbName];
+  lock_guard<ConnectionMutex> g(*connectionMutexMap[dbName]);
   const char *cstr = name.c_str();
 
   auto xInverse = inverseIsFunction ? CustomAggregate::xInverse : NULL;
   auto xValue = xInverse ? CustomAggregate::xValue : NULL;
     
-  exit = sqlite3_create_window_function(db, cstr, nArgs, createSQLiteFunctionOptions(DETERMINISTIC, DIRECTONLY, INNOCUOUS, SUBTYPE), new CustomAggregate(rt, name, step, startIsFunction, inverseIsFunction, resultIsFunction, start, inverse, result), CustomAggregate::xStep, CustomAggregate::xFinal, move(xValue), move(xInverse), CustomFunction::xDestroy);
+  exit = sqlite3_create_window_function(db, cstr, nArgs, createSQLiteFunctionOptions(DETERMINISTIC, DIRECTONLY, INNOCUOUS, SUBTYPE), new CustomAggregate(rt, name, step, startIsFunction, inverseIsFunction, resultIsFunction, start, inverse, result, batchSize), CustomAggregate::xStep, CustomAggregate::xFinal, xValue, xInverse, CustomFunction::xDestroy);
+
+  if (exit == SQLITE_OK && readerPoolMap.count(dbName) > 0)
+  {
+    readerPoolMap[dbName]->forEachConnection([&](ReaderConnection *connection)
+                                             {
+      sqlite3_create_window_function(connection->db, cstr, nArgs, createSQLiteFunctionOptions(DETERMINISTIC, DIRECTONLY, INNOCUOUS, SUBTYPE), new CustomAggregate(rt, name, step, startIsFunction, inverseIsFunction, resultIsFunction, start, inverse, result, batchSize), CustomAggregate::xStep, CustomAggregate::xFinal, xValue, xInverse, CustomFunction::xDestroy); });
+  }
 
     if (exit != SQLITE_OK)
     {
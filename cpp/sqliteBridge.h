@@ -7,23 +7,290 @@
  * This code is licensed under the MIT license
  */
 
+#ifndef sqliteBridge_h
+#define sqliteBridge_h
+
 #include "JSIHelper.h"
+#include "ConnectionMutex.h"
+#include "ChangeTracker.h"
+#include "QueryProfiler.h"
 #include <vector>
+#include <set>
+#include <mutex>
+#include <sqlite3.h>
 
 using namespace std;
 using namespace facebook;
 
-SQLiteOPResult sqliteOpenDb(string const dbName, string const docPath);
+/**
+ * A statement prepared from JS, it stays alive until it is finalized or its database is closed
+ */
+struct PreparedStatementHandle
+{
+  sqlite3 *db;
+  shared_ptr<ConnectionMutex> connectionMutex;
+  sqlite3_stmt *statement;
+  // Guards the statement against concurrent execution from the JS thread and the workers
+  mutex statementMutex;
+  // Values currently bound to the statement
+  QuickParams params;
+  // Rows read from the statement return large integers as BigInt
+  bool bigInt;
+};
+
+/**
+ * Blob opened for incremental I/O, it stays open until it is closed or its database is closed
+ */
+struct BlobHandle
+{
+  sqlite3 *db;
+  shared_ptr<ConnectionMutex> connectionMutex;
+  sqlite3_blob *blob;
+  // Guards the blob against concurrent use from the JS thread and the workers
+  mutex blobMutex;
+};
+
+/**
+ * Session recording the changes made through the main connection, it stays open until it is closed or its database is closed
+ */
+struct SessionHandle
+{
+  sqlite3 *db;
+  shared_ptr<ConnectionMutex> connectionMutex;
+  // Only used with the connection locked, NULL once closed. Declared by sqlite3.h with SQLITE_ENABLE_SESSION only
+  struct sqlite3_session *session;
+};
+
+/**
+ * What applying a changeset does with a change that conflicts with the rows of the database
+ */
+enum ChangesetConflictPolicy
+{
+  // The whole changeset is rolled back
+  CONFLICT_ABORT,
+  // The change is skipped
+  CONFLICT_OMIT,
+  // The change overwrites the row, a change of a missing row or one failing a constraint is skipped
+  CONFLICT_REPLACE,
+};
+
+/**
+ * sqlite3_db_status of a database, summed over the writer and the reader connections
+ */
+struct SQLiteDbStatus
+{
+  // Bytes of the page cache
+  long long cacheUsed;
+  long long cacheHit;
+  long long cacheMiss;
+  long long cacheWrite;
+  long long cacheSpill;
+  // Bytes used by the schema and by the prepared statements
+  long long schemaUsed;
+  long long statementUsed;
+  long long lookasideUsed;
+};
+
+/**
+ * sqlite3_status64 of the whole process, shared by every database
+ */
+struct SQLiteMemoryStatus
+{
+  long long memoryUsed;
+  long long memoryHighwater;
+  long long softHeapLimit;
+};
+
+/**
+ * Bundled database opened in place through its URI
+ */
+struct SQLiteAsset
+{
+  string uri;
+  long long mmapSize;
+};
+
+/**
+ * Online backup of an open database into another file, copied a few pages at a time
+ */
+struct BackupHandle
+{
+  shared_ptr<ConnectionMutex> connectionMutex;
+  sqlite3 *destination;
+  sqlite3_backup *backup;
+  int remainingPages;
+  int totalPages;
+};
+
+SQLiteOPResult sqliteOpenDb(string const dbName, string const docPath, SQLiteOpenOptions const &options);
 
 SQLiteOPResult sqliteCloseDb(string const dbName);
 
+/**
+ * Stops the statements running on the connections of the database, they fail with an interrupted error.
+ * Queued async queries run normally. MAY be called while a worker holds the connection
+ */
+SQLiteOPResult sqliteInterrupt(string const dbName);
+
+/**
+ * Options SQLite was compiled with, includes the SQLITE_FLAGS passed to the build, without the SQLITE_ prefix
+ */
+vector<string> sqliteCompileOptions();
+
 SQLiteOPResult sqliteRemoveDb(string const dbName, string const docPath);
 
+/**
+ * Mutex serializing every use of the connection, hold it to run several statements without
+ * anything else interleaving. Returns nullptr if the database is not open
+ */
+shared_ptr<ConnectionMutex> sqliteGetConnectionMutex(string const dbName);
+
+/**
+ * Sets the function called with the rows changed by every transaction committed on the writer,
+ * nullptr stops tracking the changes. See ChangeTracker::setListener
+ */
+SQLiteOPResult sqliteSetChangeListener(string const dbName, function<void(ChangeSet const &)> listener);
+
+/**
+ * Memory held by the connections of the database, resetCounters restarts the cache hit, miss, write and spill counts
+ */
+SQLiteOPResult sqliteDbStatus(string const dbName, bool resetCounters, SQLiteDbStatus *status);
+
+SQLiteMemoryStatus sqliteMemoryStatus(bool resetHighwater);
+
+/**
+ * Frees the unused pages of the caches of every connection of the database, returns the bytes freed.
+ * Blocks until the connections are idle
+ */
+long long sqliteReleaseMemory(string const dbName);
+
+/**
+ * Names of the open databases, MUST be called in the JavaScript Thread
+ */
+vector<string> sqliteOpenDatabases();
+
+/**
+ * Caches start freeing their pages once everything SQLite allocated exceeds limit bytes, 0 removes the limit.
+ * Returns the previous limit
+ */
+long long sqliteSetSoftHeapLimit(long long limit);
+
+/**
+ * Stats of the executions of a database opened with the profile option, nullptr otherwise
+ */
+shared_ptr<QueryProfiler> sqliteGetProfiler(string const dbName);
+
+/**
+ * Calls listener with the SQL and duration of every statement run on the writer and the readers,
+ * from the thread that ran it. nullptr removes the listener
+ */
+SQLiteOPResult sqliteSetTraceListener(string const dbName, function<void(string const &, double)> listener);
+
+/**
+ * Lowercase names of the tables the query reads from, views are resolved to their tables
+ */
+SQLiteOPResult sqliteReadTables(string const dbName, string const &query, set<string> *tables);
+
+/**
+ * Open the destination file and start copying the main database of dbName into it
+ */
+SQLiteOPResult sqliteBackupInit(string const dbName, string const &destinationPath, shared_ptr<BackupHandle> *handle);
+
+/**
+ * Copy up to pages pages (-1 for all of them) while holding the connection, done is set once the copy is complete.
+ * Writes to the source in between are picked up by the following steps
+ */
+SQLiteOPResult sqliteBackupStep(shared_ptr<BackupHandle> handle, int pages, bool *done);
+
+/**
+ * Release the backup and close the destination, must be called once the backup is done or failed
+ */
+SQLiteOPResult sqliteBackupFinish(shared_ptr<BackupHandle> handle);
+
 SQLiteOPResult sqliteAttachDb(string const mainDBName, string const docPath, string const databaseToAttach, string const alias);
 
 SQLiteOPResult sqliteDetachDb(string const mainDBName, string const alias);
 
-SQLiteOPResult sqliteExecute(string const dbName, string const &query, vector<QuickValue> *values, vector<map<string, QuickValue>> *result, vector<QuickColumnMetadata> *metadata);
+SQLiteOPResult sqliteExecute(string const dbName, string const &query, QuickParams *params, QuickResultSet *results, vector<QuickColumnMetadata> *metadata);
+
+/**
+ * Execute the same query once for every parameter set, it is prepared (or taken from the cache) only once.
+ * Rows are not read, rowsAffected is the total of all runs
+ */
+SQLiteOPResult sqliteExecuteMany(string const dbName, string const &query, vector<QuickParams> *paramSets);
+
+/**
+ * Whether the query is known to be read-only and the database has reader connections to run it on
+ */
+bool sqliteIsReadQuery(string const dbName, string const &query);
+
+/**
+ * Execute a read-only query on an idle reader connection, blocks until one is available
+ */
+SQLiteOPResult sqliteExecuteRead(string const dbName, string const &query, QuickParams *params, QuickResultSet *results, vector<QuickColumnMetadata> *metadata);
+
+SQLiteOPResult sqliteExecuteStatement(sqlite3 *db, sqlite3_stmt *statement, QuickResultSet *results, vector<QuickColumnMetadata> *metadata);
+
+/**
+ * Binds positional and named parameters, text and blobs are not copied so params must outlive the execution
+ */
+SQLiteOPResult bindStatement(sqlite3_stmt *statement, QuickParams const *params);
+
+SQLiteOPResult sqlitePrepareStatement(string const dbName, string const &query, shared_ptr<PreparedStatementHandle> *handle);
+
+SQLiteOPResult sqliteBindPreparedStatement(shared_ptr<PreparedStatementHandle> handle, QuickParams *params);
+
+/**
+ * Bind the params and execute the statement under one lock, NULL params keep the current bindings
+ */
+SQLiteOPResult sqliteExecutePreparedStatement(shared_ptr<PreparedStatementHandle> handle, QuickParams *params, QuickResultSet *results, vector<QuickColumnMetadata> *metadata);
+
+/**
+ * Step the statement until maxRows rows have been read or it is done, the statement keeps its position between calls
+ */
+SQLiteOPResult sqliteStepPreparedStatement(shared_ptr<PreparedStatementHandle> handle, size_t maxRows, QuickResultSet *results, bool *done);
+
+void sqliteFinalizePreparedStatement(shared_ptr<PreparedStatementHandle> handle);
+
+/**
+ * Opens the blob of a row for reads and writes in place, database is the schema name, main or an attached alias.
+ * Writes can't change the size of the blob, zeroblob(n) creates one of the final size
+ */
+SQLiteOPResult sqliteBlobOpen(string const dbName, string const &database, string const &table, string const &column, long long rowId, bool readOnly, shared_ptr<BlobHandle> *handle);
+
+/**
+ * Points the blob to the same column of another row, cheaper than opening a new one
+ */
+SQLiteOPResult sqliteBlobReopen(shared_ptr<BlobHandle> handle, long long rowId);
+
+SQLiteOPResult sqliteBlobSize(shared_ptr<BlobHandle> handle, int *size);
+
+SQLiteOPResult sqliteBlobRead(shared_ptr<BlobHandle> handle, uint8_t *target, int length, int offset);
+
+SQLiteOPResult sqliteBlobWrite(shared_ptr<BlobHandle> handle, const uint8_t *source, int length, int offset);
+
+void sqliteBlobClose(shared_ptr<BlobHandle> handle);
+
+/**
+ * Starts recording the changes of the tables of a schema, of every table when tables is empty.
+ * Only tables with a PRIMARY KEY are recorded
+ */
+SQLiteOPResult sqliteSessionCreate(string const dbName, string const &database, vector<string> const &tables, shared_ptr<SessionHandle> *handle);
+
+/**
+ * The changes recorded so far, with a row changed many times reported once with its net change
+ */
+SQLiteOPResult sqliteSessionChangeset(shared_ptr<SessionHandle> handle, shared_ptr<QuickBlob> *changeset);
+
+SQLiteOPResult sqliteSessionIsEmpty(shared_ptr<SessionHandle> handle, bool *isEmpty);
+
+void sqliteSessionClose(shared_ptr<SessionHandle> handle);
+
+/**
+ * Applies a changeset in a savepoint on the main connection, rowsAffected counts the rows written.
+ * The open sessions of the database don't record it, a change that was received is not sent back
+ */
+SQLiteOPResult sqliteApplyChangeset(string const dbName, shared_ptr<QuickBlob> changeset, ChangesetConflictPolicy policy, int *conflicts);
 
 SequelLiteralUpdateResult sqliteExecuteLiteral(string const dbName, string const &query);
 
@@ -53,5 +320,8 @@ SQLiteFunctionResult sqliteCustomAggregate(
                                            const bool resultIsFunction,
                                            const std::shared_ptr<jsi::Function> start,
                                            const std::shared_ptr<jsi::Function> inverse,
-                                           const std::shared_ptr<jsi::Function> result
+                                           const std::shared_ptr<jsi::Function> result,
+                                           const int batchSize = 0
                                         );
+
+#endif /* sqliteBridge_h */
@@ -2,14 +2,37 @@ import React, {useEffect, useState} from 'react';
 import {SafeAreaView, ScrollView, Text} from 'react-native';
 import 'reflect-metadata';
 import {registerBaseTests, registerAggregateTests, runTests} from './tests';
+import {BenchmarkReport, runBenchmarks} from './benchmarks';
+
+// Printed before the JSON report so it can be picked out of the device logs
+const BENCHMARK_LOG_PREFIX = 'QUICK_SQLITE_BENCHMARK';
+// Absolute path of src/tests/fixtures on the device, the iOS simulator can use the one of the checkout
+const FIXTURES_PATH: string | undefined = undefined;
 
 export default function App() {
   const [results, setResults] = useState<any>([]);
+  const [benchmark, setBenchmark] = useState<BenchmarkReport | null>(null);
+  const [isBenchmarking, setIsBenchmarking] = useState(false);
+
+  const startBenchmarks = () => {
+    if (isBenchmarking) {
+      return;
+    }
+    setIsBenchmarking(true);
+    setBenchmark(null);
+    runBenchmarks()
+      .then(report => {
+        console.log(`${BENCHMARK_LOG_PREFIX} ${JSON.stringify(report)}`);
+        setBenchmark(report);
+      })
+      .catch(e => console.warn(`Benchmarks failed: ${e.message}`))
+      .finally(() => setIsBenchmarking(false));
+  };
 
   useEffect(() => {
     setResults([]);
     runTests(
-      registerBaseTests,
+      () => registerBaseTests({fixturesPath: FIXTURES_PATH}),
       registerAggregateTests
       // registerTypeORMTests
     ).then(setResults);
@@ -21,6 +44,17 @@ export default function App() {
         <Text className="font-bold text-blue-500 text-lg text-center">
           RN Quick SQLite Test Suite
         </Text>
+        <Text
+          className="mt-2 text-blue-300 text-center"
+          onPress={startBenchmarks}>
+          {isBenchmarking ? 'Running benchmarks...' : 'Run benchmarks'}
+        </Text>
+        {benchmark?.results.map(r => (
+          <Text key={r.name} className="mt-1 text-white">
+            ⏱ {r.name}: mean {r.meanMs.toFixed(2)} ms, p95{' '}
+            {r.p95Ms.toFixed(2)} ms
+          </Text>
+        ))}
         {results.map((r: any, i: number) => {
           if (r.type === 'grouping') {
             return (
@@ -0,0 +1,106 @@
+import {Platform} from 'react-native';
+
+const pak = require('../../../package.json');
+
+/**
+ * Same shape as the report written by the native benchmark in /benchmark,
+ * so device and native runs of every release can be compared with one script
+ */
+export type BenchmarkResult = {
+  name: string;
+  iterations: number;
+  rows: number;
+  totalMs: number;
+  meanMs: number;
+  minMs: number;
+  p50Ms: number;
+  p95Ms: number;
+  maxMs: number;
+  opsPerSec: number;
+  rowsPerSec: number;
+};
+
+export type BenchmarkReport = {
+  suite: string;
+  version: string;
+  sqlite: string;
+  platform: string;
+  timestamp: string;
+  results: BenchmarkResult[];
+};
+
+// Nearest-rank percentile of sorted samples
+function percentile(sorted: number[], fraction: number) {
+  if (sorted.length === 0) {
+    return 0;
+  }
+  const rank = Math.ceil(fraction * sorted.length);
+  return sorted[rank === 0 ? 0 : rank - 1];
+}
+
+export class BenchmarkRunner {
+  results: BenchmarkResult[] = [];
+
+  constructor(private filter?: string) {}
+
+  isSelected(name: string) {
+    return !this.filter || name.includes(this.filter);
+  }
+
+  /**
+   * Calls setup, untimed, then run for every iteration
+   */
+  async measure(
+    name: string,
+    iterations: number,
+    rows: number,
+    run: () => unknown | Promise<unknown>,
+    setup?: () => unknown | Promise<unknown>,
+  ) {
+    if (!this.isSelected(name)) {
+      return;
+    }
+
+    const samplesMs: number[] = [];
+    for (let i = 0; i < iterations; i++) {
+      if (setup) {
+        await setup();
+      }
+      const start = performance.now();
+      await run();
+      samplesMs.push(performance.now() - start);
+    }
+    this.add(name, rows, samplesMs);
+  }
+
+  // Samples measured by the case itself, e.g. the latency of every promise of a concurrent run
+  add(name: string, rows: number, samplesMs: number[]) {
+    const sorted = [...samplesMs].sort((a, b) => a - b);
+    const totalMs = sorted.reduce((total, sample) => total + sample, 0);
+    const opsPerSec = totalMs > 0 ? sorted.length / (totalMs / 1000) : 0;
+    this.results.push({
+      name,
+      iterations: sorted.length,
+      rows,
+      totalMs,
+      meanMs: sorted.length > 0 ? totalMs / sorted.length : 0,
+      minMs: sorted[0] ?? 0,
+      p50Ms: percentile(sorted, 0.5),
+      p95Ms: percentile(sorted, 0.95),
+      maxMs: sorted[sorted.length - 1] ?? 0,
+      opsPerSec,
+      rowsPerSec: opsPerSec * rows,
+    });
+  }
+
+  report(sqliteVersion: string): BenchmarkReport {
+    return {
+      suite: 'react-native-quick-sqlite',
+      version: pak.version,
+      sqlite: sqliteVersion,
+      platform: Platform.OS,
+      timestamp: new Date().toISOString(),
+      results: this.results,
+    };
+  }
+}
@@ -0,0 +1,216 @@
+import {
+  open,
+  QuickSQLiteConnection,
+  OpenOptions,
+  ResultFormat,
+} from 'react-native-quick-sqlite';
+import {BenchmarkReport, BenchmarkRunner} from './BenchmarkRunner';
+
+const DB_NAME = 'benchmark';
+const INSERT_USER = 'INSERT INTO User (name, age, networth) VALUES (?, ?, ?)';
+const BLOB_SIZE = 1024 * 1024;
+
+export type BenchmarkOptions = {
+  // Multiplies the rows and iterations of every case, 0.1 gives a quick smoke run
+  scale?: number;
+  // Only cases whose name contains it run
+  filter?: string;
+  // Absolute path of a SQL file pushed to the device, the loadFile case is skipped without it
+  sqlFile?: string;
+};
+
+function userParams(i: number) {
+  return [`user ${i}`, i % 100, i * 1.5];
+}
+
+function openBenchmarkDb(options: OpenOptions = {}) {
+  const db = open({name: DB_NAME, ...options});
+  db.execute('DROP TABLE IF EXISTS User');
+  db.execute(
+    'CREATE TABLE User (id INTEGER PRIMARY KEY, name TEXT NOT NULL, age INTEGER, networth REAL)',
+  );
+  return db;
+}
+
+function closeBenchmarkDb(db: QuickSQLiteConnection) {
+  db.close();
+  db.delete();
+}
+
+function fillUsers(db: QuickSQLiteConnection, rows: number) {
+  const paramSets = [];
+  for (let i = 0; i < rows; i++) {
+    paramSets.push(userParams(i));
+  }
+  db.executeBatch([[INSERT_USER, paramSets]]);
+}
+
+async function benchmarkInserts(runner: BenchmarkRunner, scaled: (count: number) => number) {
+  const db = openBenchmarkDb();
+
+  // Every insert commits on its own, as execute outside of a transaction does
+  let row = 0;
+  await runner.measure('insert.single', scaled(1000), 1, () =>
+    db.execute(INSERT_USER, userParams(row++)),
+  );
+
+  const batchRows = scaled(10000);
+  let paramSets: any[][] = [];
+  const clearUsers = () => {
+    db.execute('DELETE FROM User');
+    paramSets = [];
+    for (let i = 0; i < batchRows; i++) {
+      paramSets.push(userParams(i));
+    }
+  };
+  await runner.measure(
+    'insert.batch.executeBatch',
+    10,
+    batchRows,
+    () => db.executeBatch([[INSERT_USER, paramSets]]),
+    clearUsers,
+  );
+  await runner.measure(
+    'insert.batch.executeBatchAsync',
+    10,
+    batchRows,
+    () => db.executeBatchAsync([[INSERT_USER, paramSets]]),
+    clearUsers,
+  );
+
+  closeBenchmarkDb(db);
+}
+
+async function benchmarkSelects(runner: BenchmarkRunner, scaled: (count: number) => number) {
+  const db = openBenchmarkDb();
+  const sizes = [scaled(10000), scaled(100000)];
+  fillUsers(db, sizes[sizes.length - 1]);
+
+  const formats: ResultFormat[] = ['objects', 'arrays', 'columns', 'lazy'];
+  for (const size of sizes) {
+    const query = `SELECT * FROM User LIMIT ${size}`;
+    for (const resultFormat of formats) {
+      await runner.measure(`select.${size}.${resultFormat}`, 10, size, () =>
+        db.execute(query, [], {resultFormat}),
+      );
+    }
+    await runner.measure(`select.${size}.async.objects`, 10, size, () =>
+      db.executeAsync(query),
+    );
+  }
+
+  closeBenchmarkDb(db);
+}
+
+async function benchmarkBlobs(runner: BenchmarkRunner, scaled: (count: number) => number) {
+  const db = openBenchmarkDb();
+  db.execute('CREATE TABLE Thumbnail (id INTEGER PRIMARY KEY, data BLOB)');
+
+  const bytes = new Uint8Array(BLOB_SIZE);
+  for (let i = 0; i < bytes.length; i++) {
+    bytes[i] = (i * 31) & 0xff;
+  }
+
+  await runner.measure('blob.roundtrip.1mb', scaled(100), 1, () => {
+    db.execute('INSERT OR REPLACE INTO Thumbnail (id, data) VALUES (?, ?)', [
+      1,
+      bytes.buffer,
+    ]);
+    const data = db.execute('SELECT data FROM Thumbnail WHERE id = 1').rows
+      ?._array[0].data;
+    if (data?.byteLength !== BLOB_SIZE) {
+      throw new Error('blob read back with a different size');
+    }
+  });
+
+  closeBenchmarkDb(db);
+}
+
+/**
+ * Promises issued at once, reads served in parallel by reader connections while
+ * writes wait on each other, measured from the call until the promise resolves
+ */
+async function benchmarkAsyncContention(runner: BenchmarkRunner, scaled: (count: number) => number) {
+  const name = 'async.contention.latency';
+  if (!runner.isSelected(name)) {
+    return;
+  }
+
+  const db = openBenchmarkDb({readerConnections: 2});
+  fillUsers(db, scaled(10000));
+
+  const tasks = scaled(2000);
+  const samplesMs = await Promise.all(
+    Array.from({length: tasks}, async (_, i) => {
+      const start = performance.now();
+      if (i % 5 === 0) {
+        await db.executeAsync(INSERT_USER, userParams(i));
+      } else {
+        await db.executeAsync('SELECT * FROM User WHERE age = ? LIMIT 20', [i % 100]);
+      }
+      return performance.now() - start;
+    }),
+  );
+  runner.add(name, 1, samplesMs);
+
+  closeBenchmarkDb(db);
+}
+
+/**
+ * The reads of a screen issued as separate executeAsync promises and as one executeManyAsync
+ */
+async function benchmarkFanOut(runner: BenchmarkRunner, scaled: (count: number) => number) {
+  const db = openBenchmarkDb({readerConnections: 4});
+  fillUsers(db, scaled(10000));
+
+  const query = 'SELECT * FROM User WHERE age = ? LIMIT 50';
+  const queries = Array.from({length: 8}, (_, i) => [query, [i]] as [string, number[]]);
+  // The first run of a query goes through the main connection, later ones can use the readers
+  await Promise.all(queries.map(([sql, params]) => db.executeAsync(sql, params)));
+
+  await runner.measure('fanout.8.executeAsync', scaled(100), 50 * queries.length, () =>
+    Promise.all(queries.map(([sql, params]) => db.executeAsync(sql, params))),
+  );
+  await runner.measure('fanout.8.executeManyAsync', scaled(100), 50 * queries.length, () =>
+    db.executeManyAsync(queries),
+  );
+
+  closeBenchmarkDb(db);
+}
+
+async function benchmarkLoadFile(runner: BenchmarkRunner, sqlFile?: string) {
+  if (!sqlFile || !runner.isSelected('loadFile')) {
+    return;
+  }
+
+  let rows = 0;
+  const samplesMs: number[] = [];
+  // The file can create any schema, every import starts from an empty database
+  for (let i = 0; i < 10; i++) {
+    const db = open({name: DB_NAME});
+    const start = performance.now();
+    rows = db.loadFile(sqlFile).rowsAffected ?? 0;
+    samplesMs.push(performance.now() - start);
+    closeBenchmarkDb(db);
+  }
+  runner.add('loadFile', rows, samplesMs);
+}
+
+export async function runBenchmarks(options: BenchmarkOptions = {}): Promise<BenchmarkReport> {
+  const scale = options.scale ?? 1;
+  const scaled = (count: number) => Math.max(1, Math.floor(count * scale));
+  const runner = new BenchmarkRunner(options.filter);
+
+  await benchmarkInserts(runner, scaled);
+  await benchmarkSelects(runner, scaled);
+  await benchmarkBlobs(runner, scaled);
+  await benchmarkAsyncContention(runner, scaled);
+  await benchmarkFanOut(runner, scaled);
+  await benchmarkLoadFile(runner, options.sqlFile);
+
+  const db = open({name: DB_NAME});
+  const sqliteVersion = db.execute('SELECT sqlite_version() AS version').rows?._array[0].version;
+  closeBenchmarkDb(db);
+
+  return runner.report(sqliteVersion);
+}
@@ -0,0 +1,3 @@
+export { runBenchmarks } from './benchmarks';
+export type { BenchmarkOptions } from './benchmarks';
+export type { BenchmarkReport, BenchmarkResult } from './BenchmarkRunner';
@@ -0,0 +1,18 @@
+-- Loaded by the loadFile tests, import.sql.gz holds the same statements
+CREATE TABLE Fixture (id INTEGER PRIMARY KEY, label TEXT, note TEXT);
+CREATE TABLE FixtureLog (id INTEGER, label TEXT);
+
+CREATE TRIGGER fixture_log AFTER INSERT ON Fixture
+BEGIN
+  INSERT INTO FixtureLog (id, label) VALUES (NEW.id, NEW.label);
+  UPDATE Fixture SET note = 'logged' WHERE id = NEW.id;
+END;
+
+INSERT INTO Fixture (id, label)
+VALUES
+  (1, 'first'),
+  (2, 'semi;colon'),
+  (3, 'it''s; quoted');
+
+-- The named parameter is left unbound, the literal after it must not take its place
+INSERT INTO Fixture (label, id) VALUES ($label, 4);
@@ -1,6 +1,8 @@
 import Chance from 'chance';
 import {
   open,
+  PreparedStatement,
+  QuickSQLite,
   QuickSQLiteConnection,
   SQLBatchTuple,
 } from 'react-native-quick-sqlite';
@@ -11,7 +13,12 @@ let expect = chai.expect;
 const chance = new Chance();
 let db: QuickSQLiteConnection;
 
-export function registerBaseTests() {
+export type BaseTestOptions = {
+  // Absolute path of the fixtures folder on the device, the loadFile tests are skipped without it
+  fixturesPath?: string;
+};
+
+export function registerBaseTests(options: BaseTestOptions = {}) {
   describe('Raw queries', () => {
     let get: (SQL: any, ...args: any[]) => any;
     let all: (SQL: any, ...args: any[]) => any[] | undefined;
@@ -640,12 +647,735 @@ export function registerBaseTests() {
       ]);
     });
 
+    it('Batch execute reuses the statement for every parameter set', () => {
+      const rows = [...Array(100).keys()].map(i => [i, `user${i}`, i, 0.5]);
+      const res = db.executeBatch([
+        ['INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)', rows],
+        ['UPDATE User SET age = age + 1 WHERE id < ?', [10]],
+      ]);
+
+      expect(res.rowsAffected).to.equal(110);
+      expect(res.commandTimings).to.have.length(2);
+      res.commandTimings?.forEach(timing => expect(timing).to.be.at.least(0));
+      expect(db.execute('SELECT SUM(age) as total FROM User').rows?._array[0]?.total).to.equal(4960);
+    });
+
+    it('Cached statements are rebound on reuse', () => {
+      for (let i = 0; i < 5; i++) {
+        db.execute(
+          'INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)',
+          [i, chance.name(), i * 10, chance.floating()],
+        );
+      }
+
+      for (let i = 0; i < 5; i++) {
+        const res = db.execute('SELECT age FROM User WHERE id = ?', [i]);
+        expect(res.rows?._array).to.eql([{age: i * 10}]);
+      }
+    });
+
+    it('Statement cache is flushed on schema changes', () => {
+      db.execute('CREATE TABLE Cached (a INT)');
+      db.execute('INSERT INTO Cached (a) VALUES (1)');
+      expect(db.execute('SELECT * FROM Cached').rows?._array).to.eql([{a: 1}]);
+
+      db.execute('DROP TABLE Cached');
+      db.execute('CREATE TABLE Cached (a INT, b TEXT)');
+      db.execute('INSERT INTO Cached (a, b) VALUES (2, ?)', ['two']);
+      expect(db.execute('SELECT * FROM Cached').rows?._array).to.eql([
+        {a: 2, b: 'two'},
+      ]);
+    });
+
+    it('Prepared statement', async () => {
+      const insert = db.prepare(
+        'INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)',
+      );
+      for (let i = 0; i < 3; i++) {
+        insert.bind([i, chance.name(), i, chance.floating()]);
+        expect(insert.execute().rowsAffected).to.equal(1);
+      }
+      await insert.executeAsync([3, chance.name(), 3, chance.floating()]);
+      insert.finalize();
+
+      const select = db.prepare('SELECT age FROM User WHERE id = ?');
+      expect(select.execute([2]).rows?._array).to.eql([{age: 2}]);
+      const res = await select.executeAsync([3]);
+      expect(res.rows?.item(0)).to.eql({age: 3});
+      select.finalize();
+
+      expect(() => select.execute()).to.throw();
+    });
+
+    it('Prepared statement async calls keep their own params', async () => {
+      const insert = db.prepare(
+        'INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)',
+      );
+      await Promise.all(
+        [...Array(5).keys()].map(i =>
+          insert.executeAsync([i, `user${i}`, i * 10, i]),
+        ),
+      );
+      insert.finalize();
+
+      const select = db.prepare('SELECT name, age FROM User WHERE id = ?');
+      const results = await Promise.all(
+        [...Array(5).keys()].map(i => select.executeAsync([i])),
+      );
+      results.forEach((res, i) => {
+        expect(res.rows?._array).to.eql([{name: `user${i}`, age: i * 10}]);
+      });
+      select.finalize();
+    });
+
+    if (options.fixturesPath) {
+      it('Load SQL files, plain and gzipped', async () => {
+        for (const file of ['import.sql', 'import.sql.gz']) {
+          const fileDb = open({name: 'fixtures'});
+          const res = fileDb.loadFile(`${options.fixturesPath}/${file}`);
+          expect(res.rowsAffected).to.equal(4);
+
+          // The trigger body, the multi-line INSERT and the semicolons in strings all made it through
+          const rows = fileDb.execute('SELECT id, label, note FROM Fixture ORDER BY id').rows?._array;
+          expect(rows).to.eql([
+            {id: 1, label: 'first', note: 'logged'},
+            {id: 2, label: 'semi;colon', note: 'logged'},
+            {id: 3, label: "it's; quoted", note: 'logged'},
+            {id: 4, label: null, note: 'logged'},
+          ]);
+          expect(fileDb.execute('SELECT id FROM FixtureLog').rows?.length).to.equal(4);
+
+          fileDb.close();
+          fileDb.delete();
+        }
+      });
+    }
+
+    it('Array and columnar result formats', async () => {
+      db.execute(
+        'INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?), (?, ?, ?, ?)',
+        [1, 'Ana', 20, 1.5, 2, 'Bob', 30, 2.5],
+      );
+
+      const arrays = db.execute('SELECT id, name FROM User ORDER BY id', [], {
+        resultFormat: 'arrays',
+      });
+      expect(arrays.columns).to.eql(['id', 'name']);
+      expect(arrays.rows?._array).to.eql([
+        [1, 'Ana'],
+        [2, 'Bob'],
+      ]);
+      expect(arrays.rows?.item(1)).to.eql([2, 'Bob']);
+
+      const columns = await db.executeAsync(
+        'SELECT age, name FROM User ORDER BY id',
+        [],
+        {resultFormat: 'columns'},
+      );
+      expect(columns.columns).to.eql(['age', 'name']);
+      expect(columns.columnValues?.[0]).to.be.instanceOf(Float64Array);
+      expect(Array.from(columns.columnValues?.[0] ?? [])).to.eql([20, 30]);
+      expect(columns.columnValues?.[1]).to.eql(['Ana', 'Bob']);
+    });
+
+    it('Lazy result format', async () => {
+      for (let i = 0; i < 10; i++) {
+        db.execute(
+          'INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)',
+          [i, `user${i}`, i, 0.5],
+        );
+      }
+
+      const res = await db.executeAsync(
+        'SELECT id, name FROM User ORDER BY id',
+        [],
+        {resultFormat: 'lazy'},
+      );
+      expect(res.rows?.length).to.equal(10);
+      expect(res.rows?.item(3)).to.eql({id: 3, name: 'user3'});
+      expect(res.rows?._array[9]).to.eql({id: 9, name: 'user9'});
+      expect(res.rows?._array[10]).to.equal(undefined);
+      expect(res.rows?.toArray?.()).to.have.length(10);
+    });
+
+    it('Cursor reads rows in batches', async () => {
+      for (let i = 0; i < 25; i++) {
+        db.execute(
+          'INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)',
+          [i, `user${i}`, i, 0.5],
+        );
+      }
+
+      const cursor = db.openCursor('SELECT id FROM User WHERE age >= ? ORDER BY id', [5]);
+      const ids: number[] = [];
+      let batch = await cursor.next(10);
+      while (true) {
+        expect(batch.rows?._array.length).to.be.at.most(10);
+        batch.rows?._array.forEach(row => ids.push(row.id));
+        if (batch.done) {
+          break;
+        }
+        batch = await cursor.next(10);
+      }
+      cursor.close();
+
+      expect(cursor.done).to.equal(true);
+      expect(ids).to.eql([...Array(20).keys()].map(i => i + 5));
+    });
+
+    it('Reader connections run async reads', async () => {
+      const readerDb = open({name: 'readers', readerConnections: 2});
+      readerDb.execute('DROP TABLE IF EXISTS Item;');
+      readerDb.execute('CREATE TABLE Item (id INT PRIMARY KEY, label TEXT)');
+      for (let i = 0; i < 10; i++) {
+        readerDb.execute('INSERT INTO Item (id, label) VALUES(?, ?)', [i, `item${i}`]);
+      }
+
+      const query = 'SELECT label FROM Item WHERE id = ?';
+      expect(readerDb.execute(query, [0]).rows?._array).to.eql([{label: 'item0'}]);
+      expect(readerDb.execute('PRAGMA journal_mode').rows?._array[0]?.journal_mode).to.equal('wal');
+
+      const results = await Promise.all(
+        [...Array(10).keys()].map(i => readerDb.executeAsync(query, [i])),
+      );
+      results.forEach((res, i) => {
+        expect(res.rows?._array).to.eql([{label: `item${i}`}]);
+      });
+
+      readerDb.close();
+      readerDb.delete();
+    });
+
+    it('Async reads see the transaction and the writes queued before them', async () => {
+      const readerDb = open({name: 'readers', readerConnections: 2});
+      readerDb.execute('DROP TABLE IF EXISTS Item;');
+      readerDb.execute('CREATE TABLE Item (id INT PRIMARY KEY, label TEXT)');
+      const query = 'SELECT label FROM Item ORDER BY id';
+      // Seen once on the writer, later runs may use the readers
+      readerDb.execute(query);
+
+      await readerDb.transaction(async tx => {
+        tx.execute('INSERT INTO Item (id, label) VALUES(1, ?)', ['uncommitted']);
+        const res = await readerDb.executeAsync(query);
+        expect(res.rows?._array).to.eql([{label: 'uncommitted'}]);
+        const [many] = await readerDb.executeManyAsync([[query]]);
+        expect(many.rows?._array).to.eql([{label: 'uncommitted'}]);
+      });
+
+      readerDb.executeAsync('INSERT INTO Item (id, label) VALUES(2, ?)', ['queued']);
+      const afterInsert = await readerDb.executeAsync(query);
+      expect(afterInsert.rows?._array).to.eql([{label: 'uncommitted'}, {label: 'queued'}]);
+
+      const [, afterMany] = await readerDb.executeManyAsync([
+        ['INSERT INTO Item (id, label) VALUES(3, ?)', ['fanned out']],
+        [query],
+      ]);
+      expect(afterMany.rows?.length).to.equal(3);
+
+      readerDb.close();
+      readerDb.delete();
+    });
+
+    it('Async transaction statements stay on the writer', async () => {
+      const readerDb = open({name: 'readers', readerConnections: 2});
+      readerDb.execute('DROP TABLE IF EXISTS Item;');
+      readerDb.execute('CREATE TABLE Item (id INT PRIMARY KEY, label TEXT)');
+      const query = 'SELECT label FROM Item ORDER BY id';
+      readerDb.execute(query);
+
+      // The second run finds BEGIN and COMMIT already seen by the writer
+      for (let run = 0; run < 2; run++) {
+        await readerDb.executeAsync('BEGIN');
+        await readerDb.executeAsync('INSERT INTO Item (id, label) VALUES(?, ?)', [run, `run${run}`]);
+        const res = await readerDb.executeAsync(query);
+        expect(res.rows?._array.map(row => row.label)).to.eql(
+          [...Array(run + 1).keys()].map(i => `run${i}`),
+        );
+        await readerDb.executeAsync('COMMIT');
+      }
+
+      expect(readerDb.execute(query).rows?.length).to.equal(2);
+
+      readerDb.close();
+      readerDb.delete();
+    });
+
+    it('Objects created in a transaction queue on the database after it', async () => {
+      let insert: PreparedStatement | undefined;
+      await db.transaction(async () => {
+        insert = db.prepare('INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)');
+      });
+
+      const inserted = insert!.executeAsync([1, 'After commit', 20, 0]);
+      const res = await db.executeAsync('SELECT name FROM User');
+      await inserted;
+      expect(res.rows?._array).to.eql([{name: 'After commit'}]);
+      insert!.finalize();
+    });
+
+    it('Transaction, queued statements commit together', async () => {
+      await db.transaction(
+        tx => {
+          for (let i = 0; i < 500; i++) {
+            tx.queue(
+              'INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)',
+              [i, `user${i}`, i, 0.5],
+            );
+          }
+        },
+        {mode: 'immediate'},
+      );
+
+      const res = db.execute('SELECT COUNT(*) as count FROM User');
+      expect(res.rows?._array[0]?.count).to.equal(500);
+    });
+
+    it('Transaction, failed queued statement rolls back', async () => {
+      let error: any;
+      try {
+        await db.transaction(tx => {
+          tx.queue('INSERT INTO User (id, name, age, networth) VALUES(1, ?, 1, 0.5)', ['a']);
+          tx.queue('INSERT INTO User (id, name, age, networth) VALUES(1, ?, 1, 0.5)', ['b']);
+        });
+      } catch (e) {
+        error = e;
+      }
+
+      expect(!!error).to.equal(true);
+      const res = db.execute('SELECT * FROM User');
+      expect(res.rows?._array).to.eql([]);
+    });
+
+    it('Transaction, rollback to savepoint', async () => {
+      await db.transaction(async tx => {
+        await tx.executeAsync('INSERT INTO User (id, name, age, networth) VALUES(1, ?, 1, 0.5)', ['kept']);
+        tx.savepoint('second');
+        tx.execute('INSERT INTO User (id, name, age, networth) VALUES(2, ?, 2, 0.5)', ['dropped']);
+        tx.rollbackTo('second');
+        tx.release('second');
+      });
+
+      const res = db.execute('SELECT name FROM User');
+      expect(res.rows?._array).to.eql([{name: 'kept'}]);
+    });
+
+    it('Blobs round trip as ArrayBuffers', async () => {
+      db.execute('CREATE TABLE Thumbnail (id INT PRIMARY KEY, data BLOB)');
+      const bytes = new Uint8Array([...Array(256).keys()]);
+      db.execute('INSERT INTO Thumbnail (id, data) VALUES(?, ?)', [1, bytes.buffer]);
+      await db.executeAsync('INSERT INTO Thumbnail (id, data) VALUES(?, ?)', [2, bytes.buffer]);
+      db.execute('INSERT INTO Thumbnail (id, data) VALUES(?, ?)', [3, new ArrayBuffer(0)]);
+
+      const res = await db.executeAsync('SELECT data FROM Thumbnail ORDER BY id');
+      const blobs = res.rows!._array.map(row => new Uint8Array(row.data));
+      expect(Array.from(blobs[0])).to.eql(Array.from(bytes));
+      expect(Array.from(blobs[1])).to.eql(Array.from(bytes));
+      expect(blobs[2].length).to.equal(0);
+      db.execute('DROP TABLE Thumbnail');
+    });
+
+    it('Backup copies the database while it is in use', async () => {
+      for (let i = 0; i < 200; i++) {
+        db.execute('INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)', [i, `user${i}`, i, 0.5]);
+      }
+      const mainFile = db.execute('PRAGMA database_list').rows?._array[0]?.file;
+      const backupFile = mainFile.replace(/test$/, 'test-backup');
+
+      let progressCalls = 0;
+      const backup = db.backupAsync(backupFile, {
+        pagesPerStep: 1,
+        onProgress: () => {
+          progressCalls++;
+        },
+      });
+      const count = await db.executeAsync('SELECT COUNT(*) as count FROM User');
+      const {totalPages} = await backup;
+
+      expect(count.rows?._array[0]?.count).to.equal(200);
+      expect(totalPages).to.be.greaterThan(1);
+      expect(progressCalls).to.be.greaterThan(0);
+
+      const backupDb = open({name: 'test-backup'});
+      const res = backupDb.execute('SELECT COUNT(*) as count FROM User');
+      expect(res.rows?._array[0]?.count).to.equal(200);
+      backupDb.close();
+      backupDb.delete();
+    });
+
+    it('Bundled database opens in place and attaches', async () => {
+      const source = open({name: 'asset-source'});
+      source.execute('DROP TABLE IF EXISTS Item;');
+      source.execute('CREATE TABLE Item (id INT PRIMARY KEY, label TEXT)');
+      source.execute('INSERT INTO Item (id, label) VALUES(1, ?)', ['bundled']);
+      const assetPath = source.execute('PRAGMA database_list').rows?._array[0]?.file;
+      source.close();
+
+      const asset = open({name: 'asset', assetPath});
+      expect(asset.execute('SELECT label FROM Item').rows?._array).to.eql([{label: 'bundled'}]);
+      expect(() => asset.execute('INSERT INTO Item (id, label) VALUES(2, ?)', ['no'])).to.throw();
+
+      db.attach('asset', 'ref');
+      const res = db.execute('SELECT label FROM ref.Item');
+      expect(res.rows?._array).to.eql([{label: 'bundled'}]);
+      db.detach('ref');
+
+      asset.close();
+      source.delete();
+    });
+
+    it('Open applies the connection settings', async () => {
+      const tunedDb = open({
+        name: 'tuned',
+        journalMode: 'wal',
+        synchronous: 'normal',
+        cacheSize: 500,
+        tempStore: 'memory',
+        busyTimeout: 2500,
+      });
+      const pragma = (name: string) => Object.values(tunedDb.execute(`PRAGMA ${name}`).rows?._array[0] ?? {})[0];
+      expect(pragma('journal_mode')).to.equal('wal');
+      expect(pragma('synchronous')).to.equal(1);
+      expect(pragma('cache_size')).to.equal(500);
+      expect(pragma('temp_store')).to.equal(2);
+      expect(pragma('busy_timeout')).to.equal(2500);
+      tunedDb.close();
+      tunedDb.delete();
+
+      expect(() => open({name: 'tuned', synchronous: 'sometimes' as any})).to.throw();
+      expect(QuickSQLite.getCompileOptions().length).to.be.greaterThan(0);
+    });
+
     it('Function test', async () => {
       db.function('add2', (a: number, b: number) => a + b , {deterministic: true});
       const res = db.execute('SELECT add2(?, ?) as result', [12, 4]);
       expect(res.rows?._array[0]?.result).to.eql(16);
     });
 
+    it('Function called from async queries', async () => {
+      db.function('double', (a: number) => a * 2, {deterministic: true});
+      db.aggregate('total', {start: 0, step: (acc: number, value: number) => acc + value});
+      for (let i = 0; i < 10; i++) {
+        db.execute('INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)', [i, `user${i}`, i, 0.5]);
+      }
+
+      const [doubled, total] = await Promise.all([
+        db.executeAsync('SELECT double(age) as result FROM User ORDER BY id'),
+        db.executeAsync('SELECT total(age) as result FROM User'),
+      ]);
+      // Runs on the JS thread while the async queries may still hold the connection
+      const sync = db.execute('SELECT double(21) as result');
+
+      expect(doubled.rows?._array.map(row => row.result)).to.eql([...Array(10).keys()].map(i => i * 2));
+      expect(total.rows?._array[0]?.result).to.equal(45);
+      expect(sync.rows?._array[0]?.result).to.equal(42);
+    });
+
+    it('Function called from an async query cannot query the same database', async () => {
+      db.function('lookup', () => db.execute('SELECT 1 as one').rows?._array[0]?.one);
+      // On the JS thread the connection is already held by the caller
+      expect(db.execute('SELECT lookup() as result').rows?._array[0]?.result).to.equal(1);
+
+      let error: Error | undefined;
+      try {
+        await db.executeAsync('SELECT lookup() as result');
+      } catch (e: any) {
+        error = e;
+      }
+      expect(error?.message).to.contain('cannot query the same database');
+    });
+
+    it('Batched aggregate receives typed arrays', async () => {
+      let calls = 0;
+      db.aggregate('weighted', {
+        start: () => ({sum: 0, weights: 0}),
+        stepBatch: (acc, rows, values, weights) => {
+          calls++;
+          for (let i = 0; i < rows; i++) {
+            acc.sum += values[i] * weights[i];
+            acc.weights += weights[i];
+          }
+          return acc;
+        },
+        batchSize: 100,
+        result: acc => acc.sum / acc.weights,
+      });
+      db.executeBatch([
+        ['INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)',
+          [...Array(250).keys()].map(i => [i, `user${i}`, i % 2, 2])],
+      ]);
+
+      const res = await db.executeAsync('SELECT weighted(age, networth) as result FROM User');
+      expect(res.rows?._array[0]?.result).to.equal(0.5);
+      expect(calls).to.equal(3);
+    });
+
+    it('Function arguments keep UTF-8 text and 64-bit integers', () => {
+      db.function('echo', (a: any) => a);
+      expect(get("echo('héllo wörld ✓') as r")).to.deep.equal({r: 'héllo wörld ✓'});
+      expect(get('echo(4294967297) as r')).to.deep.equal({r: 4294967297});
+    });
+
+    it('Native aggregates', () => {
+      for (let i = 1; i <= 11; i++) {
+        db.execute('INSERT INTO User (id, name, age, networth) VALUES(?, ?, ?, ?)', [i, `user${i}`, i, i % 3]);
+      }
+      expect(get('median(age) as m, percentile(age, 90) as p, variance(age) as v FROM User')).to.deep.equal({m: 6, p: 10, v: 11});
+      expect(get('weighted_avg(age, networth) as w FROM User').w).to.be.closeTo(6.1667, 0.001);
+      expect(get('histogram(age, 0, 10, 5) as h FROM User')).to.deep.equal({h: '[1,2,2,2,4]'});
+
+      const windowed = db.execute('SELECT median(age) OVER (ORDER BY id ROWS BETWEEN 2 PRECEDING AND CURRENT ROW) as m FROM User ORDER BY id');
+      expect(windowed.rows?._array.map(row => row.m)).to.eql([1, 1.5, 2, 3, 4, 5, 6, 7, 8, 9, 10]);
+    });
+
+    it('Insert with named parameters', async () => {
+      db.execute('INSERT INTO User (id, name, age, networth) VALUES (:id, @name, $age, :networth)', {
+        id: 1,
+        '@name': 'Mike',
+        age: 9007199254740991,
+        ':networth': 10.5,
+      });
+      await db.executeAsync('INSERT INTO User (id, name, age, networth) VALUES (:id, :name, :age, :networth)', {
+        id: 2,
+        name: 'Anna',
+        age: null,
+        networth: 0,
+      });
+
+      const res = db.execute('SELECT * FROM User WHERE name = :name', {name: 'Mike'});
+      expect(res.rows?._array).to.eql([{id: 1, name: 'Mike', age: 9007199254740991, networth: 10.5}]);
+      expect(db.execute('SELECT count(*) AS c FROM User WHERE age IS NULL').rows?._array[0].c).to.equal(1);
+      expect(() => db.execute('SELECT * FROM User WHERE id = :id', {unknown: 1})).to.throw();
+    });
+
+    it('Round trips 64-bit integers as BigInt', () => {
+      db.close();
+      db = open({name: 'test', bigInt: true});
+
+      const id = BigInt('1493933309370146816');
+      db.execute('INSERT INTO User (id, name, age, networth) VALUES (?, ?, ?, ?)', [id, 'Mike', 30, 2.5]);
+      db.execute('INSERT INTO User (id, name, age, networth) VALUES (?, ?, ?, ?)', [-id, 'Anna', 31, 0]);
+
+      const res = db.execute('SELECT id, age FROM User ORDER BY id DESC');
+      expect(res.rows?._array).to.eql([
+        {id, age: 30},
+        {id: -id, age: 31},
+      ]);
+      expect(db.execute('SELECT name FROM User WHERE id = ?', [id]).rows?._array[0].name).to.equal('Mike');
+      expect(() => db.execute('SELECT ?', [BigInt(2) ** BigInt(64)])).to.throw();
+    });
+
+    it('Subscription re-runs after a commit on its tables', async () => {
+      db.execute('CREATE TABLE IF NOT EXISTS Other (x INT)');
+      const calls: any[] = [];
+      const unsubscribe = db.subscribe('SELECT name FROM User ORDER BY id', undefined, undefined, (result, changes) => {
+        calls.push({names: result.rows?._array.map((r: any) => r.name), changes});
+      });
+
+      await new Promise(resolve => setTimeout(resolve, 50));
+      db.execute('INSERT INTO User (id, name, age, networth) VALUES (?, ?, ?, ?)', [1, 'Mike', 30, 1]);
+      await db.executeAsync('INSERT INTO Other (x) VALUES (1)');
+      await new Promise(resolve => setTimeout(resolve, 50));
+      unsubscribe();
+      db.execute('INSERT INTO User (id, name, age, networth) VALUES (?, ?, ?, ?)', [2, 'Anna', 30, 1]);
+      await new Promise(resolve => setTimeout(resolve, 50));
+
+      expect(calls.length).to.equal(2);
+      expect(calls[0]).to.eql({names: [], changes: {}});
+      expect(calls[1].names).to.eql(['Mike']);
+      expect(Object.keys(calls[1].changes)).to.eql(['user']);
+    });
+
+    it('Collects stats per query when profiling', async () => {
+      db.close();
+      db = open({name: 'test', profile: true});
+
+      const insert = 'INSERT INTO User (id, name, age, networth) VALUES (?, ?, ?, ?)';
+      db.execute(insert, [1, 'Mike', 30, 1]);
+      await db.executeAsync(insert, [2, 'Anna', 31, 2]);
+      db.execute('SELECT * FROM User WHERE age > ?', [0]);
+
+      const stats = db.getStats();
+      const insertStats = stats.find(s => s.sql === insert);
+      const selectStats = stats.find(s => s.sql.startsWith('SELECT'));
+      expect(insertStats?.calls).to.equal(2);
+      expect(selectStats?.rows).to.equal(2);
+      expect(selectStats?.fullscanSteps).to.be.greaterThan(0);
+      expect(selectStats?.bytes).to.be.greaterThan(0);
+
+      db.resetStats();
+      expect(db.getStats()).to.eql([]);
+    });
+
+    it('Reports and releases the memory of the connection', () => {
+      db.executeBatch([['INSERT INTO User (id, name, age, networth) VALUES (?, ?, ?, ?)', Array.from({length: 500}, (_, i) => [i, chance.string({length: 200}), i, i])]]);
+      db.execute('SELECT * FROM User');
+
+      const status = db.getDbStatus();
+      expect(status.cacheUsed).to.be.greaterThan(0);
+      expect(status.schemaUsed).to.be.greaterThan(0);
+      expect(QuickSQLite.getMemoryStatus().memoryUsed).to.be.greaterThan(0);
+
+      QuickSQLite.setMemoryLimits({softHeapLimit: 64 * 1024 * 1024});
+      expect(QuickSQLite.getMemoryStatus().softHeapLimit).to.equal(64 * 1024 * 1024);
+      QuickSQLite.setMemoryLimits({softHeapLimit: 0});
+
+      expect(db.releaseMemory()).to.be.at.least(0);
+      expect(db.getDbStatus().cacheUsed).to.be.at.most(status.cacheUsed);
+    });
+
+    it('executeManyAsync resolves every result in order', async () => {
+      const readerDb = open({name: 'fanout', readerConnections: 2});
+      readerDb.execute('DROP TABLE IF EXISTS Item;');
+      readerDb.execute('CREATE TABLE Item (id INT PRIMARY KEY, label TEXT)');
+      for (let i = 0; i < 10; i++) {
+        readerDb.execute('INSERT INTO Item (id, label) VALUES(?, ?)', [i, `item${i}`]);
+      }
+
+      const results = await readerDb.executeManyAsync([
+        ...[...Array(8).keys()].map(i => ['SELECT label FROM Item WHERE id = ?', [i]] as [string, any[]]),
+        ['INSERT INTO Item (id, label) VALUES(?, ?)', [10, 'item10']],
+        ['SELECT id, label FROM Item WHERE id = :id', {id: 9}, {resultFormat: 'arrays'}],
+      ]);
+      expect(results.length).to.equal(10);
+      results.slice(0, 8).forEach((res, i) => {
+        expect(res.rows?._array).to.eql([{label: `item${i}`}]);
+      });
+      expect(results[8].rowsAffected).to.equal(1);
+      expect(results[9].rows?._array).to.eql([[9, 'item9']]);
+      expect(await readerDb.executeManyAsync([])).to.eql([]);
+
+      let error: Error | undefined;
+      try {
+        await readerDb.executeManyAsync([['SELECT label FROM Item'], ['SELECT * FROM Missing']]);
+      } catch (e: any) {
+        error = e;
+      }
+      expect(error?.message).to.contain('no such table');
+
+      readerDb.close();
+      readerDb.delete();
+    });
+
+    it('Background queries run next to interactive ones', async () => {
+      const workers = QuickSQLite.setWorkerThreads(2);
+      expect(workers).to.equal(2);
+
+      const insert = 'INSERT INTO User (id, name, age, networth) VALUES (?, ?, ?, ?)';
+      await Promise.all([
+        db.executeAsync(insert, [1, 'Mike', 30, 1], {priority: 'background'}),
+        db.executeAsync(insert, [2, 'Anna', 31, 2]),
+      ]);
+      const res = await db.executeAsync('SELECT id FROM User ORDER BY id', [], {priority: 'background'});
+      expect(res.rows?._array).to.eql([{id: 1}, {id: 2}]);
+
+      let error: Error | undefined;
+      try {
+        await db.executeAsync('SELECT 1', [], {priority: 'urgent' as any});
+      } catch (e: any) {
+        error = e;
+      }
+      expect(error?.message).to.contain('priority');
+      expect(QuickSQLite.setWorkerThreads(100)).to.equal(16);
+      QuickSQLite.setWorkerThreads(4);
+    });
+
+    it('Cancels, times out and interrupts long queries', async () => {
+      const endless = 'WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c) SELECT count(*) FROM c';
+      const failure = (promise: Promise<any>) => promise.then(() => undefined, (e: Error) => e.message);
+
+      expect(await failure(db.executeAsync(endless, [], {timeout: 50}))).to.contain('timed out');
+
+      const token = QuickSQLite.createCancelToken();
+      const running = failure(db.executeAsync(endless, [], {cancelToken: token}));
+      const queued = failure(db.executeAsync('SELECT 1', [], {cancelToken: token}));
+      setTimeout(() => token.cancel(), 20);
+      expect(await running).to.contain('cancelled');
+      expect(await queued).to.contain('cancelled');
+      expect(token.cancelled).to.equal(true);
+
+      const interrupted = failure(db.executeAsync(endless));
+      setTimeout(() => db.interrupt(), 20);
+      expect(await interrupted).to.contain('interrupted');
+
+      // The connection is usable right after
+      const res = await db.executeAsync('SELECT 1 AS one');
+      expect(res.rows?._array).to.eql([{one: 1}]);
+    });
+
+    it('Returns full-text matches as UTF-16 offsets', () => {
+      const compileOptions = QuickSQLite.getCompileOptions();
+      expect(compileOptions).to.include('ENABLE_FTS5');
+      expect(compileOptions).to.include('ENABLE_RTREE');
+      expect(get(`json_extract('{"a": 2}', '$.a') AS a`).a).to.equal(2);
+      db.execute('CREATE VIRTUAL TABLE Area USING rtree(id, minX, maxX)');
+
+      db.execute('CREATE VIRTUAL TABLE Doc USING fts5(title, body)');
+      db.execute('INSERT INTO Doc VALUES (?, ?)', ['Hello wörld hello', 'say 😀 hello']);
+      const res = db.execute(
+        "SELECT match_offsets(Doc) AS offsets FROM Doc WHERE Doc MATCH 'hello' ORDER BY rank",
+      );
+      const offsets = Array.from(new Int32Array(res.rows?._array[0].offsets));
+      expect(offsets).to.eql([0, 0, 5, 0, 12, 17, 1, 7, 12]);
+      expect('say 😀 hello'.slice(7, 12)).to.equal('hello');
+    });
+
+    it('Reads and writes blobs in ranges', async () => {
+      db.execute('CREATE TABLE File (id INTEGER PRIMARY KEY, data BLOB)');
+      const {insertId} = db.execute('INSERT INTO File (data) VALUES (zeroblob(16))');
+      const blob = db.openBlob('File', 'data', insertId!);
+      expect(blob.size).to.equal(16);
+
+      blob.write(0, new Uint8Array([1, 2, 3, 4]).buffer);
+      await blob.writeAsync(12, new Uint8Array([9, 8, 7, 6, 5]).buffer, 4);
+      const chunk = new ArrayBuffer(8);
+      const read = await blob.readAsync(8, 8, chunk);
+      expect(read).to.equal(chunk);
+      expect(Array.from(new Uint8Array(chunk))).to.eql([0, 0, 0, 0, 9, 8, 7, 6]);
+      expect(Array.from(new Uint8Array(blob.read(0, 4)))).to.eql([1, 2, 3, 4]);
+      expect(() => blob.read(12, 8)).to.throw();
+      blob.close();
+
+      const stored = new Uint8Array(db.execute('SELECT data FROM File').rows?._array[0].data);
+      expect(stored.byteLength).to.equal(16);
+      expect(stored[15]).to.equal(6);
+    });
+
+    it('Syncs changes through a changeset', async () => {
+      const replica = open({name: 'replica'});
+      replica.execute('DROP TABLE IF EXISTS User');
+      replica.execute('CREATE TABLE User ( id INT PRIMARY KEY, name TEXT NOT NULL, age INT, networth REAL) STRICT;');
+      replica.execute('INSERT INTO User (id, name, age, networth) VALUES (2, ?, 20, 0)', ['Theirs']);
+
+      const session = db.createSession({tables: ['User']});
+      expect(session.isEmpty).to.equal(true);
+      db.execute('INSERT INTO User (id, name, age, networth) VALUES (1, ?, 30, 1.5), (2, ?, 40, 2)', ['Mine', 'Ours']);
+      db.execute('UPDATE User SET age = 31 WHERE id = 1');
+      expect(session.isEmpty).to.equal(false);
+      const changeset = await session.changesetAsync();
+      expect(changeset.byteLength).to.be.greaterThan(0);
+      session.close();
+      expect(() => session.changeset()).to.throw();
+
+      const replicaSession = replica.createSession();
+      let error: Error | undefined;
+      await replica.applyChangesetAsync(changeset).catch((e) => (error = e));
+      expect(error).to.be.instanceOf(Error);
+      expect(replica.execute('SELECT * FROM User').rows?.length).to.equal(1);
+
+      const result = await replica.applyChangesetAsync(changeset, {onConflict: 'omit'});
+      expect(result).to.eql({rowsAffected: 1, conflicts: 1});
+      const rows = replica.execute('SELECT id, name, age FROM User ORDER BY id').rows?._array;
+      expect(rows).to.eql([
+        {id: 1, name: 'Mine', age: 31},
+        {id: 2, name: 'Theirs', age: 20},
+      ]);
+      // The applied changes are not recorded, they would be sent back
+      expect(replicaSession.isEmpty).to.equal(true);
+
+      replica.close();
+      replica.delete();
+    });
+
     it('should be able to register multiple functions with the same name', function () {
       db.function('fn', () => 0);
       db.function('fn', (a) => 1);
@@ -5,6 +5,7 @@
 #import <React/RCTUtils.h>
 #import <ReactCommon/RCTTurboModule.h>
 #import <jsi/jsi.h>
+#import <UIKit/UIKit.h>
 
 #import "../cpp/bindings.h"
 
@@ -12,6 +13,26 @@
 
 RCT_EXPORT_MODULE(QuickSQLite)
 
+- (instancetype)init {
+  if (self = [super init]) {
+    // Lets SQLite give back its page cache instead of the app being killed
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(handleMemoryWarning)
+                                                 name:UIApplicationDidReceiveMemoryWarningNotification
+                                               object:nil];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+// iOS only warns once the app is close to being terminated
+- (void)handleMemoryWarning {
+  osp::handleMemoryPressure(true);
+}
+
 
 RCT_EXPORT_BLOCKING_SYNCHRONOUS_METHOD(install) {
   NSLog(@"Installing QuickSQLite module...");
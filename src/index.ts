@@ -63,11 +63,54 @@ export type QueryResult = {
      * @returns the row structure identified by column names
      */
     item: (idx: number) => any;
+    /** Only available for the 'lazy' result format, creates every row object at once */
+    toArray?: () => any[];
   };
   /**
    * Query metadata, avaliable only for select query results
    */
   metadata?: ColumnMetadata[];
+  /** Column names in select order, set for the 'arrays' and 'columns' result formats */
+  columns?: string[];
+  /**
+   * One entry per column with the values of every row, set for the 'columns' result format.
+   * Columns containing only numbers are returned as a Float64Array
+   */
+  columnValues?: Array<Float64Array | any[]>;
+};
+
+/**
+ * objects: every row is an object keyed by column name (default)
+ * arrays: every row is an array of values in the same order as `columns`
+ * columns: no rows are created, `columnValues` holds one array per column
+ * lazy: rows stay in native memory, a row object is only created when it is accessed
+ * through `rows.item(i)` or `rows._array[i]`. `rows.toArray()` materializes all of them
+ */
+export type ResultFormat = 'objects' | 'arrays' | 'columns' | 'lazy';
+
+/**
+ * interactive: queries the user waits for, they run before any queued background work
+ * background: long running work, it never takes the last free native thread
+ */
+export type TaskPriority = 'interactive' | 'background';
+
+/**
+ * Created with QuickSQLite.createCancelToken, one token can be given to many queries
+ */
+export interface CancelToken {
+  /** Rejects the queued queries right away, the running ones stop within milliseconds */
+  cancel: () => void;
+  readonly cancelled: boolean;
+}
+
+export type ExecuteOptions = {
+  resultFormat?: ResultFormat;
+  /** Only used by async queries, defaults to 'interactive' */
+  priority?: TaskPriority;
+  /** Milliseconds after the call the query fails with a timed out error, the time spent queued counts */
+  timeout?: number;
+  /** Only used by async queries, cancelling the token rejects the query */
+  cancelToken?: CancelToken;
 };
 
 /**
@@ -90,7 +133,21 @@ export type ColumnMetadata = {
  * If a single query must be executed many times with different arguments, its preferred
  * to declare it a single time, and use an array of array parameters.
  */
-export type SQLBatchTuple = [string] | [string, Array<any> | Array<Array<any>>];
+/**
+ * Parameters of a query, positional ones are bound to ?, named ones to :name, @name or $name.
+ * The keys of named parameters can be given with or without their prefix
+ */
+export type SQLParams = any[] | Record<string, any>;
+
+export type SQLBatchTuple = [string] | [string, SQLParams | Array<SQLParams>];
+
+/**
+ * A query of executeManyAsync, with its optional parameters and options
+ */
+export type AsyncQuery =
+  | [string]
+  | [string, SQLParams | undefined]
+  | [string, SQLParams | undefined, ExecuteOptions];
 
 /**
  * status: 0 or undefined for correct execution, 1 for error
@@ -99,6 +156,8 @@ export type SQLBatchTuple = [string] | [string, Array<any> | Array<Array<any>>];
  */
 export type BatchQueryResult = {
   rowsAffected?: number;
+  /** Milliseconds spent on each command of the batch, in the order they were passed */
+  commandTimings?: number[];
 };
 
 /**
@@ -109,32 +168,302 @@ export interface FileLoadResult extends BatchQueryResult {
   commands?: number;
 }
 
+/**
+ * Reported by loadFileAsync after every chunk of the file was imported
+ */
+export type FileLoadProgress = {
+  bytesRead: number;
+  totalBytes: number;
+  commands: number;
+};
+
+/**
+ * Reported by backupAsync after every step of the backup
+ */
+export type BackupProgress = {
+  remainingPages: number;
+  totalPages: number;
+};
+
+export type BackupOptions = {
+  /**
+   * Pages copied before other queries get a chance to run, -1 copies everything at once
+   * @default 64
+   */
+  pagesPerStep?: number;
+  onProgress?: (progress: BackupProgress) => void;
+};
+
+export type BackupResult = {
+  totalPages: number;
+};
+
+/**
+ * Rowids changed per table since the previous call, null when a table changed in too many rows to list them.
+ * Empty for the first call
+ */
+export type TableChanges = Record<string, number[] | null>;
+
+/**
+ * Totals of a query since the database was opened or the stats were reset, times are in milliseconds
+ */
+export type QueryStats = {
+  sql: string;
+  calls: number;
+  errors: number;
+  /** Taking the statement from the cache, or compiling it, and binding the parameters */
+  prepareMs: number;
+  /** Running the statement and reading the rows */
+  stepMs: number;
+  /** Converting the rows into JS values */
+  marshalMs: number;
+  /** Async executions waiting for a worker thread */
+  queueWaitMs: number;
+  /** Slowest single prepare and step */
+  maxMs: number;
+  rows: number;
+  bytes: number;
+  /** Rows visited by full table scans, an index might be missing */
+  fullscanSteps: number;
+  sorts: number;
+  /** Rows inserted into automatic indexes, an index is definitely missing */
+  autoindexes: number;
+};
+
+/**
+ * Memory held by the connections of a database in bytes, the cache counters are page counts
+ */
+export type DbStatus = {
+  cacheUsed: number;
+  cacheHit: number;
+  cacheMiss: number;
+  cacheWrite: number;
+  cacheSpill: number;
+  schemaUsed: number;
+  statementUsed: number;
+  lookasideUsed: number;
+};
+
+/**
+ * Memory allocated by SQLite for the whole app, in bytes
+ */
+export type MemoryStatus = {
+  memoryUsed: number;
+  memoryHighwater: number;
+  /** 0 when there is no limit */
+  softHeapLimit: number;
+};
+
+export type MemoryLimits = {
+  /** Caches start freeing pages once SQLite allocated more than this, 0 removes the limit */
+  softHeapLimit?: number;
+  /** Soft heap limit applied when the system reports critical memory pressure, 0 disables it */
+  criticalHeapLimit?: number;
+};
+
+export type TraceEvent = {
+  sql: string;
+  durationMs: number;
+};
+
+export type SubscriptionCallback = (result: QueryResult, changes: TableChanges) => void;
+
+export type SubscriptionOptions = ExecuteOptions & {
+  /** Called instead of the callback when a run of the query fails */
+  onError?: (error: Error) => void;
+};
+
 export interface Transaction {
   commit: () => QueryResult;
-  execute: (query: string, params?: any[]) => QueryResult;
+  execute: (
+    query: string,
+    params?: SQLParams,
+    options?: ExecuteOptions
+  ) => QueryResult;
   executeAsync: (
     query: string,
-    params?: any[] | undefined
+    params?: SQLParams | undefined,
+    options?: ExecuteOptions
   ) => Promise<QueryResult>;
+  /**
+   * Queues a statement without sending its result back to JS,
+   * if it fails the transaction is rolled back and the commit rejects
+   */
+  queue: (query: string, params?: SQLParams) => void;
+  savepoint: (name: string) => void;
+  release: (name: string) => void;
+  rollbackTo: (name: string) => void;
   rollback: () => QueryResult;
 }
 
-export interface PendingTransaction {
-  /*
-   * The start function should not throw or return a promise because the
-   * queue just calls it and does not monitor for failures or completions.
-   *
-   * It should catch any errors and call the resolve or reject of the wrapping
-   * promise when complete.
-   *
-   * It should also automatically commit or rollback the transaction if needed
+/**
+ * deferred (default) waits for the first statement to lock the database,
+ * immediate takes the write lock on BEGIN, exclusive also blocks readers outside of WAL mode
+ */
+export type TransactionOptions = {
+  mode?: 'deferred' | 'immediate' | 'exclusive';
+};
+
+/**
+ * Transaction owning the database natively, its statements run on a worker thread
+ * in the order they were queued, without going back to JS in between
+ */
+interface NativeTransaction extends Transaction {
+  commitAsync: () => Promise<QueryResult>;
+  rollbackAsync: () => Promise<QueryResult>;
+  readonly finalized: boolean;
+}
+
+/**
+ * Connection settings applied natively when a database is opened
+ */
+export type OpenOptions = {
+  /** Number of prepared statements kept per connection, defaults to 32, 0 disables the cache */
+  statementCacheSize?: number;
+  /** Read-only connections used to run async reads in parallel, switches the database to WAL mode */
+  readerConnections?: number;
+  /**
+   * Absolute path of a database shipped with the app, it is opened read-only in place instead of being copied.
+   * Attaching the database by its name attaches the same file
+   */
+  assetPath?: string;
+  /** Bytes of the file accessed through memory mapping, defaults to 256 MiB for assets */
+  mmapSize?: number;
+  /** Must be 'WAL' when readerConnections are used, WAL is then the default */
+  journalMode?: 'delete' | 'truncate' | 'persist' | 'memory' | 'wal' | 'off' | 'DELETE' | 'TRUNCATE' | 'PERSIST' | 'MEMORY' | 'WAL' | 'OFF';
+  synchronous?: 'off' | 'normal' | 'full' | 'extra' | 'OFF' | 'NORMAL' | 'FULL' | 'EXTRA';
+  /** Pages of the page cache when positive, KiB when negative */
+  cacheSize?: number;
+  tempStore?: 'default' | 'file' | 'memory' | 'DEFAULT' | 'FILE' | 'MEMORY';
+  /** Milliseconds to wait for a lock held by another connection before failing with SQLITE_BUSY */
+  busyTimeout?: number;
+  /** Only changes the page size of a new database, or of an existing one after a VACUUM outside of WAL mode */
+  pageSize?: number;
+  /**
+   * INTEGER values beyond Number.MAX_SAFE_INTEGER are returned as BigInt instead of losing precision,
+   * smaller ones are still numbers. BigInt parameters are accepted either way
+   */
+  bigInt?: boolean;
+  /** Collect per query timings and SQLite counters, read them with getStats */
+  profile?: boolean;
+};
+
+/**
+ * Statement compiled once by SQLite, it can be bound and executed many times
+ * without sending the SQL string over again.
+ * Call finalize once it is not needed anymore to release the native resources.
+ */
+export interface PreparedStatement {
+  bind: (params: SQLParams) => void;
+  /** Executes the statement, binding the passed params first if any */
+  execute: (params?: SQLParams, options?: ExecuteOptions) => QueryResult;
+  executeAsync: (
+    params?: SQLParams,
+    options?: ExecuteOptions
+  ) => Promise<QueryResult>;
+  finalize: () => void;
+}
+
+/**
+ * Batch of rows returned by Cursor.next, done is true once the query has no more rows
+ */
+export type CursorBatch = QueryResult & { done: boolean };
+
+/**
+ * Keeps a query open natively and reads its rows in batches on a worker thread.
+ * Wait for a batch before requesting the next one and close the cursor when done with it,
+ * an open cursor keeps a read transaction on the database.
+ */
+export interface Cursor {
+  /** Fetch up to batchSize rows, 100 by default */
+  next: (batchSize?: number) => Promise<CursorBatch>;
+  close: () => void;
+  readonly done: boolean;
+}
+
+export interface BlobOptions {
+  readOnly?: boolean;
+  /** Schema of the table, 'main' or the alias of an attached database */
+  database?: string;
+}
+
+/**
+ * Reads and writes one blob in ranges, without loading the whole value.
+ * Writes can't change the size of the blob, create the row with zeroblob(size) first.
+ * writeAsync copies its buffer when called, readAsync fills the given buffer when its promise resolves.
+ * Close the blob when done with it, an open blob keeps the connection busy.
+ */
+export interface IncrementalBlob {
+  readonly size: number;
+  /** Reads into buffer when given, otherwise into a new ArrayBuffer of length bytes */
+  read: (offset: number, length: number, buffer?: ArrayBuffer) => ArrayBuffer;
+  readAsync: (
+    offset: number,
+    length: number,
+    buffer?: ArrayBuffer
+  ) => Promise<ArrayBuffer>;
+  /** Writes length bytes of buffer, all of it by default */
+  write: (offset: number, buffer: ArrayBuffer, length?: number) => void;
+  writeAsync: (
+    offset: number,
+    buffer: ArrayBuffer,
+    length?: number
+  ) => Promise<void>;
+  /** Points the blob to the same column of another row, wait for the pending reads and writes first */
+  reopen: (rowId: number) => void;
+  close: () => void;
+}
+
+export interface SessionOptions {
+  /** Tables to record, every table by default. Only tables with a PRIMARY KEY are recorded */
+  tables?: string[];
+  /** Schema of the tables, 'main' or the alias of an attached database */
+  database?: string;
+}
+
+/**
+ * Records the rows changed through the connection, read back as a binary changeset
+ * that applyChangesetAsync applies to another database.
+ * Close the session when done with it, it slows down every write while it is open.
+ */
+export interface Session {
+  readonly isEmpty: boolean;
+  /** The net change of every row since the session was created, a row changed many times appears once */
+  changeset: () => ArrayBuffer;
+  changesetAsync: () => Promise<ArrayBuffer>;
+  close: () => void;
+}
+
+export interface ApplyChangesetOptions {
+  /**
+   * What to do with a change conflicting with the database, like an update of a row that was changed too.
+   * 'abort' rolls the whole changeset back, 'omit' skips the change,
+   * 'replace' overwrites the row and skips the changes of missing rows. Defaults to 'abort'
    */
-  start: () => void;
+  onConflict?: 'abort' | 'omit' | 'replace';
 }
 
+export type ApplyChangesetResult = {
+  rowsAffected: number;
+  /** Changes that conflicted, they were omitted or replaced */
+  conflicts: number;
+};
+
 interface ISQLite {
-  open: (dbName: string, location?: string) => void;
+  open: (dbName: string, location?: string, options?: OpenOptions) => void;
   close: (dbName: string) => void;
+  /** Compile-time options of the SQLite build, including the flags passed through SQLITE_FLAGS */
+  getCompileOptions: () => string[];
+  getMemoryStatus: (options?: { resetHighwater?: boolean }) => MemoryStatus;
+  /** Frees the unused cache pages of a database, or of every open one, returns the bytes freed */
+  releaseMemory: (dbName?: string) => number;
+  setMemoryLimits: (limits: MemoryLimits) => void;
+  /** Native threads shared by every database, defaults to 4 or the number of cores if lower. Returns the count applied */
+  setWorkerThreads: (count: number) => number;
+  createCancelToken: () => CancelToken;
+  /** Stops the statements running on the database, they fail with an interrupted error. Queued queries still run */
+  interrupt: (dbName: string) => void;
+  getDbStatus: (dbName: string, options?: { resetCounters?: boolean }) => DbStatus;
   delete: (dbName: string, location?: string) => void;
   attach: (
     mainDbName: string,
@@ -145,21 +474,82 @@ interface ISQLite {
   detach: (mainDbName: string, alias: string) => void;
   transaction: (
     dbName: string,
-    fn: (tx: Transaction) => Promise<void> | void
+    fn: (tx: Transaction) => Promise<void> | void,
+    options?: TransactionOptions
   ) => Promise<void>;
-  execute: (dbName: string, query: string, params?: any[]) => QueryResult;
+  beginTransaction: (
+    dbName: string,
+    options?: TransactionOptions
+  ) => Promise<NativeTransaction>;
+  execute: (
+    dbName: string,
+    query: string,
+    params?: SQLParams,
+    options?: ExecuteOptions
+  ) => QueryResult;
   executeAsync: (
     dbName: string,
     query: string,
-    params?: any[]
+    params?: SQLParams,
+    options?: ExecuteOptions
   ) => Promise<QueryResult>;
+  /**
+   * Runs independent queries at once and resolves with their results in the same order.
+   * Reads run in parallel on the reader connections, writes one after the other on the main connection.
+   * Rejects with the error of the first failed query, the other queries still ran
+   */
+  executeManyAsync: (
+    dbName: string,
+    queries: AsyncQuery[]
+  ) => Promise<QueryResult[]>;
+  prepare: (dbName: string, query: string) => PreparedStatement;
+  openCursor: (
+    dbName: string,
+    query: string,
+    params?: SQLParams,
+    options?: ExecuteOptions
+  ) => Cursor;
+  openBlob: (
+    dbName: string,
+    table: string,
+    column: string,
+    rowId: number,
+    options?: BlobOptions
+  ) => IncrementalBlob;
+  createSession: (dbName: string, options?: SessionOptions) => Session;
   executeBatch: (dbName: string, commands: SQLBatchTuple[]) => BatchQueryResult;
   executeBatchAsync: (
     dbName: string,
     commands: SQLBatchTuple[]
   ) => Promise<BatchQueryResult>;
+  /** Applies a changeset in a savepoint, the open sessions of the database don't record it */
+  applyChangesetAsync: (
+    dbName: string,
+    changeset: ArrayBuffer,
+    options?: ApplyChangesetOptions
+  ) => Promise<ApplyChangesetResult>;
   loadFile: (dbName: string, location: string) => FileLoadResult;
-  loadFileAsync: (dbName: string, location: string) => Promise<FileLoadResult>;
+  loadFileAsync: (
+    dbName: string,
+    location: string,
+    onProgress?: (progress: FileLoadProgress) => void
+  ) => Promise<FileLoadResult>;
+  backupAsync: (
+    dbName: string,
+    destinationPath: string,
+    options?: BackupOptions
+  ) => Promise<BackupResult>;
+  getStats: (dbName: string) => QueryStats[];
+  resetStats: (dbName: string) => void;
+  trace: (dbName: string, callback: ((events: TraceEvent[]) => void) | null) => void;
+  subscribe: (
+    dbName: string,
+    query: string,
+    params: SQLParams | undefined,
+    tables: string[] | undefined,
+    callback: SubscriptionCallback,
+    options?: SubscriptionOptions
+  ) => () => void;
   function: (
     dbName: string,
     name: string,
@@ -185,19 +575,20 @@ interface ISQLite {
       step: (...args: any[]) => void,
       start?: (...args: any[]) => void,
       inverse?: (...args: any[]) => void,
-      result?: (...args: any[]) => any
+      result?: (...args: any[]) => any,
+      batchSize?: number
       ) => void;
 }
 
-const locks: Record<
-  string,
-  { queue: PendingTransaction[]; inProgress: boolean }
-> = {};
-
 // Enhance some host functions
 
 // Add 'item' function to result object to allow the sqlite-storage typeorm driver to work
 const enhanceQueryResult = (result: QueryResult): void => {
+  // Columnar results do not carry rows, lazy rows already come with an 'item' function
+  if (result.columnValues != null || typeof result.rows?.item === 'function') {
+    return;
+  }
+
   // Add 'item' function to result object to allow the sqlite-storage typeorm driver to work
   if (result.rows == null) {
     result.rows = {
@@ -227,28 +618,22 @@ const getFunctionOption = (options, key, required, defaultValue = null): () => a
 };
 
 const _open = QuickSQLite.open;
-QuickSQLite.open = (dbName: string, location?: string) => {
-  _open(dbName, location);
-
-  locks[dbName] = {
-    queue: [],
-    inProgress: false,
-  };
-};
-
-const _close = QuickSQLite.close;
-QuickSQLite.close = (dbName: string) => {
-  _close(dbName);
-  delete locks[dbName];
+QuickSQLite.open = (
+  dbName: string,
+  location?: string,
+  options?: OpenOptions
+) => {
+  _open(dbName, location, options);
 };
 
 const _execute = QuickSQLite.execute;
 QuickSQLite.execute = (
   dbName: string,
   query: string,
-  params?: any[] | undefined
+  params?: SQLParams | undefined,
+  options?: ExecuteOptions
 ): QueryResult => {
-  const result = _execute(dbName, query, params);
+  const result = _execute(dbName, query, params, options);
   enhanceQueryResult(result);
   return result;
 };
@@ -257,123 +642,111 @@ const _executeAsync = QuickSQLite.executeAsync;
 QuickSQLite.executeAsync = async (
   dbName: string,
   query: string,
-  params?: any[] | undefined
+  params?: SQLParams | undefined,
+  options?: ExecuteOptions
 ): Promise<QueryResult> => {
-  const res = await _executeAsync(dbName, query, params);
+  const res = await _executeAsync(dbName, query, params, options);
   enhanceQueryResult(res);
   return res;
 };
 
-QuickSQLite.transaction = async (
+const _executeManyAsync = QuickSQLite.executeManyAsync;
+QuickSQLite.executeManyAsync = async (
   dbName: string,
-  fn: (tx: Transaction) => Promise<void>
-): Promise<void> => {
-  if (!locks[dbName]) {
-    throw Error(`Quick SQLite Error: No lock found on db: ${dbName}`);
-  }
+  queries: AsyncQuery[]
+): Promise<QueryResult[]> => {
+  const results = await _executeManyAsync(dbName, queries);
+  results.forEach(enhanceQueryResult);
+  return results;
+};
 
-  let isFinalized = false;
+const _prepare = QuickSQLite.prepare;
+QuickSQLite.prepare = (dbName: string, query: string): PreparedStatement => {
+  const statement = _prepare(dbName, query);
 
-  // Local transaction context object implementation
-  const execute = (query: string, params?: any[]): QueryResult => {
-    if (isFinalized) {
-      throw Error(
-        `Quick SQLite Error: Cannot execute query on finalized transaction: ${dbName}`
-      );
-    }
-    return QuickSQLite.execute(dbName, query, params);
+  return {
+    bind: (params: SQLParams) => statement.bind(params),
+    execute: (params?: SQLParams, options?: ExecuteOptions) => {
+      const result = statement.execute(params, options);
+      enhanceQueryResult(result);
+      return result;
+    },
+    executeAsync: async (params?: SQLParams, options?: ExecuteOptions) => {
+      const result = await statement.executeAsync(params, options);
+      enhanceQueryResult(result);
+      return result;
+    },
+    finalize: () => statement.finalize(),
   };
+};
 
-  const executeAsync = (query: string, params?: any[] | undefined) => {
-    if (isFinalized) {
-      throw Error(
-        `Quick SQLite Error: Cannot execute query on finalized transaction: ${dbName}`
-      );
-    }
-    return QuickSQLite.executeAsync(dbName, query, params);
+const _openCursor = QuickSQLite.openCursor;
+QuickSQLite.openCursor = (
+  dbName: string,
+  query: string,
+  params?: SQLParams,
+  options?: ExecuteOptions
+): Cursor => {
+  const cursor = _openCursor(dbName, query, params, options);
+
+  return {
+    next: async (batchSize?: number) => {
+      const batch = await cursor.next(batchSize);
+      enhanceQueryResult(batch);
+      return batch;
+    },
+    close: () => cursor.close(),
+    get done() {
+      return cursor.done;
+    },
   };
+};
 
-  const commit = () => {
-    if (isFinalized) {
-      throw Error(
-        `Quick SQLite Error: Cannot execute commit on finalized transaction: ${dbName}`
-      );
-    }
-    const result = QuickSQLite.execute(dbName, 'COMMIT');
-    isFinalized = true;
+QuickSQLite.transaction = async (
+  dbName: string,
+  fn: (tx: Transaction) => Promise<void> | void,
+  options?: TransactionOptions
+): Promise<void> => {
+  // Resolves once the transaction owns the database, the other transactions wait natively
+  const tx = await QuickSQLite.beginTransaction(dbName, options);
+
+  const execute = (query: string, params?: SQLParams, executeOptions?: ExecuteOptions) => {
+    const result = tx.execute(query, params, executeOptions);
+    enhanceQueryResult(result);
     return result;
   };
 
-  const rollback = () => {
-    if (isFinalized) {
-      throw Error(
-        `Quick SQLite Error: Cannot execute rollback on finalized transaction: ${dbName}`
-      );
-    }
-    const result = QuickSQLite.execute(dbName, 'ROLLBACK');
-    isFinalized = true;
+  const executeAsync = async (
+    query: string,
+    params?: SQLParams | undefined,
+    executeOptions?: ExecuteOptions
+  ) => {
+    const result = await tx.executeAsync(query, params, executeOptions);
+    enhanceQueryResult(result);
     return result;
   };
 
-  async function run() {
-    try {
-      await QuickSQLite.executeAsync(dbName, 'BEGIN TRANSACTION');
-
-      await fn({
-        commit,
-        execute,
-        executeAsync,
-        rollback,
-      });
-
-      if (!isFinalized) {
-        commit();
-      }
-    } catch (executionError) {
-      if (!isFinalized) {
-        try {
-          rollback();
-        } catch (rollbackError) {
-          throw rollbackError;
-        }
-      }
+  try {
+    await fn({
+      commit: () => tx.commit(),
+      execute,
+      executeAsync,
+      queue: (query: string, params?: SQLParams) => tx.queue(query, params),
+      savepoint: (name: string) => tx.savepoint(name),
+      release: (name: string) => tx.release(name),
+      rollbackTo: (name: string) => tx.rollbackTo(name),
+      rollback: () => tx.rollback(),
+    });
 
-      throw executionError;
-    } finally {
-      locks[dbName].inProgress = false;
-      isFinalized = false;
-      startNextTransaction(dbName);
+    if (!tx.finalized) {
+      await tx.commitAsync();
+    }
+  } catch (executionError) {
+    if (!tx.finalized) {
+      await tx.rollbackAsync();
     }
-  }
-
-  return await new Promise((resolve, reject) => {
-    const tx: PendingTransaction = {
-      start: () => {
-        run().then(resolve).catch(reject);
-      },
-    };
-
-    locks[dbName].queue.push(tx);
-    startNextTransaction(dbName);
-  });
-};
-
-const startNextTransaction = (dbName: string) => {
-  if (!locks[dbName]) {
-    throw Error(`Lock not found for db: ${dbName}`);
-  }
-
-  if (locks[dbName].inProgress) {
-    // Transaction is already in process bail out
-    return;
-  }
 
-  if (locks[dbName].queue.length) {
-    locks[dbName].inProgress = true;
-    const tx = locks[dbName].queue.shift();
-    setImmediate(() => {
-      tx.start();
-    });
+    throw executionError;
   }
 };
 
@@ -403,7 +776,7 @@ export const typeORMDriver = {
       const connection = {
         executeSql: async (
           sql: string,
-          params: any[] | undefined,
+          params: SQLParams | undefined,
           ok: (res: QueryResult) => void,
           fail: (msg: string) => void
         ) => {
@@ -465,32 +838,100 @@ export type FunctionOptions = {
   subtype?: boolean,
 };
 
+export type AggregateOptions = {
+  start?: any,
+  step?: (...args: any[]) => any,
+  /**
+   * Replaces step, receives the arguments of up to batchSize rows at once as one Float64Array per argument.
+   * Arguments are converted to numbers the way SQLite casts them to REAL, NULL becomes NaN
+   */
+  stepBatch?: (accumulator: any, rows: number, ...columns: Float64Array[]) => any,
+  /** Rows buffered natively before stepBatch is called, defaults to 1024 */
+  batchSize?: number,
+  result?: (...args: any[]) => any,
+  inverse?: (...args: any[]) => any,
+};
+
 export type QuickSQLiteConnection = {
   close: () => void;
   delete: () => void;
   attach: (dbNameToAttach: string, alias: string, location?: string) => void;
   detach: (alias: string) => void;
-  transaction: (fn: (tx: Transaction) => Promise<void> | void) => Promise<void>;
-  execute: (query: string, params?: any[]) => QueryResult;
-  executeAsync: (query: string, params?: any[]) => Promise<QueryResult>;
+  transaction: (
+    fn: (tx: Transaction) => Promise<void> | void,
+    options?: TransactionOptions
+  ) => Promise<void>;
+  execute: (
+    query: string,
+    params?: SQLParams,
+    options?: ExecuteOptions
+  ) => QueryResult;
+  executeAsync: (
+    query: string,
+    params?: SQLParams,
+    options?: ExecuteOptions
+  ) => Promise<QueryResult>;
+  executeManyAsync: (queries: AsyncQuery[]) => Promise<QueryResult[]>;
+  prepare: (query: string) => PreparedStatement;
+  openCursor: (
+    query: string,
+    params?: SQLParams,
+    options?: ExecuteOptions
+  ) => Cursor;
+  openBlob: (
+    table: string,
+    column: string,
+    rowId: number,
+    options?: BlobOptions
+  ) => IncrementalBlob;
+  createSession: (options?: SessionOptions) => Session;
   executeBatch: (commands: SQLBatchTuple[]) => BatchQueryResult;
   executeBatchAsync: (commands: SQLBatchTuple[]) => Promise<BatchQueryResult>;
+  applyChangesetAsync: (
+    changeset: ArrayBuffer,
+    options?: ApplyChangesetOptions
+  ) => Promise<ApplyChangesetResult>;
   loadFile: (location: string) => FileLoadResult;
-  loadFileAsync: (location: string) => Promise<FileLoadResult>;
+  loadFileAsync: (
+    location: string,
+    onProgress?: (progress: FileLoadProgress) => void
+  ) => Promise<FileLoadResult>;
+  backupAsync: (
+    destinationPath: string,
+    options?: BackupOptions
+  ) => Promise<BackupResult>;
+  getDbStatus: (options?: { resetCounters?: boolean }) => DbStatus;
+  releaseMemory: () => number;
+  /** Stops the statements running on the database, they fail with an interrupted error. Queued queries still run */
+  interrupt: () => void;
+  /** Stats of every query run since open or the last reset, slowest first. Needs the profile open option */
+  getStats: () => QueryStats[];
+  resetStats: () => void;
+  /** Receives the statements run on the database with their duration in batches, null stops tracing */
+  trace: (callback: ((events: TraceEvent[]) => void) | null) => void;
+  /**
+   * Runs the query now and again after every commit that changed one of the tables, returns the unsubscribe function.
+   * The tables the query reads are used when none are given
+   */
+  subscribe: (
+    query: string,
+    params: SQLParams | undefined,
+    tables: string[] | undefined,
+    callback: SubscriptionCallback,
+    options?: SubscriptionOptions
+  ) => () => void;
   function: (name: string, fn: (...args: any[]) => void, options?: FunctionOptions) => void;
-  aggregate: (name: string, aggregateOptions: {
-    start?: any,
-    step: (...args: any[]) => any,
-    result?: (...args: any[]) => any,
-    inverse?: (...args: any[]) => any,
-  }, options?: FunctionOptions) => void;
+  aggregate: (name: string, aggregateOptions: AggregateOptions, options?: FunctionOptions) => void;
 };
 
-export const open = (options: {
-  name: string;
-  location?: string;
-}): QuickSQLiteConnection => {
-  QuickSQLite.open(options.name, options.location);
+export const open = (
+  options: {
+    name: string;
+    location?: string;
+  } & OpenOptions
+): QuickSQLiteConnection => {
+  const { name, location, ...openOptions } = options;
+  QuickSQLite.open(name, location, openOptions);
 
   return {
     close: () => QuickSQLite.close(options.name),
@@ -498,23 +939,69 @@ export const open = (options: {
     attach: (dbNameToAttach: string, alias: string, location?: string) =>
       QuickSQLite.attach(options.name, dbNameToAttach, alias, location),
     detach: (alias: string) => QuickSQLite.detach(options.name, alias),
-    transaction: (fn: (tx: Transaction) => Promise<void> | void) =>
-      QuickSQLite.transaction(options.name, fn),
-    execute: (query: string, params?: any[] | undefined): QueryResult =>
-      QuickSQLite.execute(options.name, query, params),
+    transaction: (
+      fn: (tx: Transaction) => Promise<void> | void,
+      transactionOptions?: TransactionOptions
+    ) => QuickSQLite.transaction(options.name, fn, transactionOptions),
+    execute: (
+      query: string,
+      params?: SQLParams | undefined,
+      executeOptions?: ExecuteOptions
+    ): QueryResult =>
+      QuickSQLite.execute(options.name, query, params, executeOptions),
     executeAsync: (
       query: string,
-      params?: any[] | undefined
+      params?: SQLParams | undefined,
+      executeOptions?: ExecuteOptions
     ): Promise<QueryResult> =>
-      QuickSQLite.executeAsync(options.name, query, params),
+      QuickSQLite.executeAsync(options.name, query, params, executeOptions),
+    executeManyAsync: (queries: AsyncQuery[]): Promise<QueryResult[]> =>
+      QuickSQLite.executeManyAsync(options.name, queries),
+    prepare: (query: string) => QuickSQLite.prepare(options.name, query),
+    openCursor: (
+      query: string,
+      params?: SQLParams,
+      executeOptions?: ExecuteOptions
+    ) => QuickSQLite.openCursor(options.name, query, params, executeOptions),
+    openBlob: (
+      table: string,
+      column: string,
+      rowId: number,
+      blobOptions?: BlobOptions
+    ) => QuickSQLite.openBlob(options.name, table, column, rowId, blobOptions),
+    createSession: (sessionOptions?: SessionOptions) =>
+      QuickSQLite.createSession(options.name, sessionOptions),
     executeBatch: (commands: SQLBatchTuple[]) =>
       QuickSQLite.executeBatch(options.name, commands),
     executeBatchAsync: (commands: SQLBatchTuple[]) =>
       QuickSQLite.executeBatchAsync(options.name, commands),
+    applyChangesetAsync: (
+      changeset: ArrayBuffer,
+      applyOptions?: ApplyChangesetOptions
+    ) => QuickSQLite.applyChangesetAsync(options.name, changeset, applyOptions),
     loadFile: (location: string) =>
       QuickSQLite.loadFile(options.name, location),
-    loadFileAsync: (location: string) =>
-      QuickSQLite.loadFileAsync(options.name, location),
+    loadFileAsync: (
+      location: string,
+      onProgress?: (progress: FileLoadProgress) => void
+    ) => QuickSQLite.loadFileAsync(options.name, location, onProgress),
+    backupAsync: (destinationPath: string, backupOptions?: BackupOptions) =>
+      QuickSQLite.backupAsync(options.name, destinationPath, backupOptions),
+    getDbStatus: (statusOptions?: { resetCounters?: boolean }) =>
+      QuickSQLite.getDbStatus(options.name, statusOptions),
+    releaseMemory: () => QuickSQLite.releaseMemory(options.name),
+    interrupt: () => QuickSQLite.interrupt(options.name),
+    getStats: () => QuickSQLite.getStats(options.name),
+    resetStats: () => QuickSQLite.resetStats(options.name),
+    trace: (callback: ((events: TraceEvent[]) => void) | null) =>
+      QuickSQLite.trace(options.name, callback),
+    subscribe: (
+      query: string,
+      params: SQLParams | undefined,
+      tables: string[] | undefined,
+      callback: SubscriptionCallback,
+      subscriptionOptions?: SubscriptionOptions
+    ) => QuickSQLite.subscribe(options.name, query, params, tables, callback, subscriptionOptions),
     function: (name: string, fn: (...args: any[]) => any, fnOptions?: FunctionOptions) => {
       QuickSQLite.function(
         options.name,
@@ -528,9 +1015,14 @@ export const open = (options: {
         );
       },
     aggregate: (name: string, aggregateOptions, fnOptions?: FunctionOptions) => {
+      const isBatched = typeof aggregateOptions.stepBatch === 'function';
       let argCount;
-      argCount = Math.max(getLength(aggregateOptions.step), aggregateOptions.inverse ? getLength(aggregateOptions.inverse) : 0);
-      if (argCount > 0) argCount -= 1;
+      if (isBatched) {
+        argCount = Math.max(getLength(aggregateOptions.stepBatch) - 2, aggregateOptions.inverse ? getLength(aggregateOptions.inverse) - 1 : 0, 0);
+      } else {
+        argCount = Math.max(getLength(aggregateOptions.step), aggregateOptions.inverse ? getLength(aggregateOptions.inverse) : 0);
+        if (argCount > 0) argCount -= 1;
+      }
       if (argCount > 100) throw new RangeError('User-defined functions cannot have more than 100 arguments');
 
       QuickSQLite.aggregate(
@@ -544,10 +1036,11 @@ export const open = (options: {
         typeof aggregateOptions.start === 'function',
         typeof aggregateOptions.inverse === 'function',
         typeof aggregateOptions.result === 'function',
-        getFunctionOption (aggregateOptions, 'step', true),
+        getFunctionOption (aggregateOptions, isBatched ? 'stepBatch' : 'step', true),
         getFunctionOption (aggregateOptions, 'start', false, () => aggregateOptions?.start ?? null),
         getFunctionOption (aggregateOptions, 'inverse', false, () => undefined),
         getFunctionOption (aggregateOptions, 'result', false, result => result ),
+        isBatched ? aggregateOptions.batchSize ?? 1024 : 0,
         )
       }
   };